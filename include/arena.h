@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* =========================================================
+ * Arena (alocador sequencial)
+ *   - Alocar é só avançar um ponteiro dentro do bloco atual;
+ *     blocos novos dobram de tamanho até ARENA_MAX_BLOCK;
+ *   - Não há free individual: tudo é liberado de uma vez
+ *     (arena_free);
+ *   - Não é thread-safe: cada análise usa a sua.
+ * ========================================================= */
+
+#define ARENA_FIRST_BLOCK (16 * 1024)
+#define ARENA_MAX_BLOCK   (1024 * 1024)
+
+typedef struct Arena Arena;
+
+Arena *arena_new(void);
+
+/* `size` bytes alinhados a 8 (nunca devolve NULL) */
+void *arena_alloc(Arena *arena, size_t size);
+
+/* Descarta tudo o que foi alocado, mas guarda o bloco maior para
+ * reaproveitar (ex.: uma arena temporária por instrução) */
+void arena_reset(Arena *arena);
+
+/* Libera todos os blocos de uma vez */
+void arena_free(Arena *arena);
+
+#endif /* ARENA_H */
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
   TY_INVALID = 0,
@@ -60,34 +61,74 @@ typedef enum {
 
 typedef struct Node Node;
 
+/* Todos os campos `name` são nomes internados (intern.h): comparar por ponteiro */
+/* Vínculo de uma variável, preenchido pela resolução de nomes (resolve.h):
+ * índice denso da declaração na sua unidade (a função, parâmetros
+ * primeiro, ou o código global) */
+#define VAR_UNRESOLVED (-1)
+#define VAR_GLOBAL     0x01  /* slot da unidade global */
+#define VAR_UNDECLARED 0x02  /* nome sem declaração (vínculo implícito no escopo do uso) */
+#define VAR_SHADOWS    0x04  /* declaração que esconde outra visível */
+#define VAR_REDECLARED 0x08  /* já declarada no mesmo escopo: aponta para a primeira */
+
+typedef struct {
+  int32_t slot;     /* VAR_UNRESOLVED antes da resolução */
+  uint8_t flags;    /* VAR_* */
+} VarRef;
+
+/* Chamada resolvida (resolve.h): índice da função chamada no registro de
+ * funções do programa (as de nível superior primeiro, na ordem do fonte) */
+#define FN_UNRESOLVED (-1)
+
+/* Node.flags */
+#define NODE_ARENA  0x01  /* alocado numa arena: ast_free não libera */
+#define NODE_SHARED 0x02  /* compartilhado por hash-consing (ast_hashcons.h): imutável */
+
 struct Node {
   NodeKind kind;
+  unsigned char flags;
+  unsigned char type;   /* TypeTag da expressão, anotado pela análise semântica
+                           (TY_INVALID antes dela e em nós compartilhados) */
 
   union {
     struct { long value; } as_int;
     struct { double value ;} as_float;
     struct { bool value; } as_bool;
-    struct { char *name; } as_ident;
-    struct { char *value; } as_string;
+    struct { const char *name; VarRef ref; } as_ident;
+    struct { uint32_t id; const char *value; size_t len; } as_string; /* value: texto do pool */
     struct { UnOp op; Node *expr; } as_unary;
     struct { BinOp op; Node *left; Node *right; } as_binary;
     struct { Node **stmts; size_t count; size_t capacity; } as_block;
-    struct { char *name; Node *value; } as_assign;
+    struct { const char *name; Node *value; VarRef ref; } as_assign;
     struct { Node *expr; } as_expr;
     struct { Node *cond; Node *then_branch; Node *else_branch; } as_if;
-    struct { TypeTag type; char *name; Node *init; } as_decl;
+    struct { TypeTag type; const char *name; Node *init; VarRef ref; } as_decl;
     struct { Node *cond; Node *body; } as_while;
     struct { Node *init; Node *cond; Node *step; Node *body; } as_for;
-    struct { TypeTag ret_type; char *name; struct Node **params; size_t param_count; struct Node *body; } as_function;
+    struct { TypeTag ret_type; const char *name; struct Node **params; size_t param_count; struct Node *body; } as_function;
     struct { Node *expr; } as_return;
-    struct { char *name; struct Node **args; size_t arg_count; } as_call;
+    struct { const char *name; struct Node **args; size_t arg_count; int32_t fn_index; } as_call;
   } u;
 };
 
 /* Helper Functions */
 void *xmalloc(size_t size);
 char *xstrdup(const char *s);
+char *xstrndup(const char *s, size_t n);
 struct Node *new_node(NodeKind kind);
+
+/* Arena da AST (arena.h)
+ *   Nós e arrays de filhos (blocos, parâmetros, argumentos) vêm da arena
+ *   corrente da thread; sem arena, de xmalloc, e ast_free libera nó a nó.
+ *   O parser instala a arena durante a análise e ela passa ao SyntaxResult,
+ *   que libera a AST inteira de uma vez. */
+struct Arena;
+struct Arena *ast_set_arena(struct Arena *arena);   /* retorna a anterior */
+struct Arena *ast_get_arena(void);
+void *ast_alloc(size_t size);
+
+/* Cópia profunda na arena corrente / na arena indicada (NULL = heap) */
 Node *ast_copy(Node *node);
+Node *ast_copy_to(struct Arena *arena, Node *node);
 
 #endif /* AST_BASE_H */
@@ -0,0 +1,74 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ast_compact.h"
+#include "str_pool.h"
+
+/* =========================================================
+ * Cache da AST em disco
+ *   - A AST compacta (ast_compact.h) gravada como está: os arrays só
+ *     têm índices, então o arquivo é mapeado de volta (mmap) e usado
+ *     direto, sem percorrer a árvore. Só as tabelas de nomes e de
+ *     literais são reconstituídas (proporcional aos distintos);
+ *   - Fica ao lado do fonte (`arquivo` + AST_CACHE_EXT) e o cabeçalho
+ *     guarda tamanho e hash do fonte (como o arquivo de tokens), além da
+ *     versão do formato e dos tamanhos dos registros nesta máquina;
+ *   - Só análises sem erro são gravadas (os diagnósticos não ficam no
+ *     cache); um cache velho ou de outro formato é ignorado e regravado;
+ *   - O conteúdo é conferido numa passada pelos nós antes do uso (tipos,
+ *     índices, listas e forma da árvore): um arquivo corrompido também
+ *     é ignorado, nunca lido fora dos arrays.
+ *
+ * Layout (ordem de bytes da máquina, cada array alinhado a 8 bytes):
+ *   AstCacheHeader
+ *   uint8  kind[node_count]
+ *   uint32 data[node_count]
+ *   lists, ints, floats, unary, binary, blocks, assigns, ifs, decls,
+ *   whiles, fors, funcs, calls (counts[] no cabeçalho, nessa ordem)
+ *   nomes:    name_count   x (uint32 tamanho + bytes)
+ *   literais: string_count x (uint32 tamanho + bytes)
+ * ========================================================= */
+
+#define AST_CACHE_MAGIC   0x43545341u   /* "ASTC" */
+#define AST_CACHE_VERSION 1u
+#define AST_CACHE_EXT     ".astc"
+#define AST_CACHE_ARRAYS  13
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t src_len;
+    uint64_t src_hash;
+    uint32_t layout;        /* tamanhos dos registros (ast_cache.c) */
+    uint32_t node_count;
+    uint32_t root;
+    uint32_t name_count;
+    uint32_t names_bytes;
+    uint32_t string_count;
+    uint32_t strings_bytes;
+    uint32_t counts[AST_CACHE_ARRAYS];
+    uint32_t reserved;
+} AstCacheHeader;
+
+/* ASTEROIDS_AST_CACHE=1 liga o cache em syntax_parse_path */
+bool ast_cache_enabled(void);
+
+/* Caminho do cache de um fonte (alocado); NULL para stdin */
+char *ast_cache_path(const char *src_path);
+
+/* Grava a AST (com raiz, ver cast_finish) e os literais; o arquivo é
+ * escrito ao lado e renomeado, então leitores nunca veem um cache pela
+ * metade */
+bool ast_cache_save(const char *path, const CompactAst *ast, const StrPool *strings,
+                    uint64_t src_len, uint64_t src_hash);
+
+/* Mapeia o cache se ele existir e corresponder ao fonte (tamanho + hash).
+ * A AST devolvida aponta para o arquivo (cast_free o desmapeia); os
+ * literais vão para um pool novo em `*strings`. NULL se não houver cache
+ * válido. */
+CompactAst *ast_cache_load(const char *path, uint64_t src_len, uint64_t src_hash,
+                           StrPool **strings);
+
+#endif /* AST_CACHE_H */
@@ -0,0 +1,147 @@
+#ifndef AST_COMPACT_H
+#define AST_COMPACT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ast_base.h"
+#include "str_pool.h"
+#include "source_buffer.h"
+
+/* =========================================================
+ * AST compacta (struct-of-arrays)
+ *   - Cada nó é um índice uint32_t (CNode): `kind[n]` guarda o tipo e
+ *     `data[n]` a posição do payload no array denso daquele tipo; nós
+ *     sem campos extras guardam o valor direto em `data[n]` (bool, id
+ *     do literal no pool, filho de ND_EXPR/ND_RETURN);
+ *   - Filhos são índices (CAST_NONE = ausente) e as listas (blocos,
+ *     parâmetros, argumentos) são trechos contínuos de `lists`;
+ *   - Nós em pré-ordem: o pai vem antes dos filhos e cada instrução de
+ *     nível superior ocupa um trecho contínuo dos arrays, então percorrer
+ *     o programa é varrê-los em ordem. A raiz (bloco do programa) é o
+ *     último nó, criado por cast_finish;
+ *   - Nomes são índices de uma tabela com um nome internado por nome
+ *     distinto (ND_IDENT guarda o índice em `data[n]`): fora dessa tabela,
+ *     os arrays não têm ponteiros e podem ser gravados e mapeados de
+ *     volta como estão (ast_cache.h);
+ *   - Um ND_INT ocupa 5 bytes + 8 do valor; um Node, 48.
+ *
+ * Adaptador: cast_to_node() monta o Node equivalente (na arena corrente,
+ * ver ast_set_arena) para os visitantes que ainda trabalham com ponteiros.
+ * ========================================================= */
+
+typedef uint32_t CNode;
+#define CAST_NONE UINT32_MAX
+
+typedef struct { uint32_t first, count; } CList;   /* trecho de `lists` */
+
+/* Payloads (um array denso por tipo de nó); `name` é o índice em
+ * `names`, então nenhum array guarda ponteiros */
+typedef struct { UnOp op; CNode expr; } CUnary;
+typedef struct { BinOp op; CNode left, right; } CBinary;
+typedef struct { uint32_t name; CNode value; } CAssign;
+typedef struct { CNode cond, then_branch, else_branch; } CIf;
+typedef struct { uint32_t name; TypeTag type; CNode init; } CDecl;
+typedef struct { CNode cond, body; } CWhile;
+typedef struct { CNode init, cond, step, body; } CFor;
+typedef struct { uint32_t name; TypeTag ret_type; CList params; CNode body; } CFunction;
+typedef struct { uint32_t name; CList args; } CCall;
+
+/* Array que só cresce */
+typedef struct {
+    void    *items;
+    uint32_t count;
+    uint32_t cap;
+} CastVec;
+
+typedef struct CompactAst {
+    uint8_t  *kind;          /* NodeKind de cada nó */
+    uint32_t *data;          /* índice do payload (ou o próprio valor) */
+    uint32_t  count;
+    uint32_t  cap;
+    CNode     root;          /* ND_BLOCK do programa (CAST_NONE até cast_finish) */
+
+    const StrPool *strings;  /* literais (ND_STRING guarda o id) */
+
+    CastVec lists;           /* CNode: filhos de blocos, parâmetros e argumentos */
+    CastVec top;             /* CNode: instruções de nível superior (cast_add_top) */
+
+    CastVec ints;            /* long */
+    CastVec floats;          /* double */
+    CastVec names;           /* const char*: nomes internados, um por nome distinto */
+    CastVec unary;           /* CUnary */
+    CastVec binary;          /* CBinary */
+    CastVec blocks;          /* CList */
+    CastVec assigns;         /* CAssign */
+    CastVec ifs;             /* CIf */
+    CastVec decls;           /* CDecl */
+    CastVec whiles;          /* CWhile */
+    CastVec fors;            /* CFor */
+    CastVec funcs;           /* CFunction */
+    CastVec calls;           /* CCall */
+
+    uint32_t *name_ids;      /* intern_id(nome) -> índice em `names` + 1 (só na construção) */
+    size_t    name_ids_cap;
+
+    SourceBuffer file;       /* carregada do cache (ast_cache.h): os arrays
+                                apontam para o arquivo mapeado */
+} CompactAst;
+
+/* AST vazia; `strings` é o pool dos literais (deve viver mais que ela) */
+CompactAst *cast_new(const StrPool *strings);
+void cast_free(CompactAst *ast);
+
+/* Copia a subárvore `node` (NULL = CAST_NONE) e retorna o índice da raiz */
+CNode cast_add(CompactAst *ast, const Node *node);
+
+/* Copia `stmt` como a próxima instrução do programa (NULL é ignorado);
+ * o nó original pode ser liberado logo em seguida */
+void cast_add_top(CompactAst *ast, const Node *stmt);
+
+/* Cria a raiz com as instruções de cast_add_top e retorna o índice */
+CNode cast_finish(CompactAst *ast);
+
+/* Converte uma AST inteira (raiz = bloco do programa) */
+CompactAst *cast_from_node(const Node *root, const StrPool *strings);
+
+/* Adaptador: monta o Node de `n` (e dos filhos) na arena corrente,
+ * em pré-ordem (memória contínua na ordem de visita) */
+Node *cast_to_node(const CompactAst *ast, CNode n);
+
+/* Bytes ocupados pelos arrays (capacidade reservada) */
+size_t cast_memory(const CompactAst *ast);
+
+/* --- Acesso --- */
+
+static inline NodeKind cast_kind(const CompactAst *a, CNode n) { return (NodeKind)a->kind[n]; }
+
+static inline long        cast_int(const CompactAst *a, CNode n)   { return ((const long*)a->ints.items)[a->data[n]]; }
+static inline double      cast_float(const CompactAst *a, CNode n) { return ((const double*)a->floats.items)[a->data[n]]; }
+static inline bool        cast_bool(const CompactAst *a, CNode n)  { return a->data[n] != 0; }
+static inline const char *cast_ident(const CompactAst *a, CNode n) { return ((const char *const*)a->names.items)[a->data[n]]; }
+
+/* Nome internado de um índice de `names` (CAST_NONE = NULL) */
+static inline const char *cast_name(const CompactAst *a, uint32_t name) {
+    return name == CAST_NONE ? NULL : ((const char *const*)a->names.items)[name];
+}
+static inline uint32_t    cast_string(const CompactAst *a, CNode n) { return a->data[n]; }
+
+/* Filho único de ND_EXPR e ND_RETURN */
+static inline CNode cast_child(const CompactAst *a, CNode n) { return a->data[n]; }
+
+static inline const CUnary    *cast_unary(const CompactAst *a, CNode n)    { return (const CUnary*)a->unary.items + a->data[n]; }
+static inline const CBinary   *cast_binary(const CompactAst *a, CNode n)   { return (const CBinary*)a->binary.items + a->data[n]; }
+static inline const CList     *cast_block(const CompactAst *a, CNode n)    { return (const CList*)a->blocks.items + a->data[n]; }
+static inline const CAssign   *cast_assign(const CompactAst *a, CNode n)   { return (const CAssign*)a->assigns.items + a->data[n]; }
+static inline const CIf       *cast_if(const CompactAst *a, CNode n)       { return (const CIf*)a->ifs.items + a->data[n]; }
+static inline const CDecl     *cast_decl(const CompactAst *a, CNode n)     { return (const CDecl*)a->decls.items + a->data[n]; }
+static inline const CWhile    *cast_while(const CompactAst *a, CNode n)    { return (const CWhile*)a->whiles.items + a->data[n]; }
+static inline const CFor      *cast_for(const CompactAst *a, CNode n)      { return (const CFor*)a->fors.items + a->data[n]; }
+static inline const CFunction *cast_function(const CompactAst *a, CNode n) { return (const CFunction*)a->funcs.items + a->data[n]; }
+static inline const CCall     *cast_call(const CompactAst *a, CNode n)     { return (const CCall*)a->calls.items + a->data[n]; }
+
+/* i-ésimo elemento de uma lista (bloco, parâmetros, argumentos) */
+static inline CNode cast_list_at(const CompactAst *a, CList l, uint32_t i) {
+    return ((const CNode*)a->lists.items)[l.first + i];
+}
+
+#endif /* AST_COMPACT_H */
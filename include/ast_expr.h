@@ -2,12 +2,15 @@
 #define AST_EXPR_H
 
 #include "ast_base.h"
+#include "str_pool.h"
 
 Node *ast_int(long value);
 Node *ast_float(double value);
 Node *ast_bool(bool value);
+/* Nomes (`name`) devem vir internados (intern.h): a AST apenas os referencia.
+ * ast_string referencia o literal `id` do pool, que deve viver mais que a AST. */
 Node *ast_ident(const char *name);
-Node *ast_string(const char *value);
+Node *ast_string(const StrPool *pool, uint32_t id);
 Node *ast_unary(UnOp op, Node *expr);
 Node *ast_binary(BinOp op, Node *left, Node *right);
 Node *ast_block(void);
@@ -18,7 +21,7 @@ Node *ast_if(Node *cond, Node *then_branch, Node *else_branch);
 Node *ast_decl(TypeTag type, const char *name, Node *init);
 Node *ast_while(Node *cond, Node *body);
 Node *ast_for(Node *init, Node *cond, Node *step, Node *body);
-Node *ast_function(TypeTag ret_type, char *name, Node **params, size_t param_count, Node *body);
+Node *ast_function(TypeTag ret_type, const char *name, Node **params, size_t param_count, Node *body);
 Node *ast_return(Node *expr);
 Node *ast_call(const char *name, Node **args, size_t arg_count);
 
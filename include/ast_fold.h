@@ -0,0 +1,57 @@
+#ifndef AST_FOLD_H
+#define AST_FOLD_H
+
+#include <stdbool.h>
+#include "ast_base.h"
+
+/* =========================================================
+ * Dobramento de constantes e simplificação algébrica
+ *   - Roda sobre programas já verificados (check_semantics), uma
+ *     instrução de nível superior por vez, antes da geração de IR;
+ *   - Unárias e binárias só com literais viram um literal, com as
+ *     regras de tipo da análise semântica (infer_binary): int com float
+ *     dá float e `/` sempre dá float. Só dobra o que o programa gerado
+ *     calcularia igual: inteiros dentro de ±2^53 (exatos num double),
+ *     sem divisão por zero e floats que o IR imprime sem perda;
+ *   - Identidades que não mudam tipo nem valor: x*1, x+0 (x int), x-0,
+ *     x/1 (x float), !!b, b && true, true && b, b || false, false || b
+ *     (e false && b, true || b, que nem avaliam b);
+ *   - if com condição constante fica só com o ramo escolhido; while e
+ *     for com condição falsa somem (o init do for continua);
+ *   - Propagação de constantes pelo programa inteiro (opcional, antes
+ *     da primeira fold_stmt): uma variável — global, local ou parâmetro —
+ *     que nunca é atribuída e cujo valor é sempre o mesmo literal (do
+ *     inicializador, ou dos argumentos de todas as chamadas diretas, para
+ *     um parâmetro) é lida como o literal; as regras acima dobram o
+ *     resto, e cadeias de chamadas com argumentos constantes somem;
+ *   - A árvore recebida não é alterada: só os caminhos que mudam são
+ *     copiados (na arena corrente), o resto é reaproveitado, inclusive
+ *     os nós compartilhados (NODE_SHARED).
+ *
+ * ASTEROIDS_FOLD=1 liga o passo em irb_build_program* (desligado, o IR
+ * segue a árvore como está, que é o que os goldens de geração esperam).
+ * ========================================================= */
+
+typedef struct Folder Folder;
+
+Folder *fold_new(void);
+void fold_free(Folder *fd);
+
+/* Tipo de retorno de uma função, para as chamadas dentro de expressões */
+void fold_declare_function(Folder *fd, const char *name, TypeTag ret_type);
+
+/* Propagação de constantes: cada instrução de nível superior, na ordem
+ * do fonte, passa por fold_scan_stmt(); fold_scan_finish() calcula os
+ * valores. Só os parâmetros de funções de nível superior definidas uma
+ * vez recebem os argumentos; os literais vivem até fold_free(). */
+void fold_scan_stmt(Folder *fd, Node *stmt);
+void fold_scan_finish(Folder *fd);
+
+/* Instrução de nível superior simplificada (pode ser a própria `stmt`);
+ * NULL se ela sumiu. As declarações globais valem para as seguintes. */
+Node *fold_stmt(Folder *fd, Node *stmt);
+
+/* ASTEROIDS_FOLD=1 */
+bool fold_enabled(void);
+
+#endif /* AST_FOLD_H */
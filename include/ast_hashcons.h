@@ -0,0 +1,47 @@
+#ifndef AST_HASHCONS_H
+#define AST_HASHCONS_H
+
+#include <stdbool.h>
+#include "ast_base.h"
+
+/* =========================================================
+ * Hash-consing das expressões
+ *   - Com uma tabela ativa (ast_set_hashcons), os construtores de
+ *     literais, identificadores, unárias e binárias (ast_expr.h)
+ *     devolvem um nó único por estrutura: `n - 1` repetido no programa
+ *     inteiro é um só nó, e os filhos já compartilhados são comparados
+ *     por ponteiro, então a busca é O(1);
+ *   - Os nós compartilhados ficam na arena da tabela e morrem com ela
+ *     (sem contagem de referências). Levam NODE_SHARED e são imutáveis:
+ *     quem precisar alterar um deles deve construir um nó novo;
+ *   - A tabela só vale enquanto a arena corrente for a dela; fora disso
+ *     (outra arena, heap, análise incremental) os construtores criam nós
+ *     comuns;
+ *   - Na mesma tabela, duas expressões compartilhadas são iguais se e
+ *     somente se os ponteiros forem iguais; ast_equal() cobre o caso
+ *     geral.
+ * ========================================================= */
+
+struct Arena;
+typedef struct HashCons HashCons;
+
+/* Tabela vazia cujos nós vão para `arena` (que deve viver mais que ela) */
+HashCons *hashcons_new(struct Arena *arena);
+void hashcons_free(HashCons *hc);
+
+/* Tabela corrente da thread (NULL = sem compartilhamento); retorna a anterior */
+HashCons *ast_set_hashcons(HashCons *hc);
+
+/* Nó compartilhado com a estrutura de `key` (só kind e u são lidos),
+ * criado na arena da tabela se ainda não existir; NULL se não houver
+ * tabela ativa ou se o tipo de nó não for compartilhável */
+Node *hashcons_intern(const Node *key);
+
+/* `node` pertence à tabela ativa (pode ser reaproveitado em vez de copiado) */
+bool hashcons_owns(const Node *node);
+
+/* Igualdade estrutural (NULL só é igual a NULL); termina na raiz quando
+ * os dois lados são o mesmo nó */
+bool ast_equal(const Node *a, const Node *b);
+
+#endif /* AST_HASHCONS_H */
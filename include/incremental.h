@@ -0,0 +1,47 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "syntax_analyzer.h"
+
+/* =========================================================
+ * Reanálise incremental (integração com editores)
+ *   - Guarda o texto atual, a AST e a região (posições) de cada
+ *     instrução de nível superior (funções, declarações, ...);
+ *   - A cada edição, só as regiões tocadas (incluindo o lookahead
+ *     do lexer/parser) são analisadas de novo; a análise para assim
+ *     que volta a coincidir com o fim de uma região antiga, e as
+ *     demais subárvores são reaproveitadas sem cópia;
+ *   - Resultado idêntico ao de analisar o texto inteiro de novo
+ *     (mesma AST e mesma contagem de erros). Usa o parser escrito
+ *     à mão (parser_rd.h) em modo quiet: os erros são só contados.
+ * ========================================================= */
+
+typedef struct IncrementalParse IncrementalParse;
+
+/* Custo da última análise (inicial ou edição) */
+typedef struct {
+    size_t reparsed_stmts;   /* instruções analisadas de novo */
+    size_t reused_stmts;     /* instruções reaproveitadas */
+    size_t reparsed_bytes;   /* trecho do texto percorrido pelo lexer */
+} IncrStats;
+
+/* Analisa `text` (copiado) por inteiro */
+IncrementalParse *incr_parse_new(const char *text, size_t len);
+
+/* Substitui `removed` bytes a partir de `offset` por `text` e atualiza a
+ * AST. Retorna false (sem alterar nada) se o trecho estiver fora do texto. */
+bool incr_parse_edit(IncrementalParse *ip, size_t offset, size_t removed,
+                     const char *text, size_t len);
+
+/* Resultado atual; a AST e o pool de literais continuam pertencendo a
+ * `ip` (não liberar) e a AST vale até a próxima edição. */
+SyntaxResult incr_parse_result(const IncrementalParse *ip);
+
+const char *incr_parse_text(const IncrementalParse *ip, size_t *len);
+IncrStats   incr_parse_stats(const IncrementalParse *ip);
+
+void incr_parse_free(IncrementalParse *ip);
+
+#endif /* INCREMENTAL_H */
@@ -0,0 +1,34 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* =========================================================
+ * Tabela global de identificadores internados
+ *   - Cada nome distinto é guardado uma única vez, terminado em '\0';
+ *   - O ponteiro devolvido é estável até o fim do processo, então dois
+ *     nomes internados são iguais se, e somente se, os ponteiros forem;
+ *   - Hash e id (denso, a partir de 0) ficam pré-calculados junto do nome;
+ *   - Pode ser usada por várias threads ao mesmo tempo.
+ * ========================================================= */
+
+/* Interna `len` bytes de `s` (não precisa estar terminado em '\0') */
+const char *intern(const char *s, size_t len);
+
+/* Atalho para strings terminadas em '\0' */
+const char *intern_cstr(const char *s);
+
+/* Hash pré-calculado de um nome internado */
+uint32_t intern_hash(const char *name);
+
+/* Id denso (0, 1, 2, ...) de um nome internado */
+uint32_t intern_id(const char *name);
+
+/* Tamanho do nome internado (sem o '\0') */
+size_t intern_len(const char *name);
+
+/* Quantidade de nomes internados até agora (limite superior dos ids) */
+size_t intern_count(void);
+
+#endif /* INTERN_H */
@@ -4,13 +4,15 @@
     #include <stddef.h>
     #include <stdbool.h>
     #include "ast_base.h" /* para TypeTag e xmalloc/xstrdup */
+    #include "str_pool.h"
 
     /* ================================
     *  Variáveis locais
     * ================================ */
     typedef struct {
-        const char *name;   /* nome da variável no código-fonte */
+        const char *name;   /* nome da variável no código-fonte (internado) */
         int         temp;   /* id do temporário que representa o valor atual da variável */
+        int         next;   /* próximo local com o mesmo temp (índice + 1; 0 = nenhum) */
     } IrLocalVar;
 
     /* ================================
@@ -61,7 +63,7 @@
             double     f;        /* IR_OPER_FLOAT*/
             int        b;        /* IR_OPER_BOOL */
             int        label;    /* IR_OPER_LABEL*/
-            const char *str;     /* IR_OPER_STRING */
+            uint32_t   str;      /* IR_OPER_STRING: índice no pool de literais */
         } v;
     } IrOperand;
 
@@ -81,11 +83,25 @@
         TypeTag cast_to;      /* tipo alvo do CAST */
 
         const char *callee;   /* Para IR_CALL: nome da função */
+        int         callee_index; /* Para IR_CALL: posição da função em IrProgram.funcs (-1 = desconhecida) */
         int        *args;     /* Para IR_CALL: vetor de temporários (tN) com os argumentos */
         size_t      argc;     /* Para IR_CALL: quantidade de args */
         TypeTag     ret_type; /* retorno da função chamada (para referência) */
     } IrInstr;
 
+    /* ================================
+    *  Efeitos de uma função (ir_effects.h)
+    * ================================ */
+    typedef enum {
+        IR_PURE = 0,    /* resultado só dos argumentos, sem efeito */
+        IR_READONLY,    /* lê globais, não escreve */
+        IR_EFFECTFUL    /* escreve globais ou chama função desconhecida */
+    } IrEffect;
+
+    /* Efeitos do próprio corpo (IrFunc.own_effects), marcados pelo IR builder */
+    #define IR_FX_READS  0x1u   /* lê uma variável de fora da função */
+    #define IR_FX_WRITES 0x2u   /* atribui a uma variável de fora da função */
+
     /* ================================
     *  Função e Programa
     * ================================ */
@@ -107,12 +123,26 @@
         IrLocalVar *locals;
         size_t      local_count;
         size_t      local_cap;
+        int        *temp_local;     /* por temp: primeiro local com ele (índice + 1; 0 = nenhum) */
+        size_t      temp_local_cap;
+
+        /* Tipo de cada temporário (TY_INVALID = desconhecido): as
+         * instruções tipam o destino; o IR builder, os que cria direto */
+        TypeTag    *temp_types;
+        size_t      temp_types_cap;
+
+        /* Efeitos: os do corpo (IR_FX_*) e o resumo com os das funções
+         * chamadas, calculado por ir_effects_compute() */
+        unsigned    own_effects;
+        IrEffect    effect;
     } IrFunc;
 
     typedef struct {
         IrFunc  **funcs;
         size_t    func_count;
         size_t    func_cap;
+
+        const StrPool *strings; /* literais de string (do SyntaxResult, não é liberado aqui) */
     } IrProgram;
 
     /* ================================
@@ -129,6 +159,14 @@
 
     void       ir_func_end(IrProgram *p, IrFunc *f);
 
+    /* ir_func_begin em dois passos: a função criada solta e acrescentada
+    *  depois (o programa passa a ser o dono dela) */
+    IrFunc    *ir_func_new(const char *name,
+                           TypeTag ret_type,
+                           const TypeTag *params,
+                           size_t param_count);
+    void       ir_program_add(IrProgram *p, IrFunc *f);
+
     /* ================================
     *  Helpers — temporários/labels
     * ================================ */
@@ -167,10 +205,10 @@
         return op;
     }
 
-    static inline IrOperand ir_string(const char *s) {
-        IrOperand o;
+    static inline IrOperand ir_string(uint32_t id) {
+        IrOperand o = {0};
         o.kind  = IR_OPER_STRING;
-        o.v.str = s;
+        o.v.str = id;
         return o;
     }
 
@@ -187,7 +225,7 @@
     int  ir_emit_bin (IrFunc *f, IrOp op, IrOperand a, IrOperand b);  /* ADD/SUB/MUL/DIV -> dst */
     int  ir_emit_cmp (IrFunc *f, IrOp op, IrOperand a, IrOperand b);  /* LT/LE/GT/GE/EQ/NE -> bool dst */
 
-    int  ir_emit_call(IrFunc *f, const char *name,
+    int  ir_emit_call(IrFunc *f, const char *name, int callee_index,
                     const int *arg_temps, size_t argc,
                     TypeTag ret_type); /* retorna dst tN (ou -1 se void) */
 
@@ -195,4 +233,14 @@
 
     void ir_register_local(IrFunc *f, const char *name, int temp);
 
+    /* Tipo de um temporário (TY_INVALID se desconhecido) */
+    void    ir_set_temp_type(IrFunc *f, int temp, TypeTag t);
+    TypeTag ir_temp_type(const IrFunc *f, int temp);
+
+    /* Nome do primeiro local registrado com o temp (NULL se nenhum), O(1) */
+    const char *ir_local_name(const IrFunc *f, int temp);
+
+    /* Marca um efeito do corpo da função (IR_FX_*) */
+    void ir_mark_effect(IrFunc *f, unsigned fx);
+
     #endif /* IR_H */
@@ -5,22 +5,39 @@
 #include "symbol_table.h"
 #include "ir.h"
 
-/** Reseta estado interno do builder (map de variáveis -> temporários).
+/** Reseta estado interno do builder (slot de variável -> temporário).
  *  Chame isso sempre que começar a gerar IR de uma nova função.
  */
 void irb_reset_state(void);
 
-/** Gera IR para um statement */
+/** Gera IR para um statement já resolvido (resolve.h): variáveis são
+ *  acessadas pelo slot, sem procurar o nome */
 void irb_emit_stmt(IrFunc *f, Node *stmt);
 
 
 /** Gera IR para uma expressão e retorna o temporário tN com o resultado */
 int  irb_emit_expr(IrFunc *f, Node *expr);
 
-/** Gera IR para uma função completa */
-IrProgram *irb_build_program(Node *program_node);
-
-/** Constrói um programa IR completo a partir da AST */
-IrProgram *irb_build_program(Node *ast);
+/** Constrói um programa IR completo a partir da AST; `strings` é o pool
+ *  de literais da AST (SyntaxResult), referenciado pelo programa */
+IrProgram *irb_build_program(Node *ast, const StrPool *strings);
+
+/** Mesmo programa, a partir da AST compacta (ast_compact.h) */
+struct CompactAst;
+IrProgram *irb_build_program_compact(const struct CompactAst *ast, const StrPool *strings);
+
+/** Verificação semântica e IR numa só passada: cada instrução de nível
+ *  superior é resolvida uma vez, verificada (mesmas mensagens de
+ *  check_semantics) e emitida. Com erros, devolve NULL e só os
+ *  diagnósticos ficam; `*errors` recebe o número de erros. Com
+ *  ASTEROIDS_FOLD=1 volta às duas passadas (o dobramento refaz nós, que
+ *  precisariam ser resolvidos de novo). */
+IrProgram *irb_check_and_build(Node *ast, const StrPool *strings,
+                               SymbolTable *table, int *errors);
+IrProgram *irb_check_and_build_compact(const struct CompactAst *ast, const StrPool *strings,
+                                       SymbolTable *table, int *errors);
+
+/** ASTEROIDS_FUSED=1: os drivers usam irb_check_and_build* */
+bool irb_fused_enabled(void);
 
 #endif
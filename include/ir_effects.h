@@ -0,0 +1,41 @@
+#ifndef IR_EFFECTS_H
+#define IR_EFFECTS_H
+
+#include <stdbool.h>
+#include "ir.h"
+
+/* =========================================================
+ * Efeitos das funções do IR
+ *   - Cada IrFunc recebe um resumo (IrFunc.effect): IR_PURE (o
+ *     resultado só depende dos argumentos), IR_READONLY (lê globais) ou
+ *     IR_EFFECTFUL (escreve globais, ou chama uma função fora do
+ *     programa: callee_index == -1);
+ *   - O resumo junta os efeitos do próprio corpo (own_effects, marcados
+ *     pelo IR builder) com os das funções chamadas. Funções recursivas
+ *     entre si (uma componente fortemente conexa do grafo de chamadas)
+ *     têm o mesmo resumo;
+ *   - Componentes pelo algoritmo de Tarjan, iterativo, que as fecha das
+ *     chamadas para quem chama: linear no tamanho do grafo (funções mais
+ *     instruções de chamada);
+ *   - _entry é a dona das globais: as dela não contam como efeito;
+ *   - Terminação não é analisada: uma chamada pura pode não retornar.
+ *
+ * irb_build_program* já calcula os resumos; depois de mudar o código
+ * de um programa, ir_effects_compute() os refaz.
+ * ========================================================= */
+
+void ir_effects_compute(IrProgram *p);
+
+/* Resumo de uma função / de quem uma instrução IR_CALL chama
+ * (IR_EFFECTFUL se a função não é conhecida) */
+IrEffect ir_func_effect(const IrFunc *f);
+IrEffect ir_call_effect(const IrProgram *p, const IrInstr *call);
+
+/* A chamada pode ser retirada se o resultado não é usado (IR_PURE ou
+ * IR_READONLY) */
+bool ir_call_removable(const IrProgram *p, const IrInstr *call);
+
+/* "pure", "readonly" ou "effectful" */
+const char *ir_effect_name(IrEffect e);
+
+#endif /* IR_EFFECTS_H */
@@ -0,0 +1,54 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "parse_context.h"
+#include "source_buffer.h"
+#include "str_pool.h"
+
+/* =========================================================
+ * Fachada do analisador léxico
+ *   - O parser e o lexer_driver só falam com estas funções;
+ *   - Elas repassam para o scanner do Flex (scanner.l) ou para o
+ *     lexer escrito à mão (lexer_fast.c), ou reproduzem um fluxo de
+ *     tokens já pronto (token_stream.h), conforme ctx->lexer;
+ *   - Os dois produzem exatamente os mesmos tokens, yylval, linhas,
+ *     colunas e mensagens de erro.
+ *
+ * Seleção:
+ *   - em tempo de compilação: `make LEXER=fast` nem compila o Flex;
+ *   - em tempo de execução: ASTEROIDS_LEXER=fast (ou flex).
+ * ========================================================= */
+
+union YYSTYPE;
+
+/* Scanner escolhido para novas análises (build + ASTEROIDS_LEXER) */
+LexerKind lexer_default_kind(void);
+
+/* Nome legível ("flex" / "fast") */
+const char *lexer_kind_name(LexerKind kind);
+
+/* Abre o scanner ctx->lexer sobre ctx->src (que já deve estar carregado) */
+bool lexer_open(ParseContext *ctx);
+void lexer_close(ParseContext *ctx);
+
+/* Próximo token (0 no fim da entrada); preenche *lval como o yylval do Bison */
+int lexer_next(union YYSTYPE *lval, ParseContext *ctx);
+
+/* Linha atual e lexema do último token (o texto NÃO termina em '\0') */
+int         lexer_line(const ParseContext *ctx);
+const char *lexer_text(const ParseContext *ctx);
+size_t      lexer_leng(const ParseContext *ctx);
+
+/* Comentário multilinha sem fecho na linha `line`: imprime o erro e
+ * encerra o processo (com ctx->quiet só anota em ctx->fatal_line, e o
+ * scanner devolve fim de entrada). */
+void lexer_unclosed_comment(ParseContext *ctx, int line);
+
+/* Decodifica as sequências de escape de um literal de string (sem as aspas)
+ * direto para o pool de literais e retorna o índice. Sem escapes, o texto
+ * só é copiado se ainda não estiver no pool. */
+uint32_t scan_string_literal(StrPool *pool, SrcSlice lit);
+
+#endif /* LEXER_H */
@@ -0,0 +1,40 @@
+#ifndef LEXER_FAST_H
+#define LEXER_FAST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "parse_context.h"
+
+/* =========================================================
+ * Lexer escrito à mão (alternativa ao scanner.l)
+ *   - Mesmo fluxo de tokens, yylval, linhas e colunas do Flex;
+ *   - Espaços, comentários, identificadores e números são varridos em
+ *     blocos de 32 (AVX2) ou 16 (SSE2) bytes, com fallback escalar;
+ *   - Quebras de linha dentro de comentários e strings são contadas
+ *     em bloco (popcount), sem uma ação por caractere.
+ * A variante SIMD é escolhida uma vez pela CPU; ASTEROIDS_SIMD=scalar,
+ * sse2 ou avx2 força uma delas (útil para testes).
+ * ========================================================= */
+
+union YYSTYPE;
+
+typedef struct FastLexer {
+    ParseContext *ctx;
+    const char   *cur;       /* próximo byte a ler */
+    const char   *end;       /* fim do fonte */
+    const char   *tok;       /* início do último token */
+    size_t        tok_len;
+    int           line;      /* linha atual (equivale ao yylineno) */
+} FastLexer;
+
+/* Cria o lexer sobre ctx->src e guarda em ctx->fast */
+bool fast_lexer_open(ParseContext *ctx);
+void fast_lexer_close(ParseContext *ctx);
+
+/* Próximo token (0 no fim da entrada) */
+int fast_lex(union YYSTYPE *lval, FastLexer *lx);
+
+/* Nome da variante SIMD em uso ("avx2", "sse2" ou "scalar") */
+const char *fast_lexer_simd_name(void);
+
+#endif /* LEXER_FAST_H */
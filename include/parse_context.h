@@ -0,0 +1,94 @@
+#ifndef PARSE_CONTEXT_H
+#define PARSE_CONTEXT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "ast_base.h"
+#include "source_buffer.h"
+#include "str_pool.h"
+
+/* Mesmo typedef que o Flex gera para o scanner reentrante */
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+/* Implementação do analisador léxico (ver lexer.h) */
+typedef enum {
+    LEXER_FLEX,   /* scanner.l (padrão) */
+    LEXER_FAST,   /* lexer_fast.c, escrito à mão com SIMD */
+    LEXER_REPLAY  /* tokens já prontos (token_stream.h) */
+} LexerKind;
+
+struct FastLexer;
+struct TokenStream;
+struct yy_buffer_state;   /* YY_BUFFER_STATE do Flex */
+
+/* =========================================================
+ * Estado de uma análise sintática
+ *   - Tudo o que o scanner e o parser usam durante uma compilação
+ *     fica aqui (nenhuma variável global), então várias análises
+ *     podem rodar ao mesmo tempo, em threads diferentes;
+ *   - O scanner acessa o contexto via yyextra e o parser via %param.
+ * ========================================================= */
+typedef struct ParseContext {
+    LexerKind    lexer;       /* qual scanner usar (lexer_open) */
+    yyscan_t     scanner;     /* instância reentrante do Flex */
+    struct yy_buffer_state *scan_buffer; /* buffer do Flex sobre src */
+    struct FastLexer *fast;   /* instância do lexer escrito à mão */
+    struct TokenStream *tokens; /* fluxo reproduzido (LEXER_REPLAY) */
+    size_t       tok_pos;     /* próximo registro de `tokens` */
+    size_t       tok_last;    /* último registro entregue */
+    SourceBuffer src;         /* fonte em memória (os lexemas apontam para cá) */
+    int          column;      /* coluna atual (começa em 1) */
+    int          errors;      /* erros léxicos/sintáticos reportados */
+    bool         quiet;       /* conta os erros sem imprimir (pré-tokenização) */
+    int          fatal_line;  /* comentário não fechado visto com quiet (0 = não) */
+    Node        *ast;         /* raiz produzida pela regra Program */
+    StrPool     *strings;     /* literais de string da AST (str_pool.h) */
+
+    /* Pilha de rascunho para argumentos e parâmetros (ver abaixo) */
+    Node       **scratch;
+    size_t       scratch_len;
+    size_t       scratch_cap;
+} ParseContext;
+
+/* --- parse_context.c ---
+ * Listas de argumentos e de parâmetros são empilhadas em ctx->scratch
+ * enquanto são lidas; cada lista guarda só a marca (posição) onde
+ * começa. Listas aninhadas (f(g(x), y) ou uma função dentro de outra)
+ * terminam antes da externa, então a pilha é sempre LIFO. */
+
+void parse_scratch_push(ParseContext *ctx, Node *node);
+
+/* Desempilha os nós desde `mark` para um array com o tamanho exato,
+ * alocado com ast_alloc (NULL se a lista estiver vazia), e guarda a
+ * quantidade em *count */
+Node **parse_scratch_take(ParseContext *ctx, size_t mark, size_t *count);
+
+/* Descarta (ast_free) os nós desde `mark`: lista abandonada por erro */
+void parse_scratch_release(ParseContext *ctx, size_t mark);
+
+/* Libera a pilha ao fim da análise */
+void parse_scratch_free(ParseContext *ctx);
+
+/* --- scanner.l --- */
+
+/* Cria o scanner e passa a ler de ctx->src (já carregado) */
+bool scanner_open(ParseContext *ctx);
+
+/* Destrói o scanner (não libera ctx->src) */
+void scanner_close(ParseContext *ctx);
+
+/* Linha atual, texto e tamanho do último token */
+int         scanner_line(const ParseContext *ctx);
+const char *scanner_text(const ParseContext *ctx);
+size_t      scanner_leng(const ParseContext *ctx);
+
+/* --- parser.y --- */
+
+/* Reporta um erro sintático na posição atual e incrementa ctx->errors
+ * (com ctx->quiet só incrementa) */
+void yyerror(ParseContext *ctx, const char *s);
+
+#endif /* PARSE_CONTEXT_H */
@@ -0,0 +1,39 @@
+#ifndef PARSER_RD_H
+#define PARSER_RD_H
+
+#include "parse_context.h"
+
+/* =========================================================
+ * Parser escrito à mão (descida recursiva + Pratt)
+ *   - Mesma gramática do parser.y, construindo os nós direto,
+ *     sem tabelas nem nós intermediários;
+ *   - Gera exatamente a mesma AST do Bison e os mesmos erros
+ *     (mensagem, linha:coluna e recuperação até o próximo ';');
+ *   - Reentrante: todo o estado fica em ctx e na pilha.
+ * ========================================================= */
+
+/* Analisa ctx->src (ou ctx->tokens) e guarda a raiz em ctx->ast.
+ * Retorna como o yyparse: 0 = aceito (pode ter erros recuperados,
+ * contados em ctx->errors), 1 = abortado, 2 = aninhamento excessivo. */
+int rd_parse(ParseContext *ctx);
+
+/* Uma instrução de nível superior (ver rd_parse_stmts).
+ * Posições em bytes dentro de ctx->src. */
+typedef struct {
+    Node  *node;       /* NULL para ';' isolado, erro léxico ou instrução inválida */
+    size_t start;      /* início do primeiro token */
+    size_t end;        /* fim do último token consumido */
+    size_t scan_end;   /* fim do último token lido (inclui o lookahead) */
+    int    errors;     /* erros reportados durante a instrução */
+    bool   lex_error;  /* leu um token ERROR (o lexer pode ter olhado até o fim) */
+} RdStmt;
+
+/* Recebe cada instrução (e a posse do nó); false interrompe a análise */
+typedef bool (*RdStmtFn)(const RdStmt *stmt, void *user);
+
+/* Como rd_parse, mas entrega as instruções de nível superior uma a uma
+ * com as posições de cada uma, em vez de montar o bloco do programa.
+ * Usado pela reanálise incremental (incremental.h). */
+int rd_parse_stmts(ParseContext *ctx, RdStmtFn fn, void *user);
+
+#endif /* PARSER_RD_H */
@@ -0,0 +1,73 @@
+#ifndef RESOLVE_H
+#define RESOLVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ast_base.h"
+#include "ast_compact.h"
+
+/* =========================================================
+ * Resolução de nomes
+ *   - Liga cada ND_IDENT / ND_ASSIGN à declaração visível (ND_DECL ou
+ *     parâmetro), com os escopos da análise semântica: blocos e funções
+ *     abrem escopo, o for não; o inicializador de uma declaração ainda
+ *     enxerga o nome de fora;
+ *   - Cada declaração ganha um slot (VarRef, ast_base.h): índice denso na
+ *     sua unidade — a função (parâmetros primeiro: 0..n-1) ou o código
+ *     global (VAR_GLOBAL). As fases seguintes indexam arrays pelo slot
+ *     em vez de procurar o nome;
+ *   - Declarações que escondem outra visível levam VAR_SHADOWS; uma
+ *     redeclaração no mesmo escopo leva VAR_REDECLARED e aponta para a
+ *     primeira. Um nome sem declaração ganha um vínculo implícito no
+ *     escopo do primeiro uso (VAR_UNDECLARED em todos os usos);
+ *   - Incremental, uma instrução de nível superior por vez (como
+ *     ast_fold.h): as globais declaradas valem para as seguintes;
+ *   - Funções: um registro de assinaturas indexado pelo nome internado.
+ *     resolve_declare_functions() é o pré-passo sobre as funções de nível
+ *     superior (índices 0..n-1, na ordem do fonte), que ficam visíveis
+ *     desde o início: chamadas adiantadas e recursão mútua resolvem. Uma
+ *     função não declarada antes (aninhada, ou sem o pré-passo) entra no
+ *     registro quando é encontrada. Cada ND_CALL recebe o índice da
+ *     função chamada (FN_UNRESOLVED se o nome não é de função);
+ *   - Os nós são anotados no lugar. Nós compartilhados (NODE_SHARED)
+ *     são imutáveis: uma instrução que usa um identificador
+ *     compartilhado é resolvida sobre uma cópia.
+ * ========================================================= */
+
+typedef struct Resolver Resolver;
+
+/* Assinatura de uma função registrada */
+typedef struct {
+    const char *name;
+    TypeTag     ret;
+    TypeTag    *params;
+    size_t      param_count;
+} FunSig;
+
+Resolver *resolve_new(void);
+void resolve_free(Resolver *rs);
+
+/* Resolve uma instrução de nível superior e a devolve anotada: a própria
+ * `stmt` ou uma cópia (válida até a próxima chamada) */
+Node *resolve_stmt(Resolver *rs, Node *stmt);
+
+/* Com `keep`, as cópias de resolve_stmt() valem até resolve_free(): para
+ * resolver todas as instruções antes de usá-las */
+void resolve_keep_copies(Resolver *rs, bool keep);
+
+/* Pré-passo: registra as funções de nível superior do programa (bloco
+ * raiz), antes da primeira instrução. Com nomes repetidos, as chamadas
+ * vão para a última definição. */
+void resolve_declare_functions(Resolver *rs, const Node *root);
+void resolve_declare_functions_compact(Resolver *rs, const CompactAst *ast);
+
+/* Assinatura da função `index` (ND_CALL.fn_index); NULL se não houver */
+const FunSig *resolve_function(const Resolver *rs, int32_t index);
+int32_t resolve_function_count(const Resolver *rs);
+
+/* Slots da unidade global até agora / maior número de slots locais entre
+ * as funções (inclusive aninhadas) da última instrução resolvida */
+int32_t resolve_global_count(const Resolver *rs);
+int32_t resolve_local_count(const Resolver *rs);
+
+#endif /* RESOLVE_H */
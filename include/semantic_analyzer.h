@@ -13,4 +13,24 @@ int check_semantics(Node *root, SymbolTable *table);
 /* Retorna 1 se não há erros, 0 se há erros. */
 int semantics_ok(Node *root, SymbolTable *table);
 
+/* Mesma análise (e mesmas mensagens) sobre a AST compacta: cada instrução
+ * de nível superior é montada como Node numa arena temporária, verificada
+ * e descartada. */
+struct CompactAst;
+int check_semantics_compact(const struct CompactAst *ast, SymbolTable *table);
+
+/* Verificação passo a passo, para quem já resolve as instruções de
+ * nível superior (a passada única de verificação e IR, ir_builder.h):
+ * check_begin() com o resolvedor (funções já declaradas), depois
+ * check_resolved_stmt() com cada instrução devolvida por resolve_stmt(),
+ * na ordem; devolve os erros dela. */
+struct Resolver;
+void check_begin(struct Resolver *rs, SymbolTable *table);
+int  check_resolved_stmt(struct Resolver *rs, Node *stmt);
+void check_end(void);
+
+/* Tipo do resultado de um operador binário (TY_INVALID se os operandos
+ * não combinam): a regra da verificação, reaproveitada por ast_fold.c */
+TypeTag infer_binary(BinOp op, TypeTag left, TypeTag right);
+
 #endif
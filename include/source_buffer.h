@@ -0,0 +1,34 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Trecho do código-fonte (não terminado em '\0') */
+typedef struct {
+    const char *ptr;
+    size_t      len;
+} SrcSlice;
+
+/* Código-fonte inteiro em memória, pronto para o yy_scan_buffer.
+ * - Arquivos são mapeados com mmap (MAP_PRIVATE) sempre que possível;
+ * - stdin (ou arquivo que não pode ser mapeado) é lido uma única vez.
+ * Em ambos os casos data[len] e data[len + 1] valem '\0', como o Flex exige.
+ */
+typedef struct {
+    char  *data;
+    size_t len;       /* tamanho do fonte (sem os dois '\0' finais) */
+    size_t map_len;   /* tamanho mapeado (0 se data veio do malloc) */
+} SourceBuffer;
+
+/**
+ * @brief Carrega o fonte de um caminho de arquivo ou stdin.
+ * @param path Caminho do arquivo; se NULL ou "--", lê de stdin.
+ * @return true em caso de sucesso (erros já são reportados via perror).
+ */
+bool source_open(SourceBuffer *sb, const char *path);
+
+/* Libera (ou desmapeia) o buffer */
+void source_close(SourceBuffer *sb);
+
+#endif /* SOURCE_BUFFER_H */
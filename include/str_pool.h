@@ -0,0 +1,34 @@
+#ifndef STR_POOL_H
+#define STR_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* =========================================================
+ * Pool de literais de string (um por compilação)
+ *   - Cada literal distinto (já sem escapes) é guardado uma única
+ *     vez, com o tamanho e terminado em '\0';
+ *   - AST (ND_STRING) e IR (IR_OPER_STRING) guardam só o índice;
+ *     o texto é estável até str_pool_free;
+ *   - Índices densos (0, 1, 2, ...) na ordem em que os literais
+ *     aparecem no fonte;
+ *   - Diferente de intern.h, não é global nem usa lock: cada análise
+ *     (ParseContext) tem o seu.
+ * ========================================================= */
+
+typedef struct StrPool StrPool;
+
+StrPool *str_pool_new(void);
+void     str_pool_free(StrPool *pool);
+
+/* Índice de `len` bytes de `s` (podem conter '\0'); copia só se for novo */
+uint32_t str_pool_add(StrPool *pool, const char *s, size_t len);
+
+/* Texto (terminado em '\0') e tamanho do literal `id` */
+const char *str_pool_get(const StrPool *pool, uint32_t id);
+size_t      str_pool_len(const StrPool *pool, uint32_t id);
+
+/* Quantidade de literais distintos (limite superior dos índices) */
+size_t str_pool_count(const StrPool *pool);
+
+#endif /* STR_POOL_H */
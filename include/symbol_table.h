@@ -5,19 +5,34 @@
 #include "ast_base.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
+/* Todos os `name` recebidos/guardados são nomes internados (intern.h):
+ * a comparação é feita por ponteiro e o hash vem pré-calculado. */
 typedef struct Symbol {
-    char *name;
+    const char *name;
     TypeTag type;
     Node *value;
-    struct Symbol *next;
 } Symbol;
 
+/* Posição da tabela de hash: hash do nome guardado (compara e mede a
+ * distância sem tocar no símbolo) e índice do símbolo + 1 (0 = vazia) */
+typedef struct SymSlot {
+    uint32_t hash;
+    uint32_t sym;
+} SymSlot;
+
+/* Endereçamento aberto com Robin Hood: capacidade potência de 2, cresce
+ * (dobra) acima de 3/4 de ocupação; os símbolos ficam contíguos em
+ * `symbols`, na ordem de inserção (remoção move o último para o buraco).
+ * Tabelas vazias não alocam nada (escopos de blocos sem declarações). */
 typedef struct SymbolTable {
-    Symbol **buckets;
-    size_t size;
-    size_t capacity;
-    struct SymbolTable *parent; // para escopos
+    Symbol  *symbols;
+    size_t   size;
+    size_t   symbols_cap;
+    SymSlot *slots;
+    size_t   capacity;              // posições em `slots`
+    struct SymbolTable *parent;     // para escopos
 } SymbolTable;
 
 // Cria uma nova tabela de símbolos
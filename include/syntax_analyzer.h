@@ -2,15 +2,63 @@
 #define SYNTAX_ANALYZER_H
 
 #include <stdio.h>
+#include <stdbool.h>
 #include "ast_base.h"
+#include "str_pool.h"
 
 // Resultado padronizado da fase sintática
 typedef struct {
     int parse_ok;       // 1 = sucesso sintático; 0 = falha
     int parse_errors;   // contador de erros de parser
     Node *ast;          // AST raiz (nulo se parse falhar)
+    StrPool *strings;   // literais de string referenciados pela AST
+    struct Arena *arena; // memória de todos os nós da AST (arena.h)
+    struct CompactAst *compact; // AST compacta (ASTEROIDS_AST=compact); `ast` fica NULL
+    struct HashCons *hashcons;  // expressões compartilhadas (ASTEROIDS_AST=shared), nós na `arena`
 } SyntaxResult;
 
+/**
+ * @brief Libera a AST (de uma vez, junto com a arena), a AST compacta
+ *        e o pool de literais.
+ */
+void syntax_result_free(SyntaxResult *r);
+
+/**
+ * @brief AST em Node: a própria `ast` ou, no modo compacto, a árvore
+ *        montada a partir de `compact` (na arena do resultado, só na
+ *        primeira chamada). Para quem ainda não lê a AST compacta.
+ */
+Node *syntax_result_ast(SyntaxResult *r);
+
+/**
+ * @brief Formato da AST produzida: ASTEROIDS_AST=compact guarda só a AST
+ *        compacta (ast_compact.h). Com o parser escrito à mão cada instrução
+ *        de nível superior é convertida e descartada assim que termina,
+ *        então a árvore de Node inteira nunca fica em memória.
+ */
+bool syntax_use_compact(void);
+
+/**
+ * @brief ASTEROIDS_AST=shared: as expressões (literais, nomes, unárias e
+ *        binárias) são construídas por hash-consing (ast_hashcons.h), então
+ *        subexpressões iguais são um nó só. A tabela vai no resultado e
+ *        continua valendo para cópias e comparações na arena da AST.
+ */
+bool syntax_use_shared(void);
+
+// Implementação do parser
+typedef enum {
+    PARSER_RD,      // parser_rd.c, escrito à mão (padrão)
+    PARSER_BISON    // parser.y
+} ParserKind;
+
+/**
+ * @brief Parser usado pelas funções abaixo: ASTEROIDS_PARSER=bison|rd
+ *        (padrão: rd). Os dois produzem a mesma AST e os mesmos erros.
+ */
+ParserKind syntax_default_parser(void);
+const char *syntax_parser_name(ParserKind kind);
+
 /**
  * @brief Executa a análise sintática a partir de um caminho de arquivo ou stdin.
  * @param path Caminho do arquivo; se NULL ou "--", lê de stdin.
@@ -18,4 +66,24 @@ typedef struct {
  */
 SyntaxResult syntax_parse_path(const char *path);
 
+/**
+ * @brief Executa a análise sintática a partir de um fluxo de tokens binário
+ *        (token_stream.h), sem tokenizar o fonte de novo.
+ * @param tok_path Arquivo de tokens (gerado por `scanner --dump`).
+ * @param src_path Fonte correspondente; se NULL, usa só o arquivo de tokens.
+ *        Se informado e o arquivo de tokens estiver ausente ou não
+ *        corresponder mais ao fonte, o fonte é tokenizado e o arquivo
+ *        de tokens é regravado.
+ * @return SyntaxResult com status e AST (se sucesso).
+ */
+SyntaxResult syntax_parse_tokens(const char *tok_path, const char *src_path);
+
+struct TokenStream;
+
+/**
+ * @brief Analisa um fluxo de tokens já carregado com o parser indicado
+ *        (o fluxo continua pertencendo a quem chamou). Usado no benchmark.
+ */
+SyntaxResult syntax_parse_stream(struct TokenStream *tokens, ParserKind parser);
+
 #endif
@@ -0,0 +1,126 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "parse_context.h"
+#include "source_buffer.h"
+
+/* =========================================================
+ * Fluxo de tokens em formato binário
+ *   - Resultado completo da análise léxica de um fonte: tipo, posição,
+ *     linha/coluna e valor (payload) de cada token;
+ *   - Pode ser gravado em disco e lido de volta (mmap), para que o
+ *     parser consuma os tokens sem tokenizar o fonte de novo;
+ *   - O cabeçalho guarda tamanho e hash do fonte, então dá para saber
+ *     se o arquivo de tokens ainda corresponde ao fonte atual.
+ *
+ * Layout (ordem de bytes da máquina):
+ *   TokenFileHeader
+ *   TokenRecord[token_count]
+ *   double[float_count]  (valores dos FLOAT_LIT)
+ *   nomes:   name_count x (uint32 tamanho + bytes)
+ *   strings: conteúdo bruto (com escapes) dos literais de string
+ * ========================================================= */
+
+#define TOKEN_FILE_MAGIC   0x4b545341u   /* "ASTK" */
+#define TOKEN_FILE_VERSION 1u
+
+/* Tipos especiais (além dos tokens do Bison) */
+#define TOKSTREAM_EOF    0u       /* fim da entrada: guarda linha/coluna finais */
+#define TOKSTREAM_FATAL  0xffffu  /* comentário multilinha não fechado */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t src_len;
+    uint64_t src_hash;
+    uint32_t token_count;
+    uint32_t name_count;
+    uint32_t names_bytes;
+    uint32_t strings_bytes;
+    uint32_t float_count;
+    uint32_t reserved;
+} TokenFileHeader;
+
+/* Um token (24 bytes). Linha e coluna são as do lexer DEPOIS do token,
+ * como o parser as vê ao reportar erros. */
+typedef struct {
+    uint32_t offset;    /* posição do lexema no fonte */
+    uint32_t length;    /* tamanho do lexema */
+    uint32_t line;
+    uint32_t column;
+    uint16_t kind;      /* token do Bison, TOKSTREAM_EOF ou TOKSTREAM_FATAL */
+    uint16_t reserved;
+    uint32_t payload;   /* int, bool, índice do double ou do nome, posição
+                           na área de strings ou byte inválido (ERROR) */
+} TokenRecord;
+
+typedef struct TokenStream {
+    uint64_t     src_len;
+    uint64_t     src_hash;
+
+    const TokenRecord *toks;     /* termina com um TOKSTREAM_EOF ou _FATAL */
+    size_t             count;
+
+    const double *floats;        /* valores dos FLOAT_LIT, por índice */
+    size_t        float_count;
+
+    const char **names;          /* nomes internados, por índice */
+    size_t       name_count;
+
+    const char  *strings;        /* conteúdo bruto dos literais de string */
+    size_t       strings_len;
+
+    /* posse da memória */
+    SourceBuffer file;           /* arquivo mapeado (token_stream_load) */
+    TokenRecord *owned_toks;     /* ou arrays próprios (token_stream_build) */
+    double      *owned_floats;
+} TokenStream;
+
+/* Hash (FNV-1a, 64 bits) usado para identificar o fonte */
+uint64_t token_stream_hash(const char *data, size_t len);
+
+/* Tokeniza `src` inteiro com o scanner `kind`.
+ * Erros léxicos não são impressos: ficam gravados e são reportados
+ * quando o parser consumir o token (mesma ordem do lexer normal).
+ * Os literais de string apontam para `src`, que precisa continuar
+ * válido enquanto o fluxo for usado. */
+TokenStream *token_stream_build(const SourceBuffer *src, LexerKind kind);
+
+/* Mesmo resultado de token_stream_build, mas tokenizando em até `threads`
+ * pedaços em paralelo. Os pedaços começam em quebras de linha fora de
+ * comentários e strings (pré-varredura) e têm pelo menos `min_chunk`
+ * bytes; tokens, linhas, colunas e erros ficam idênticos aos do lexer
+ * serial. */
+TokenStream *token_stream_build_parallel(const SourceBuffer *src, LexerKind kind,
+                                         int threads, size_t min_chunk);
+
+/* Configuração da tokenização paralela no syntax_parse_path:
+ *   ASTEROIDS_LEX_THREADS=N    até N pedaços (0 ou 1: serial, o padrão)
+ *   ASTEROIDS_LEX_MIN_CHUNK=B  tamanho mínimo de cada pedaço, em bytes */
+#define TOKSTREAM_MIN_CHUNK (1024 * 1024)
+int    token_stream_env_threads(void);
+size_t token_stream_env_min_chunk(void);
+
+/* Grava / lê o formato binário; false/NULL em caso de erro */
+bool         token_stream_save(const TokenStream *ts, const char *path);
+TokenStream *token_stream_load(const char *path);
+
+/* O fluxo foi gerado a partir deste fonte? (tamanho + hash) */
+bool token_stream_matches(const TokenStream *ts, const SourceBuffer *src);
+
+void token_stream_free(TokenStream *ts);
+
+/* --- Reprodução (LEXER_REPLAY, ver lexer.c) --- */
+
+union YYSTYPE;
+
+/* Próximo token do fluxo em ctx->tokens (0 no fim) */
+int token_stream_next(union YYSTYPE *lval, ParseContext *ctx);
+
+/* Registro do último token entregue */
+const TokenRecord *token_stream_current(const ParseContext *ctx);
+
+#endif /* TOKEN_STREAM_H */
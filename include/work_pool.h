@@ -0,0 +1,25 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <stddef.h>
+
+/* =========================================================
+ * Pool de threads com roubo de trabalho (work stealing)
+ *   - Roda `count` tarefas independentes, numeradas 0..count-1, em até
+ *     `threads` threads (a que chama é uma delas);
+ *   - Cada thread começa com um trecho contínuo das tarefas e as pega
+ *     pela frente; quem esvazia o seu rouba a metade final do trecho de
+ *     outra, então tarefas de custo desigual não deixam threads paradas;
+ *   - As tarefas são todas conhecidas no início (nenhuma cria outra):
+ *     uma thread termina quando não acha trabalho em nenhum trecho;
+ *   - `worker_exit` (opcional) roda em cada thread depois da última
+ *     tarefa dela, para liberar o estado mantido por thread.
+ * ========================================================= */
+
+typedef void (*WorkPoolTask)(void *ctx, size_t task);
+typedef void (*WorkPoolExit)(void *ctx);
+
+void work_pool_run(size_t count, int threads,
+                   WorkPoolTask run, WorkPoolExit worker_exit, void *ctx);
+
+#endif /* WORK_POOL_H */
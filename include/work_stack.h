@@ -0,0 +1,69 @@
+#ifndef WORK_STACK_H
+#define WORK_STACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* =========================================================
+ * Pilha de trabalho das travessias iterativas da AST
+ *   - Substitui a recursão: a profundidade da árvore (ex.: `a+a+...+a`
+ *     com 10^6 termos) não consome mais a pilha nativa;
+ *   - Começa num buffer fornecido por quem chama (normalmente um array
+ *     local) e só passa para o heap se ele encher, então árvores comuns
+ *     não alocam nada;
+ *   - Elementos de tamanho fixo (`elem`), um tipo de quadro por travessia.
+ * ========================================================= */
+
+typedef struct {
+    char  *items;
+    size_t count;
+    size_t cap;     /* em elementos */
+    size_t elem;
+    bool   heap;    /* items foi alocado (não é o buffer inicial) */
+} WorkStack;
+
+static inline void ws_init(WorkStack *s, void *buf, size_t buf_bytes, size_t elem) {
+    s->items = (char*)buf;
+    s->count = 0;
+    s->cap   = buf_bytes / elem;
+    s->elem  = elem;
+    s->heap  = false;
+}
+
+/* Novo elemento no topo (não inicializado); o ponteiro vale até o próximo push */
+static inline void *ws_push(WorkStack *s) {
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 64;
+        char *items = (char*)(s->heap ? realloc(s->items, cap * s->elem) : malloc(cap * s->elem));
+        if (!items) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+        if (!s->heap && s->count) memcpy(items, s->items, s->count * s->elem);
+        s->items = items;
+        s->cap = cap;
+        s->heap = true;
+    }
+    return s->items + s->elem * s->count++;
+}
+
+static inline void *ws_top(WorkStack *s) {
+    return s->items + s->elem * (s->count - 1);
+}
+
+static inline void ws_pop(WorkStack *s) {
+    s->count--;
+}
+
+static inline bool ws_empty(const WorkStack *s) {
+    return s->count == 0;
+}
+
+static inline void ws_free(WorkStack *s) {
+    if (s->heap) free(s->items);
+    s->items = NULL;
+    s->count = s->cap = 0;
+    s->heap = false;
+}
+
+#endif /* WORK_STACK_H */
@@ -0,0 +1,68 @@
+#include "arena.h"
+#include "ast_base.h"
+
+#include <stdlib.h>
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t cap;
+    _Alignas(8) char data[];
+} ArenaBlock;
+
+struct Arena {
+    ArenaBlock *blocks;     /* bloco atual primeiro */
+    size_t      next_cap;   /* capacidade do próximo bloco */
+};
+
+Arena *arena_new(void) {
+    Arena *arena = (Arena*)xmalloc(sizeof(Arena));
+    arena->blocks = NULL;
+    arena->next_cap = ARENA_FIRST_BLOCK;
+    return arena;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+
+    ArenaBlock *b = arena->blocks;
+    if (!b || b->cap - b->used < size) {
+        size_t cap = arena->next_cap;
+        if (cap < ARENA_MAX_BLOCK) arena->next_cap = cap * 2;
+        if (cap < size) cap = size;
+
+        b = (ArenaBlock*)xmalloc(sizeof(ArenaBlock) + cap);
+        b->next = arena->blocks;
+        b->used = 0;
+        b->cap  = cap;
+        arena->blocks = b;
+    }
+
+    void *p = b->data + b->used;
+    b->used += size;
+    return p;
+}
+
+void arena_reset(Arena *arena) {
+    ArenaBlock *keep = arena->blocks;   /* o mais novo é o maior */
+    if (!keep) return;
+    ArenaBlock *b = keep->next;
+    while (b) {
+        ArenaBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+}
+
+void arena_free(Arena *arena) {
+    if (!arena) return;
+    ArenaBlock *b = arena->blocks;
+    while (b) {
+        ArenaBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    free(arena);
+}
@@ -1,4 +1,7 @@
 #include "ast_base.h"
+#include "arena.h"
+#include "ast_hashcons.h"
+#include "work_stack.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,16 +20,89 @@ char *xstrdup(const char *string) {
   return p;
 }
 
+char *xstrndup(const char *string, size_t n) {
+  char *p = (char *)xmalloc(n + 1);
+  memcpy(p, string, n);
+  p[n] = '\0';
+  return p;
+}
+
+/* Arena corrente (uma por thread: análises em paralelo não se misturam) */
+static _Thread_local Arena *g_arena = NULL;
+
+Arena *ast_set_arena(Arena *arena) {
+  Arena *prev = g_arena;
+  g_arena = arena;
+  return prev;
+}
+
+Arena *ast_get_arena(void) {
+  return g_arena;
+}
+
+void *ast_alloc(size_t size) {
+  return g_arena ? arena_alloc(g_arena, size) : xmalloc(size);
+}
+
 Node *new_node(NodeKind kind) {
-  struct Node *node = (struct Node *)xmalloc(sizeof(struct Node));
+  struct Node *node = (struct Node *)ast_alloc(sizeof(struct Node));
   node->kind = kind;
+  node->flags = g_arena ? NODE_ARENA : 0;
+  node->type = TY_INVALID;
   return node;
 }
 
+Node *ast_copy_to(Arena *arena, Node *node) {
+  Arena *prev = ast_set_arena(arena);
+  Node *copy = ast_copy(node);
+  ast_set_arena(prev);
+  return copy;
+}
+
+/* Cópia pendente: `src` vai para `*dst` (no nó pai já copiado) */
+typedef struct {
+  const Node *src;
+  Node      **dst;
+} CopyTask;
+
+static inline void copy_push(WorkStack *s, const Node *src, Node **dst) {
+  if (!src) { *dst = NULL; return; }
+  if ((src->flags & NODE_SHARED) && hashcons_owns(src)) { *dst = (Node *)src; return; }
+  CopyTask *t = (CopyTask *)ws_push(s);
+  t->src = src;
+  t->dst = dst;
+}
+
+/* Array de filhos com o tamanho exato; empilhados do último para o
+ * primeiro, para serem copiados na ordem original */
+static Node **copy_list(WorkStack *s, Node *const *items, size_t count) {
+  if (count == 0) return NULL;
+  Node **list = (Node **)ast_alloc(sizeof(Node *) * count);
+  for (size_t i = count; i-- > 0; )
+    copy_push(s, items[i], &list[i]);
+  return list;
+}
+
+/* Iterativo e em pré-ordem: cada nó é alocado antes dos filhos, que são
+ * empilhados do último para o primeiro (a cópia sai contígua na ordem
+ * de visita). Profundidade limitada só pela memória. Expressões
+ * compartilhadas pela tabela ativa (ast_hashcons.h) não são copiadas:
+ * a cópia aponta para o mesmo nó. */
 Node *ast_copy(Node *node) {
-    if (!node) return NULL;
+  Node *root = NULL;
+  CopyTask buf[64];
+  WorkStack stack;
+  ws_init(&stack, buf, sizeof buf, sizeof(CopyTask));
+  copy_push(&stack, node, &root);
+
+  while (!ws_empty(&stack)) {
+    CopyTask task = *(CopyTask *)ws_top(&stack);
+    ws_pop(&stack);
+    node = (Node *)task.src;
 
     Node *copy = new_node(node->kind);
+    copy->type = node->type;
+    *task.dst = copy;
 
     switch (node->kind) {
       case ND_INT:
@@ -42,96 +118,87 @@ Node *ast_copy(Node *node) {
         break;
 
       case ND_IDENT:
-        copy->u.as_ident.name = xstrdup(node->u.as_ident.name);
+        copy->u.as_ident = node->u.as_ident;
         break;
 
-      case ND_STRING:
-        copy->u.as_string.value = xstrdup(node->u.as_string.value);
+      case ND_STRING: /* a cópia referencia o mesmo literal do pool */
+        copy->u.as_string = node->u.as_string;
         break;
 
       case ND_UNARY:
-        copy->u.as_unary.op   = node->u.as_unary.op;
-        copy->u.as_unary.expr = ast_copy(node->u.as_unary.expr);
+        copy->u.as_unary.op = node->u.as_unary.op;
+        copy_push(&stack, node->u.as_unary.expr, &copy->u.as_unary.expr);
         break;
 
       case ND_BINARY:
-        copy->u.as_binary.op    = node->u.as_binary.op;
-        copy->u.as_binary.left  = ast_copy(node->u.as_binary.left);
-        copy->u.as_binary.right = ast_copy(node->u.as_binary.right);
+        copy->u.as_binary.op = node->u.as_binary.op;
+        copy_push(&stack, node->u.as_binary.right, &copy->u.as_binary.right);
+        copy_push(&stack, node->u.as_binary.left,  &copy->u.as_binary.left);
         break;
 
       case ND_BLOCK:
-        copy->u.as_block.count = node->u.as_block.count;
-        copy->u.as_block.stmts = xmalloc(sizeof(Node*) * node->u.as_block.count);
-        for (size_t i = 0; i < node->u.as_block.count; i++)
-            copy->u.as_block.stmts[i] = ast_copy(node->u.as_block.stmts[i]);
+        copy->u.as_block.count    = node->u.as_block.count;
+        copy->u.as_block.capacity = node->u.as_block.count;
+        copy->u.as_block.stmts    = copy_list(&stack, node->u.as_block.stmts, node->u.as_block.count);
         break;
 
       case ND_ASSIGN:
-        copy->u.as_assign.name  = xstrdup(node->u.as_assign.name);
-        copy->u.as_assign.value = ast_copy(node->u.as_assign.value);
+        copy->u.as_assign.name = node->u.as_assign.name;
+        copy->u.as_assign.ref  = node->u.as_assign.ref;
+        copy_push(&stack, node->u.as_assign.value, &copy->u.as_assign.value);
         break;
 
       case ND_EXPR:
-        copy->u.as_expr.expr = ast_copy(node->u.as_expr.expr);
+        copy_push(&stack, node->u.as_expr.expr, &copy->u.as_expr.expr);
         break;
 
       case ND_IF:
-        copy->u.as_if.cond        = ast_copy(node->u.as_if.cond);
-        copy->u.as_if.then_branch = ast_copy(node->u.as_if.then_branch);
-        copy->u.as_if.else_branch = ast_copy(node->u.as_if.else_branch);
+        copy_push(&stack, node->u.as_if.else_branch, &copy->u.as_if.else_branch);
+        copy_push(&stack, node->u.as_if.then_branch, &copy->u.as_if.then_branch);
+        copy_push(&stack, node->u.as_if.cond,        &copy->u.as_if.cond);
         break;
 
       case ND_DECL:
         copy->u.as_decl.type = node->u.as_decl.type;
-        copy->u.as_decl.name = xstrdup(node->u.as_decl.name);
-        copy->u.as_decl.init = node->u.as_decl.init ? ast_copy(node->u.as_decl.init) : NULL;
+        copy->u.as_decl.name = node->u.as_decl.name;
+        copy->u.as_decl.ref  = node->u.as_decl.ref;
+        copy_push(&stack, node->u.as_decl.init, &copy->u.as_decl.init);
         break;
 
       case ND_WHILE:
-        copy->u.as_while.cond = ast_copy(node->u.as_while.cond);
-        copy->u.as_while.body = ast_copy(node->u.as_while.body);
+        copy_push(&stack, node->u.as_while.body, &copy->u.as_while.body);
+        copy_push(&stack, node->u.as_while.cond, &copy->u.as_while.cond);
         break;
 
       case ND_FOR:
-        copy->u.as_for.init = ast_copy(node->u.as_for.init);
-        copy->u.as_for.cond = ast_copy(node->u.as_for.cond);
-        copy->u.as_for.step = ast_copy(node->u.as_for.step);
-        copy->u.as_for.body = ast_copy(node->u.as_for.body);
+        copy_push(&stack, node->u.as_for.body, &copy->u.as_for.body);
+        copy_push(&stack, node->u.as_for.step, &copy->u.as_for.step);
+        copy_push(&stack, node->u.as_for.cond, &copy->u.as_for.cond);
+        copy_push(&stack, node->u.as_for.init, &copy->u.as_for.init);
         break;
 
       case ND_FUNCTION:
         copy->u.as_function.ret_type    = node->u.as_function.ret_type;
-        copy->u.as_function.name        = xstrdup(node->u.as_function.name);
+        copy->u.as_function.name        = node->u.as_function.name;
         copy->u.as_function.param_count = node->u.as_function.param_count;
-
-        if (node->u.as_function.param_count > 0) {
-            copy->u.as_function.params = xmalloc(sizeof(Node*) * node->u.as_function.param_count);
-            for (size_t i = 0; i < node->u.as_function.param_count; i++)
-                copy->u.as_function.params[i] = ast_copy(node->u.as_function.params[i]);
-        } else {
-            copy->u.as_function.params = NULL;
-        }
-
-        copy->u.as_function.body = ast_copy(node->u.as_function.body);
+        copy_push(&stack, node->u.as_function.body, &copy->u.as_function.body);
+        copy->u.as_function.params = copy_list(&stack, node->u.as_function.params,
+                                               node->u.as_function.param_count);
         break;
 
       case ND_RETURN:
-        copy->u.as_return.expr = ast_copy(node->u.as_return.expr);
+        copy_push(&stack, node->u.as_return.expr, &copy->u.as_return.expr);
         break;
 
       case ND_CALL:
-        copy->u.as_call.name      = xstrdup(node->u.as_call.name);
+        copy->u.as_call.name      = node->u.as_call.name;
         copy->u.as_call.arg_count = node->u.as_call.arg_count;
-
-        if (node->u.as_call.arg_count > 0) {
-            copy->u.as_call.args = xmalloc(sizeof(Node*) * node->u.as_call.arg_count);
-            for (size_t i = 0; i < node->u.as_call.arg_count; i++)
-                copy->u.as_call.args[i] = ast_copy(node->u.as_call.args[i]);
-        } else {
-            copy->u.as_call.args = NULL;
-        }
+        copy->u.as_call.fn_index  = node->u.as_call.fn_index;
+        copy->u.as_call.args      = copy_list(&stack, node->u.as_call.args, node->u.as_call.arg_count);
         break;
     }
-    return copy;
+  }
+
+  ws_free(&stack);
+  return root;
 }
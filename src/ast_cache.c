@@ -0,0 +1,367 @@
+#include "ast_cache.h"
+#include "intern.h"
+#include "token_stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Arrays de payload, na ordem do arquivo (counts[] do cabeçalho) */
+static void payload_vecs(CompactAst *a, CastVec *out[AST_CACHE_ARRAYS]) {
+    CastVec *vecs[AST_CACHE_ARRAYS] = {
+        &a->lists, &a->ints, &a->floats, &a->unary, &a->binary, &a->blocks,
+        &a->assigns, &a->ifs, &a->decls, &a->whiles, &a->fors, &a->funcs, &a->calls
+    };
+    memcpy(out, vecs, sizeof vecs);
+}
+
+static const size_t payload_sizes[AST_CACHE_ARRAYS] = {
+    sizeof(CNode), sizeof(long), sizeof(double), sizeof(CUnary), sizeof(CBinary),
+    sizeof(CList), sizeof(CAssign), sizeof(CIf), sizeof(CDecl), sizeof(CWhile),
+    sizeof(CFor), sizeof(CFunction), sizeof(CCall)
+};
+
+/* Tamanhos dos registros e ordem de bytes: um cache de outra máquina
+ * (ou de outra versão dos structs) não é aproveitado */
+static uint32_t layout_tag(void) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < AST_CACHE_ARRAYS; i++) {
+        h ^= (uint32_t)payload_sizes[i];
+        h *= 16777619u;
+    }
+    const uint32_t probe = 0x01020304u;
+    h ^= *(const uint8_t*)&probe;
+    h *= 16777619u;
+    return h;
+}
+
+static inline size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+bool ast_cache_enabled(void) {
+    const char *env = getenv("ASTEROIDS_AST_CACHE");
+    return env && strcmp(env, "1") == 0;
+}
+
+char *ast_cache_path(const char *src_path) {
+    if (!src_path || strcmp(src_path, "--") == 0) return NULL;
+    size_t n = strlen(src_path), ext = strlen(AST_CACHE_EXT);
+    char *path = (char*)xmalloc(n + ext + 1);
+    memcpy(path, src_path, n);
+    memcpy(path + n, AST_CACHE_EXT, ext + 1);
+    return path;
+}
+
+/* =========================================================
+ * Gravação
+ * ========================================================= */
+
+static bool write_padded(FILE *f, const void *p, size_t bytes) {
+    static const char zeros[8] = { 0 };
+    size_t pad = align8(bytes) - bytes;
+    if (bytes && fwrite(p, 1, bytes, f) != bytes) return false;
+    return pad == 0 || fwrite(zeros, 1, pad, f) == pad;
+}
+
+static bool write_text(FILE *f, const char *s, size_t len) {
+    uint32_t n = (uint32_t)len;
+    return fwrite(&n, sizeof n, 1, f) == 1 && (n == 0 || fwrite(s, 1, n, f) == n);
+}
+
+bool ast_cache_save(const char *path, const CompactAst *ast, const StrPool *strings,
+                    uint64_t src_len, uint64_t src_hash) {
+    if (ast->root == CAST_NONE) return false;
+
+    CastVec *vecs[AST_CACHE_ARRAYS];
+    payload_vecs((CompactAst*)ast, vecs);
+    const char *const *names = (const char *const*)ast->names.items;
+    size_t string_count = strings ? str_pool_count(strings) : 0;
+
+    AstCacheHeader h;
+    memset(&h, 0, sizeof h);
+    h.magic = AST_CACHE_MAGIC;
+    h.version = AST_CACHE_VERSION;
+    h.src_len = src_len;
+    h.src_hash = src_hash;
+    h.layout = layout_tag();
+    h.node_count = ast->count;
+    h.root = ast->root;
+    h.name_count = ast->names.count;
+    h.string_count = (uint32_t)string_count;
+    for (uint32_t i = 0; i < h.name_count; i++)
+        h.names_bytes += sizeof(uint32_t) + (uint32_t)intern_len(names[i]);
+    for (size_t i = 0; i < string_count; i++)
+        h.strings_bytes += sizeof(uint32_t) + (uint32_t)str_pool_len(strings, (uint32_t)i);
+    for (size_t i = 0; i < AST_CACHE_ARRAYS; i++) h.counts[i] = vecs[i]->count;
+
+    /* grava ao lado e renomeia: outro processo nunca lê um arquivo pela metade */
+    size_t n = strlen(path);
+    char *tmp = (char*)xmalloc(n + 32);
+    snprintf(tmp, n + 32, "%s.%ld.tmp", path, (long)getpid());
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) { free(tmp); return false; }
+
+    bool ok = fwrite(&h, sizeof h, 1, f) == 1 &&
+              write_padded(f, ast->kind, ast->count) &&
+              write_padded(f, ast->data, (size_t)ast->count * sizeof(uint32_t));
+    for (size_t i = 0; ok && i < AST_CACHE_ARRAYS; i++)
+        ok = write_padded(f, vecs[i]->items, (size_t)vecs[i]->count * payload_sizes[i]);
+    for (uint32_t i = 0; ok && i < h.name_count; i++)
+        ok = write_text(f, names[i], intern_len(names[i]));
+    for (size_t i = 0; ok && i < string_count; i++)
+        ok = write_text(f, str_pool_get(strings, (uint32_t)i), str_pool_len(strings, (uint32_t)i));
+
+    if (fclose(f) != 0) ok = false;
+    if (ok) ok = rename(tmp, path) == 0;
+    if (!ok) remove(tmp);
+    free(tmp);
+    return ok;
+}
+
+/* =========================================================
+ * Leitura
+ * ========================================================= */
+
+/* Próximo texto de uma tabela (tamanho + bytes) dentro de [*p, end) */
+static bool read_text(const char **p, const char *end, const char **s, uint32_t *len) {
+    if ((size_t)(end - *p) < sizeof *len) return false;
+    memcpy(len, *p, sizeof *len);
+    *p += sizeof *len;
+    if ((size_t)(end - *p) < *len) return false;
+    *s = *p;
+    *p += *len;
+    return true;
+}
+
+/* =========================================================
+ * Validação
+ *   O cabeçalho só garante os tamanhos dos arrays; o conteúdo vem de um
+ *   arquivo que pode estar corrompido. Uma passada pelos nós confere
+ *   tudo o que cast_to_node e as fases seguintes usam sem checar:
+ *   - tipo de cada nó, payload dentro do array do tipo, nomes e
+ *     literais dentro das tabelas, operadores e tipos conhecidos,
+ *     trechos de `lists` dentro do array;
+ *   - cada filho (ou item de lista) é do tipo que o parser põe ali
+ *     (expressão, instrução, parâmetro ND_DECL, corpo ND_BLOCK), vem
+ *     depois do pai (pré-ordem; só a raiz, o último nó, aponta para
+ *     trás) e é filho de um só nó: a AST é uma árvore, sem ciclos.
+ * ========================================================= */
+
+typedef enum { WANT_EXPR, WANT_STMT, WANT_DECL, WANT_BLOCK } ChildKind;
+
+typedef struct {
+    const CompactAst *a;
+    uint8_t *used;      /* nó já é filho de alguém */
+    CNode    parent;
+} CacheCheck;
+
+static bool is_expr_kind(NodeKind k) {
+    switch (k) {
+        case ND_INT: case ND_FLOAT: case ND_BOOL: case ND_IDENT: case ND_STRING:
+        case ND_UNARY: case ND_BINARY: case ND_ASSIGN: case ND_CALL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool check_child(CacheCheck *c, CNode child, ChildKind want, bool optional) {
+    const CompactAst *a = c->a;
+    if (child == CAST_NONE) return optional;
+    if (child >= a->count || child == a->root || c->used[child]) return false;
+    if (c->parent != a->root && child <= c->parent) return false;
+    c->used[child] = 1;
+
+    NodeKind k = (NodeKind)a->kind[child];
+    switch (want) {
+        case WANT_EXPR:  return is_expr_kind(k);
+        case WANT_STMT:  return !is_expr_kind(k);
+        case WANT_DECL:  return k == ND_DECL;
+        case WANT_BLOCK: return k == ND_BLOCK;
+    }
+    return false;
+}
+
+static bool check_list(CacheCheck *c, CList l, ChildKind want) {
+    const CompactAst *a = c->a;
+    if (l.first > a->lists.count || l.count > a->lists.count - l.first) return false;
+    for (uint32_t i = 0; i < l.count; i++)
+        if (!check_child(c, cast_list_at(a, l, i), want, false)) return false;
+    return true;
+}
+
+static bool check_node(CacheCheck *c, CNode n, uint32_t string_count) {
+    const CompactAst *a = c->a;
+    uint32_t d = a->data[n];
+    uint32_t names = a->names.count;
+    c->parent = n;
+
+    switch ((NodeKind)a->kind[n]) {
+        case ND_INT:    return d < a->ints.count;
+        case ND_FLOAT:  return d < a->floats.count;
+        case ND_BOOL:   return d <= 1;
+        case ND_STRING: return d < string_count;
+        case ND_IDENT:  return d < names;
+        case ND_EXPR:   return check_child(c, d, WANT_EXPR, false);
+        case ND_RETURN: return check_child(c, d, WANT_EXPR, true);
+
+        case ND_UNARY: {
+            if (d >= a->unary.count) return false;
+            const CUnary *u = cast_unary(a, n);
+            return (unsigned)u->op <= UN_NOT && check_child(c, u->expr, WANT_EXPR, false);
+        }
+        case ND_BINARY: {
+            if (d >= a->binary.count) return false;
+            const CBinary *b = cast_binary(a, n);
+            return (unsigned)b->op <= BIN_OR &&
+                   check_child(c, b->left, WANT_EXPR, false) &&
+                   check_child(c, b->right, WANT_EXPR, false);
+        }
+        case ND_BLOCK:
+            return d < a->blocks.count && check_list(c, *cast_block(a, n), WANT_STMT);
+        case ND_ASSIGN: {
+            if (d >= a->assigns.count) return false;
+            const CAssign *s = cast_assign(a, n);
+            return s->name < names && check_child(c, s->value, WANT_EXPR, false);
+        }
+        case ND_IF: {
+            if (d >= a->ifs.count) return false;
+            const CIf *s = cast_if(a, n);
+            return check_child(c, s->cond, WANT_EXPR, false) &&
+                   check_child(c, s->then_branch, WANT_STMT, false) &&
+                   check_child(c, s->else_branch, WANT_STMT, true);
+        }
+        case ND_DECL: {
+            if (d >= a->decls.count) return false;
+            const CDecl *s = cast_decl(a, n);
+            return s->name < names && (unsigned)s->type <= TY_VOID &&
+                   check_child(c, s->init, WANT_EXPR, true);
+        }
+        case ND_WHILE: {
+            if (d >= a->whiles.count) return false;
+            const CWhile *s = cast_while(a, n);
+            return check_child(c, s->cond, WANT_EXPR, false) &&
+                   check_child(c, s->body, WANT_STMT, false);
+        }
+        case ND_FOR: {
+            if (d >= a->fors.count) return false;
+            const CFor *s = cast_for(a, n);
+            return check_child(c, s->init, WANT_EXPR, false) &&
+                   check_child(c, s->cond, WANT_EXPR, false) &&
+                   check_child(c, s->step, WANT_EXPR, false) &&
+                   check_child(c, s->body, WANT_STMT, false);
+        }
+        case ND_FUNCTION: {
+            if (d >= a->funcs.count) return false;
+            const CFunction *f = cast_function(a, n);
+            return f->name < names && (unsigned)f->ret_type <= TY_VOID &&
+                   check_list(c, f->params, WANT_DECL) &&
+                   check_child(c, f->body, WANT_BLOCK, false);
+        }
+        case ND_CALL: {
+            if (d >= a->calls.count) return false;
+            const CCall *s = cast_call(a, n);
+            return s->name < names && check_list(c, s->args, WANT_EXPR);
+        }
+    }
+    return false;   /* tipo desconhecido */
+}
+
+static bool cache_valid(const CompactAst *a, uint32_t string_count) {
+    if (a->root != a->count - 1 || a->kind[a->root] != ND_BLOCK) return false;
+
+    CacheCheck c = { a, (uint8_t*)calloc(a->count, 1), CAST_NONE };
+    if (!c.used) return false;
+    bool ok = true;
+    for (CNode n = 0; ok && n < a->count; n++) ok = check_node(&c, n, string_count);
+    free(c.used);
+    return ok;
+}
+
+CompactAst *ast_cache_load(const char *path, uint64_t src_len, uint64_t src_hash,
+                           StrPool **strings) {
+    *strings = NULL;
+    if (access(path, R_OK) != 0) return NULL;
+
+    SourceBuffer file;
+    if (!source_open(&file, path)) return NULL;
+
+    AstCacheHeader h;
+    if (file.len < sizeof h) goto stale;
+    memcpy(&h, file.data, sizeof h);
+    if (h.magic != AST_CACHE_MAGIC || h.version != AST_CACHE_VERSION ||
+        h.layout != layout_tag() || h.src_len != src_len || h.src_hash != src_hash ||
+        h.root >= h.node_count) goto stale;
+
+    /* o tamanho tem que bater exatamente com o cabeçalho */
+    size_t offs[AST_CACHE_ARRAYS];
+    size_t kind_off = sizeof h;
+    size_t data_off = kind_off + align8(h.node_count);
+    size_t end = data_off + align8((size_t)h.node_count * sizeof(uint32_t));
+    for (size_t i = 0; i < AST_CACHE_ARRAYS; i++) {
+        offs[i] = end;
+        end += align8((size_t)h.counts[i] * payload_sizes[i]);
+    }
+    size_t names_off = end;
+    if (end + h.names_bytes + h.strings_bytes != file.len) goto stale;
+
+    CompactAst *a = cast_new(NULL);
+    char *base = file.data;
+
+    /* os arrays são usados direto do arquivo (o cabeçalho tem tamanho
+     * múltiplo de 8 e o mmap/malloc é alinhado) */
+    a->kind = (uint8_t*)(base + kind_off);
+    a->data = (uint32_t*)(base + data_off);
+    a->count = a->cap = h.node_count;
+    a->root = h.root;
+
+    CastVec *vecs[AST_CACHE_ARRAYS];
+    payload_vecs(a, vecs);
+    for (size_t i = 0; i < AST_CACHE_ARRAYS; i++) {
+        vecs[i]->items = base + offs[i];
+        vecs[i]->count = vecs[i]->cap = h.counts[i];
+    }
+    a->file = file;
+
+    /* nomes e literais: internados / copiados para o pool desta análise */
+    const char *p = base + names_off;
+    const char *names_end = p + h.names_bytes;
+    const char **names = (const char**)xmalloc((h.name_count ? h.name_count : 1) * sizeof(char*));
+    a->names.items = (void*)names;
+    a->names.count = a->names.cap = h.name_count;
+    for (uint32_t i = 0; i < h.name_count; i++) {
+        const char *s;
+        uint32_t len;
+        if (!read_text(&p, names_end, &s, &len)) goto invalid;
+        names[i] = intern(s, len);
+    }
+
+    StrPool *pool = str_pool_new();
+    const char *strings_end = names_end + h.strings_bytes;
+    for (uint32_t i = 0; i < h.string_count; i++) {
+        const char *s;
+        uint32_t len;
+        if (!read_text(&p, strings_end, &s, &len) || str_pool_add(pool, s, len) != i) {
+            str_pool_free(pool);
+            goto invalid;
+        }
+    }
+    if (!cache_valid(a, h.string_count)) {
+        str_pool_free(pool);
+        goto invalid;
+    }
+    a->strings = pool;
+    *strings = pool;
+    return a;
+
+invalid:
+    cast_free(a);   /* desmapeia o arquivo */
+    return NULL;
+
+stale:
+    source_close(&file);
+    return NULL;
+}
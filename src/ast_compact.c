@@ -0,0 +1,543 @@
+#include "ast_compact.h"
+#include "work_stack.h"
+#include "intern.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAST_INITIAL_CAP 64
+
+/* =========================================================
+ * Arrays
+ * ========================================================= */
+static void vec_grow(CastVec *v, size_t elem) {
+    uint32_t cap = v->cap ? v->cap * 2 : CAST_INITIAL_CAP;
+    void *items = realloc(v->items, (size_t)cap * elem);
+    if (!items) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+    v->items = items;
+    v->cap = cap;
+}
+
+/* Reserva uma posição no fim e retorna o índice */
+static uint32_t vec_reserve(CastVec *v, size_t elem) {
+    if (v->count == v->cap) vec_grow(v, elem);
+    return v->count++;
+}
+
+static void vec_push_node(CastVec *v, CNode n) {
+    uint32_t i = vec_reserve(v, sizeof(CNode));
+    ((CNode*)v->items)[i] = n;
+}
+
+#define VEC_AT(v, T, i) (((T*)(v).items)[i])
+
+/* Devolve a folga do crescimento (a AST não muda mais) */
+static void vec_shrink(CastVec *v, size_t elem) {
+    if (v->count == v->cap) return;
+    if (v->count == 0) { free(v->items); v->items = NULL; v->cap = 0; return; }
+    void *items = realloc(v->items, (size_t)v->count * elem);
+    if (items) { v->items = items; v->cap = v->count; }
+}
+
+static size_t vec_bytes(const CastVec *v, size_t elem) {
+    return (size_t)v->cap * elem;
+}
+
+/* Reserva o nó (antes dos filhos: pré-ordem) */
+static CNode new_slot(CompactAst *a, NodeKind kind) {
+    if (a->count == a->cap) {
+        uint32_t cap = a->cap ? a->cap * 2 : CAST_INITIAL_CAP;
+        uint8_t  *k = (uint8_t*)realloc(a->kind, cap);
+        if (!k) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+        a->kind = k;
+        uint32_t *d = (uint32_t*)realloc(a->data, (size_t)cap * sizeof(uint32_t));
+        if (!d) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+        a->data = d;
+        a->cap = cap;
+    }
+    CNode n = a->count++;
+    a->kind[n] = (uint8_t)kind;
+    a->data[n] = 0;
+    return n;
+}
+
+/* Reserva `n` posições seguidas e retorna a primeira */
+static uint32_t vec_reserve_n(CastVec *v, size_t elem, uint32_t n) {
+    while (v->cap - v->count < n) vec_grow(v, elem);
+    uint32_t first = v->count;
+    v->count += n;
+    return first;
+}
+
+/* Índice de um nome internado na tabela `names` (um por nome distinto) */
+static uint32_t name_index(CompactAst *a, const char *name) {
+    if (!name) return CAST_NONE;
+    uint32_t id = intern_id(name);
+    if (id >= a->name_ids_cap) {
+        size_t cap = a->name_ids_cap ? a->name_ids_cap * 2 : CAST_INITIAL_CAP;
+        while (cap <= id) cap *= 2;
+        uint32_t *ids = (uint32_t*)realloc(a->name_ids, cap * sizeof(uint32_t));
+        if (!ids) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+        memset(ids + a->name_ids_cap, 0, (cap - a->name_ids_cap) * sizeof(uint32_t));
+        a->name_ids = ids;
+        a->name_ids_cap = cap;
+    }
+    if (!a->name_ids[id]) {
+        uint32_t i = vec_reserve(&a->names, sizeof(const char*));
+        VEC_AT(a->names, const char*, i) = name;
+        a->name_ids[id] = i + 1;
+    }
+    return a->name_ids[id] - 1;
+}
+
+/* =========================================================
+ * Criação / conversão
+ * ========================================================= */
+CompactAst *cast_new(const StrPool *strings) {
+    CompactAst *a = (CompactAst*)xmalloc(sizeof(CompactAst));
+    memset(a, 0, sizeof *a);
+    a->root = CAST_NONE;
+    a->strings = strings;
+    return a;
+}
+
+void cast_free(CompactAst *a) {
+    if (!a) return;
+    free(a->name_ids);
+    free(a->names.items);
+    if (a->file.data) {
+        /* carregada do cache: os demais arrays apontam para o arquivo */
+        source_close(&a->file);
+        free(a);
+        return;
+    }
+    free(a->kind);
+    free(a->data);
+    CastVec *vecs[] = {
+        &a->lists, &a->top, &a->ints, &a->floats,
+        &a->unary, &a->binary, &a->blocks, &a->assigns, &a->ifs, &a->decls,
+        &a->whiles, &a->fors, &a->funcs, &a->calls
+    };
+    for (size_t i = 0; i < sizeof vecs / sizeof vecs[0]; i++) free(vecs[i]->items);
+    free(a);
+}
+
+/* Onde gravar o índice de um nó ainda não convertido: um campo de
+ * payload ou uma posição de `lists` (por índice: os arrays podem ser
+ * realocados enquanto isso), data[] do pai (ND_EXPR/ND_RETURN) ou,
+ * para a raiz, `out` */
+typedef struct {
+    const Node *src;
+    CastVec    *vec;      /* NULL: a->data[index] ou *out */
+    CNode      *out;
+    uint32_t    index;
+    uint32_t    offset;   /* deslocamento do campo no elemento */
+    uint32_t    elem;     /* tamanho do elemento de `vec` */
+} AddTask;
+
+static void write_slot(CompactAst *a, const AddTask *t, CNode n) {
+    if (t->out) *t->out = n;
+    else if (!t->vec) a->data[t->index] = n;
+    else *(CNode*)((char*)t->vec->items + (size_t)t->index * t->elem + t->offset) = n;
+}
+
+static void add_push(CompactAst *a, WorkStack *s, const Node *src, CastVec *vec,
+                     uint32_t index, uint32_t offset, uint32_t elem) {
+    AddTask t = { src, vec, NULL, index, offset, elem };
+    if (!src) { write_slot(a, &t, CAST_NONE); return; }
+    *(AddTask*)ws_push(s) = t;
+}
+
+#define PUSH_FIELD(src, vec, T, field) \
+    add_push(a, &stack, (src), &a->vec, p, offsetof(T, field), sizeof(T))
+
+/* Reserva a lista em `lists` e empilha os elementos do último para o primeiro */
+static CList add_list(CompactAst *a, WorkStack *s, Node *const *items, size_t count) {
+    CList l = { .first = vec_reserve_n(&a->lists, sizeof(CNode), (uint32_t)count), .count = (uint32_t)count };
+    for (size_t i = count; i-- > 0; )
+        add_push(a, s, items[i], &a->lists, l.first + (uint32_t)i, 0, sizeof(CNode));
+    return l;
+}
+
+/* Iterativo e em pré-ordem: o nó e o payload são reservados antes dos
+ * filhos, que são empilhados do último para o primeiro e gravam o
+ * próprio índice no campo do pai quando forem convertidos */
+CNode cast_add(CompactAst *a, const Node *node) {
+    CNode root = CAST_NONE;
+    if (!node) return root;
+
+    AddTask buf[64];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(AddTask));
+    AddTask first = { node, NULL, &root, 0, 0, 0 };
+    *(AddTask*)ws_push(&stack) = first;
+
+    while (!ws_empty(&stack)) {
+        AddTask t = *(AddTask*)ws_top(&stack);
+        ws_pop(&stack);
+        const Node *n = t.src;
+
+        CNode id = new_slot(a, n->kind);
+        write_slot(a, &t, id);
+        uint32_t p = 0;
+
+        switch (n->kind) {
+            case ND_INT:
+                p = vec_reserve(&a->ints, sizeof(long));
+                VEC_AT(a->ints, long, p) = n->u.as_int.value;
+                break;
+
+            case ND_FLOAT:
+                p = vec_reserve(&a->floats, sizeof(double));
+                VEC_AT(a->floats, double, p) = n->u.as_float.value;
+                break;
+
+            case ND_BOOL:
+                p = n->u.as_bool.value ? 1 : 0;
+                break;
+
+            case ND_STRING:
+                p = n->u.as_string.id;
+                break;
+
+            case ND_IDENT:
+                p = name_index(a, n->u.as_ident.name);
+                break;
+
+            case ND_UNARY:
+                p = vec_reserve(&a->unary, sizeof(CUnary));
+                VEC_AT(a->unary, CUnary, p) = (CUnary){ n->u.as_unary.op, CAST_NONE };
+                PUSH_FIELD(n->u.as_unary.expr, unary, CUnary, expr);
+                break;
+
+            case ND_BINARY:
+                p = vec_reserve(&a->binary, sizeof(CBinary));
+                VEC_AT(a->binary, CBinary, p) = (CBinary){ n->u.as_binary.op, CAST_NONE, CAST_NONE };
+                PUSH_FIELD(n->u.as_binary.right, binary, CBinary, right);
+                PUSH_FIELD(n->u.as_binary.left,  binary, CBinary, left);
+                break;
+
+            case ND_BLOCK: {
+                p = vec_reserve(&a->blocks, sizeof(CList));
+                CList l = add_list(a, &stack, n->u.as_block.stmts, n->u.as_block.count);
+                VEC_AT(a->blocks, CList, p) = l;
+                break;
+            }
+
+            case ND_ASSIGN:
+                p = vec_reserve(&a->assigns, sizeof(CAssign));
+                VEC_AT(a->assigns, CAssign, p) = (CAssign){ name_index(a, n->u.as_assign.name), CAST_NONE };
+                PUSH_FIELD(n->u.as_assign.value, assigns, CAssign, value);
+                break;
+
+            case ND_EXPR:
+            case ND_RETURN: {
+                /* o filho vai direto em data[id] */
+                const Node *child = n->kind == ND_EXPR ? n->u.as_expr.expr : n->u.as_return.expr;
+                a->data[id] = CAST_NONE;
+                add_push(a, &stack, child, NULL, id, 0, 0);
+                continue;
+            }
+
+            case ND_IF:
+                p = vec_reserve(&a->ifs, sizeof(CIf));
+                VEC_AT(a->ifs, CIf, p) = (CIf){ CAST_NONE, CAST_NONE, CAST_NONE };
+                PUSH_FIELD(n->u.as_if.else_branch, ifs, CIf, else_branch);
+                PUSH_FIELD(n->u.as_if.then_branch, ifs, CIf, then_branch);
+                PUSH_FIELD(n->u.as_if.cond,        ifs, CIf, cond);
+                break;
+
+            case ND_DECL:
+                p = vec_reserve(&a->decls, sizeof(CDecl));
+                VEC_AT(a->decls, CDecl, p) = (CDecl){ name_index(a, n->u.as_decl.name), n->u.as_decl.type, CAST_NONE };
+                PUSH_FIELD(n->u.as_decl.init, decls, CDecl, init);
+                break;
+
+            case ND_WHILE:
+                p = vec_reserve(&a->whiles, sizeof(CWhile));
+                VEC_AT(a->whiles, CWhile, p) = (CWhile){ CAST_NONE, CAST_NONE };
+                PUSH_FIELD(n->u.as_while.body, whiles, CWhile, body);
+                PUSH_FIELD(n->u.as_while.cond, whiles, CWhile, cond);
+                break;
+
+            case ND_FOR:
+                p = vec_reserve(&a->fors, sizeof(CFor));
+                VEC_AT(a->fors, CFor, p) = (CFor){ CAST_NONE, CAST_NONE, CAST_NONE, CAST_NONE };
+                PUSH_FIELD(n->u.as_for.body, fors, CFor, body);
+                PUSH_FIELD(n->u.as_for.step, fors, CFor, step);
+                PUSH_FIELD(n->u.as_for.cond, fors, CFor, cond);
+                PUSH_FIELD(n->u.as_for.init, fors, CFor, init);
+                break;
+
+            case ND_FUNCTION: {
+                p = vec_reserve(&a->funcs, sizeof(CFunction));
+                VEC_AT(a->funcs, CFunction, p) = (CFunction){
+                    name_index(a, n->u.as_function.name), n->u.as_function.ret_type, { 0, 0 }, CAST_NONE
+                };
+                PUSH_FIELD(n->u.as_function.body, funcs, CFunction, body);
+                CList params = add_list(a, &stack, n->u.as_function.params, n->u.as_function.param_count);
+                VEC_AT(a->funcs, CFunction, p).params = params;
+                break;
+            }
+
+            case ND_CALL: {
+                p = vec_reserve(&a->calls, sizeof(CCall));
+                uint32_t name = name_index(a, n->u.as_call.name);
+                CList args = add_list(a, &stack, n->u.as_call.args, n->u.as_call.arg_count);
+                VEC_AT(a->calls, CCall, p) = (CCall){ name, args };
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        a->data[id] = p;
+    }
+
+    ws_free(&stack);
+    return root;
+}
+
+#undef PUSH_FIELD
+
+void cast_add_top(CompactAst *a, const Node *stmt) {
+    if (!stmt) return;
+    CNode n = cast_add(a, stmt);
+    vec_push_node(&a->top, n);
+}
+
+CNode cast_finish(CompactAst *a) {
+    CNode root = new_slot(a, ND_BLOCK);
+    uint32_t p = vec_reserve(&a->blocks, sizeof(CList));
+
+    CList l = { .first = a->lists.count, .count = a->top.count };
+    for (uint32_t i = 0; i < l.count; i++)
+        vec_push_node(&a->lists, VEC_AT(a->top, CNode, i));
+    VEC_AT(a->blocks, CList, p) = l;
+    a->data[root] = p;
+
+    /* a lista de nível superior já foi copiada para `lists`, e o mapa
+     * de nomes só serve para a construção */
+    free(a->top.items);
+    memset(&a->top, 0, sizeof a->top);
+    free(a->name_ids);
+    a->name_ids = NULL;
+    a->name_ids_cap = 0;
+
+    if (a->count < a->cap) {
+        uint8_t  *k = (uint8_t*)realloc(a->kind, a->count);
+        uint32_t *d = (uint32_t*)realloc(a->data, (size_t)a->count * sizeof(uint32_t));
+        if (k) a->kind = k;
+        if (d) a->data = d;
+        if (k && d) a->cap = a->count;
+    }
+    vec_shrink(&a->lists,   sizeof(CNode));
+    vec_shrink(&a->ints,    sizeof(long));
+    vec_shrink(&a->floats,  sizeof(double));
+    vec_shrink(&a->names,   sizeof(const char*));
+    vec_shrink(&a->unary,   sizeof(CUnary));
+    vec_shrink(&a->binary,  sizeof(CBinary));
+    vec_shrink(&a->blocks,  sizeof(CList));
+    vec_shrink(&a->assigns, sizeof(CAssign));
+    vec_shrink(&a->ifs,     sizeof(CIf));
+    vec_shrink(&a->decls,   sizeof(CDecl));
+    vec_shrink(&a->whiles,  sizeof(CWhile));
+    vec_shrink(&a->fors,    sizeof(CFor));
+    vec_shrink(&a->funcs,   sizeof(CFunction));
+    vec_shrink(&a->calls,   sizeof(CCall));
+
+    a->root = root;
+    return root;
+}
+
+CompactAst *cast_from_node(const Node *root, const StrPool *strings) {
+    CompactAst *a = cast_new(strings);
+    if (root && root->kind == ND_BLOCK) {
+        for (size_t i = 0; i < root->u.as_block.count; i++)
+            cast_add_top(a, root->u.as_block.stmts[i]);
+        cast_finish(a);
+    } else {
+        a->root = cast_add(a, root);
+    }
+    return a;
+}
+
+/* =========================================================
+ * Adaptador para Node
+ * ========================================================= */
+/* Conversão pendente: o nó `src` vai para `*dst` (no pai já montado) */
+typedef struct {
+    CNode  src;
+    Node **dst;
+} NodeTask;
+
+static inline void node_push(WorkStack *s, CNode src, Node **dst) {
+    if (src == CAST_NONE) { *dst = NULL; return; }
+    NodeTask *t = (NodeTask*)ws_push(s);
+    t->src = src;
+    t->dst = dst;
+}
+
+static Node **node_list(const CompactAst *a, WorkStack *s, CList l) {
+    if (l.count == 0) return NULL;
+    Node **nodes = (Node**)ast_alloc(sizeof(Node*) * l.count);
+    for (uint32_t i = l.count; i-- > 0; )
+        node_push(s, cast_list_at(a, l, i), &nodes[i]);
+    return nodes;
+}
+
+/* Iterativo; o pai é alocado antes dos filhos (pré-ordem, como no compacto) */
+Node *cast_to_node(const CompactAst *a, CNode root) {
+    Node *result = NULL;
+    NodeTask buf[64];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(NodeTask));
+    node_push(&stack, root, &result);
+
+    while (!ws_empty(&stack)) {
+        NodeTask t = *(NodeTask*)ws_top(&stack);
+        ws_pop(&stack);
+        CNode n = t.src;
+
+        Node *node = new_node(cast_kind(a, n));
+        *t.dst = node;
+
+        switch (node->kind) {
+            case ND_INT:   node->u.as_int.value = cast_int(a, n); break;
+            case ND_FLOAT: node->u.as_float.value = cast_float(a, n); break;
+            case ND_BOOL:  node->u.as_bool.value = cast_bool(a, n); break;
+            case ND_IDENT:
+                node->u.as_ident.name = cast_ident(a, n);
+                node->u.as_ident.ref = (VarRef){ VAR_UNRESOLVED, 0 };
+                break;
+
+            case ND_STRING: {
+                uint32_t id = cast_string(a, n);
+                node->u.as_string.id = id;
+                node->u.as_string.value = str_pool_get(a->strings, id);
+                node->u.as_string.len = str_pool_len(a->strings, id);
+                break;
+            }
+
+            case ND_UNARY: {
+                const CUnary *u = cast_unary(a, n);
+                node->u.as_unary.op = u->op;
+                node_push(&stack, u->expr, &node->u.as_unary.expr);
+                break;
+            }
+
+            case ND_BINARY: {
+                const CBinary *b = cast_binary(a, n);
+                node->u.as_binary.op = b->op;
+                node_push(&stack, b->right, &node->u.as_binary.right);
+                node_push(&stack, b->left,  &node->u.as_binary.left);
+                break;
+            }
+
+            case ND_BLOCK: {
+                CList l = *cast_block(a, n);
+                node->u.as_block.count = l.count;
+                node->u.as_block.capacity = l.count;
+                node->u.as_block.stmts = node_list(a, &stack, l);
+                break;
+            }
+
+            case ND_ASSIGN: {
+                const CAssign *as = cast_assign(a, n);
+                node->u.as_assign.name = cast_name(a, as->name);
+                node->u.as_assign.ref = (VarRef){ VAR_UNRESOLVED, 0 };
+                node_push(&stack, as->value, &node->u.as_assign.value);
+                break;
+            }
+
+            case ND_EXPR:
+                node_push(&stack, cast_child(a, n), &node->u.as_expr.expr);
+                break;
+
+            case ND_RETURN:
+                node_push(&stack, cast_child(a, n), &node->u.as_return.expr);
+                break;
+
+            case ND_IF: {
+                const CIf *i = cast_if(a, n);
+                node_push(&stack, i->else_branch, &node->u.as_if.else_branch);
+                node_push(&stack, i->then_branch, &node->u.as_if.then_branch);
+                node_push(&stack, i->cond,        &node->u.as_if.cond);
+                break;
+            }
+
+            case ND_DECL: {
+                const CDecl *d = cast_decl(a, n);
+                node->u.as_decl.type = d->type;
+                node->u.as_decl.name = cast_name(a, d->name);
+                node->u.as_decl.ref = (VarRef){ VAR_UNRESOLVED, 0 };
+                node_push(&stack, d->init, &node->u.as_decl.init);
+                break;
+            }
+
+            case ND_WHILE: {
+                const CWhile *w = cast_while(a, n);
+                node_push(&stack, w->body, &node->u.as_while.body);
+                node_push(&stack, w->cond, &node->u.as_while.cond);
+                break;
+            }
+
+            case ND_FOR: {
+                const CFor *f = cast_for(a, n);
+                node_push(&stack, f->body, &node->u.as_for.body);
+                node_push(&stack, f->step, &node->u.as_for.step);
+                node_push(&stack, f->cond, &node->u.as_for.cond);
+                node_push(&stack, f->init, &node->u.as_for.init);
+                break;
+            }
+
+            case ND_FUNCTION: {
+                const CFunction *f = cast_function(a, n);
+                node->u.as_function.ret_type = f->ret_type;
+                node->u.as_function.name = cast_name(a, f->name);
+                node->u.as_function.param_count = f->params.count;
+                node_push(&stack, f->body, &node->u.as_function.body);
+                node->u.as_function.params = node_list(a, &stack, f->params);
+                break;
+            }
+
+            case ND_CALL: {
+                const CCall *c = cast_call(a, n);
+                node->u.as_call.name = cast_name(a, c->name);
+                node->u.as_call.arg_count = c->args.count;
+                node->u.as_call.fn_index = FN_UNRESOLVED;
+                node->u.as_call.args = node_list(a, &stack, c->args);
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    ws_free(&stack);
+    return result;
+}
+
+size_t cast_memory(const CompactAst *a) {
+    size_t bytes = sizeof *a + (size_t)a->cap * (sizeof(uint8_t) + sizeof(uint32_t));
+    bytes += vec_bytes(&a->lists,   sizeof(CNode));
+    bytes += vec_bytes(&a->top,     sizeof(CNode));
+    bytes += vec_bytes(&a->ints,    sizeof(long));
+    bytes += vec_bytes(&a->floats,  sizeof(double));
+    bytes += vec_bytes(&a->names,   sizeof(const char*));
+    bytes += a->name_ids_cap * sizeof(uint32_t);
+    bytes += vec_bytes(&a->unary,   sizeof(CUnary));
+    bytes += vec_bytes(&a->binary,  sizeof(CBinary));
+    bytes += vec_bytes(&a->blocks,  sizeof(CList));
+    bytes += vec_bytes(&a->assigns, sizeof(CAssign));
+    bytes += vec_bytes(&a->ifs,     sizeof(CIf));
+    bytes += vec_bytes(&a->decls,   sizeof(CDecl));
+    bytes += vec_bytes(&a->whiles,  sizeof(CWhile));
+    bytes += vec_bytes(&a->fors,    sizeof(CFor));
+    bytes += vec_bytes(&a->funcs,   sizeof(CFunction));
+    bytes += vec_bytes(&a->calls,   sizeof(CCall));
+    return bytes;
+}
@@ -1,52 +1,68 @@
 #include "ast_base.h"
 #include "ast_expr.h"
+#include "ast_hashcons.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* Expressões sem efeito colateral passam pela tabela de hash-consing
+ * ativa (ast_hashcons.h): `key` é montado na pilha e só vira nó novo
+ * se ainda não houver um igual; sem tabela, o nó é sempre novo */
+static Node *make_shared(const Node *key) {
+  Node *node = hashcons_intern(key);
+  if (node) return node;
+  node = new_node(key -> kind);
+  node -> u = key -> u;
+  return node;
+}
 
 Node *ast_int(long value) {
-  Node *node = new_node(ND_INT);
-  node -> u.as_int.value = value;
-  return node;
+  Node key = { .kind = ND_INT };
+  key.u.as_int.value = value;
+  return make_shared(&key);
 }
 
 Node *ast_float(double value) {
-  Node *node = new_node(ND_FLOAT);
-  node -> u.as_float.value = value;
-  return node;
+  Node key = { .kind = ND_FLOAT };
+  key.u.as_float.value = value;
+  return make_shared(&key);
 }
 
 Node *ast_bool(bool value) {
-  Node *node = new_node(ND_BOOL);
-  node -> u.as_bool.value = value;
-  return node;
+  Node key = { .kind = ND_BOOL };
+  key.u.as_bool.value = value;
+  return make_shared(&key);
 }
 
 Node *ast_ident(const char *name) {
-  Node *node = new_node(ND_IDENT);
-  node -> u.as_ident.name = xstrdup(name);
-  return node;
+  Node key = { .kind = ND_IDENT };
+  key.u.as_ident.name = name;
+  key.u.as_ident.ref = (VarRef){ VAR_UNRESOLVED, 0 };
+  return make_shared(&key);
 }
 
-Node *ast_string(const char *value) {
-  Node *node = new_node(ND_STRING);
-  node -> u.as_string.value = xstrdup(value);
-  return node;
+Node *ast_string(const StrPool *pool, uint32_t id) {
+  Node key = { .kind = ND_STRING };
+  key.u.as_string.id = id;
+  key.u.as_string.value = str_pool_get(pool, id);
+  key.u.as_string.len = str_pool_len(pool, id);
+  return make_shared(&key);
 }
 
 Node *ast_unary(UnOp op, Node *expr) {
-  Node *node = new_node(ND_UNARY);
-  node -> u.as_unary.op = op;
-  node -> u.as_unary.expr = expr;
-  return node;
+  Node key = { .kind = ND_UNARY };
+  key.u.as_unary.op = op;
+  key.u.as_unary.expr = expr;
+  return make_shared(&key);
 }
 
 Node *ast_binary(BinOp op, Node *left, Node *right) {
-  Node *node = new_node(ND_BINARY);
-  node -> u.as_binary.op = op;
-  node -> u.as_binary.left = left;
-  node -> u.as_binary.right = right;
-  return node;
+  Node key = { .kind = ND_BINARY };
+  key.u.as_binary.op = op;
+  key.u.as_binary.left = left;
+  key.u.as_binary.right = right;
+  return make_shared(&key);
 }
 
 Node *ast_block(void) {
@@ -65,10 +81,17 @@ void ast_block_add_stmt(Node *block, Node *stmt) {
 
   if (count == capacity) {
     size_t new_capacity = capacity ? capacity * 2 : 4;
-
-    Node **new_stmts = (Node **)realloc(block -> u.as_block.stmts, new_capacity * sizeof(Node *));
-
-    if (!new_stmts) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+    Node **new_stmts;
+
+    if (block -> flags & NODE_ARENA) {
+      /* na arena não há realloc: copia para um array novo (o antigo
+       * fica perdido até a arena ser liberada, no máximo o dobro) */
+      new_stmts = (Node **)ast_alloc(new_capacity * sizeof(Node *));
+      if (count) memcpy(new_stmts, block -> u.as_block.stmts, count * sizeof(Node *));
+    } else {
+      new_stmts = (Node **)realloc(block -> u.as_block.stmts, new_capacity * sizeof(Node *));
+      if (!new_stmts) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+    }
 
     block -> u.as_block.stmts = new_stmts;
     block -> u.as_block.capacity = new_capacity;
@@ -79,8 +102,9 @@ void ast_block_add_stmt(Node *block, Node *stmt) {
 
 Node *ast_assign(const char *name, Node *value) {
   Node *node = new_node(ND_ASSIGN);
-  node -> u.as_assign.name = xstrdup(name);
+  node -> u.as_assign.name = name;
   node -> u.as_assign.value = value;
+  node -> u.as_assign.ref = (VarRef){ VAR_UNRESOLVED, 0 };
   return node;
 }
 
@@ -101,8 +125,9 @@ Node *ast_if(Node *cond, Node *then_branch, Node *else_branch) {
 Node *ast_decl(TypeTag type, const char *name, Node *init) {
   Node *n = new_node(ND_DECL);
   n->u.as_decl.type = type;
-  n->u.as_decl.name = xstrdup(name);
+  n->u.as_decl.name = name;
   n->u.as_decl.init = init;
+  n->u.as_decl.ref = (VarRef){ VAR_UNRESOLVED, 0 };
   return n;
 }
 
@@ -122,7 +147,7 @@ Node *ast_for(Node *init, Node *cond, Node *step, Node *body) {
     return n;
 }
 
-Node *ast_function(TypeTag ret_type, char *name, Node **params, size_t param_count, Node *body) {
+Node *ast_function(TypeTag ret_type, const char *name, Node **params, size_t param_count, Node *body) {
     Node *n = new_node(ND_FUNCTION);
     n->u.as_function.ret_type    = ret_type;
     n->u.as_function.name        = name;
@@ -140,8 +165,9 @@ Node *ast_return(Node *expr) {
 
 Node *ast_call(const char *name, Node **args, size_t arg_count) {
     Node *n = new_node(ND_CALL);
-    n->u.as_call.name = xstrdup(name);
+    n->u.as_call.name = name;
     n->u.as_call.args = args;
     n->u.as_call.arg_count = arg_count;
+    n->u.as_call.fn_index = FN_UNRESOLVED;
     return n;
 }
@@ -0,0 +1,1022 @@
+#include "ast_fold.h"
+#include "arena.h"
+#include "ast_expr.h"
+#include "intern.h"
+#include "semantic_analyzer.h"
+#include "work_stack.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Maior inteiro que o double do JS representa sem perda */
+#define FOLD_INT_LIMIT (1L << 53)
+
+/* =========================================================
+ * Tipos visíveis
+ *   Indexados pelo id do nome internado; sair de um escopo desfaz as
+ *   declarações dele pelo registro `undo` (mesmos escopos da análise
+ *   semântica: blocos e funções, o for não abre escopo).
+ *
+ *   Cada declaração (parâmetros inclusive) recebe um número, na ordem em
+ *   que o passo a encontra: é a chave da propagação de constantes, igual
+ *   na varredura (fold_scan_stmt) e no dobramento, que percorrem o
+ *   programa na mesma ordem.
+ * ========================================================= */
+typedef struct {
+    TypeTag type;       /* TY_INVALID = nenhuma declaração visível */
+    int32_t decl;       /* número da declaração */
+} FoldVar;
+
+typedef struct {
+    uint32_t id;
+    FoldVar  prev;
+} FoldUndo;
+
+typedef struct {
+    TypeTag  ret;
+    uint32_t defs;          /* definições com o nome (varredura) */
+    bool     nested;        /* alguma delas dentro de outra função */
+    int32_t  first_param;   /* número do primeiro parâmetro */
+    uint32_t param_count;
+    int32_t  calls;         /* chamadas diretas (ConstCall), -1 = nenhuma */
+} FoldFun;
+
+/* =========================================================
+ * Propagação de constantes (estado)
+ *   Reticulado por declaração: CV_UNKNOWN (ainda sem valor: otimista),
+ *   CV_CONST (sempre o mesmo literal) e CV_VARYING. O valor vem das
+ *   fontes da declaração — o inicializador, ou os argumentos das
+ *   chamadas diretas para um parâmetro —, guardadas como termos
+ *   (literal, variável, unária ou binária; o resto é desconhecido).
+ * ========================================================= */
+typedef enum { CV_UNKNOWN, CV_CONST, CV_VARYING } ConstState;
+
+typedef struct {
+    TypeTag    type;
+    ConstState state;
+    Node      *value;   /* CV_CONST: literal do tipo da declaração */
+    int32_t    srcs;    /* fontes (ConstLink.item = termo) */
+    int32_t    users;   /* declarações cujas fontes leem esta */
+} ConstDecl;
+
+typedef enum { TERM_LIT, TERM_VAR, TERM_UNARY, TERM_BINARY } TermKind;
+
+typedef struct {
+    TermKind kind;
+    int      op;
+    int32_t  a, b;      /* filhos (-1 = desconhecido); TERM_VAR: a = declaração */
+    Node    *lit;
+} ConstTerm;
+
+typedef struct {
+    int32_t item;
+    int32_t next;
+} ConstLink;
+
+typedef struct {
+    int32_t  args;      /* termos em call_args[args .. args+argc) */
+    uint32_t argc;
+    int32_t  next;
+} ConstCall;
+
+/* Nós de um termo (o resto da expressão vira termo desconhecido) */
+#define TERM_BUDGET 32
+
+struct Folder {
+    FoldVar  *vars;     /* id -> declaração visível */
+    FoldFun  *funs;     /* id -> função */
+    size_t    cap;      /* tamanho de vars e funs */
+    FoldUndo *undo;
+    size_t    undo_count;
+    size_t    undo_cap;
+    int32_t   next_decl;
+
+    /* propagação (fold_scan_stmt / fold_scan_finish) */
+    bool       scanning;
+    bool       propagate;   /* substitui as constantes no dobramento */
+    int32_t    decl_total;  /* declarações da varredura */
+    int        fn_depth;
+    Arena     *arena;       /* literais dos termos e dos valores */
+    ConstDecl *decls;       size_t decl_cap;
+    ConstTerm *terms;       size_t term_count, term_cap;
+    ConstLink *links;       size_t link_count, link_cap;
+    ConstCall *calls;       size_t call_count, call_cap;
+    int32_t   *call_args;   size_t arg_count, arg_cap;
+};
+
+Folder *fold_new(void) {
+    Folder *fd = (Folder*)xmalloc(sizeof(Folder));
+    memset(fd, 0, sizeof *fd);
+    return fd;
+}
+
+void fold_free(Folder *fd) {
+    if (!fd) return;
+    free(fd->vars);
+    free(fd->funs);
+    free(fd->undo);
+    free(fd->decls);
+    free(fd->terms);
+    free(fd->links);
+    free(fd->calls);
+    free(fd->call_args);
+    if (fd->arena) arena_free(fd->arena);
+    free(fd);
+}
+
+bool fold_enabled(void) {
+    const char *env = getenv("ASTEROIDS_FOLD");
+    return env && strcmp(env, "1") == 0;
+}
+
+/* Garante espaço para `need` itens de `size` bytes em *items */
+static void fold_grow(void **items, size_t *cap, size_t need, size_t size) {
+    if (need <= *cap) return;
+    size_t n = *cap ? *cap : 64;
+    while (n < need) n *= 2;
+    *items = realloc(*items, n * size);
+    if (!*items) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    *cap = n;
+}
+
+static void fold_reserve(Folder *fd, uint32_t id) {
+    if (id < fd->cap) return;
+    size_t cap = intern_count() > id ? intern_count() : (size_t)id + 1;
+    FoldVar *vars = (FoldVar*)realloc(fd->vars, cap * sizeof(FoldVar));
+    FoldFun *funs = (FoldFun*)realloc(fd->funs, cap * sizeof(FoldFun));
+    if (!vars || !funs) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    for (size_t i = fd->cap; i < cap; i++) {
+        vars[i] = (FoldVar){ TY_INVALID, -1 };
+        funs[i] = (FoldFun){ TY_INVALID, 0, false, -1, 0, -1 };
+    }
+    fd->vars = vars;
+    fd->funs = funs;
+    fd->cap = cap;
+}
+
+static const FoldVar *visible_var(const Folder *fd, const char *name) {
+    uint32_t id = intern_id(name);
+    return id < fd->cap && fd->vars[id].type != TY_INVALID ? &fd->vars[id] : NULL;
+}
+
+static TypeTag fun_type(const Folder *fd, const char *name) {
+    uint32_t id = intern_id(name);
+    return id < fd->cap ? fd->funs[id].ret : TY_INVALID;
+}
+
+/* Declara e devolve o número da declaração; na varredura, ela entra na
+ * propagação (sem fontes ainda) */
+static int32_t declare_var(Folder *fd, const char *name, TypeTag type) {
+    uint32_t id = intern_id(name);
+    fold_reserve(fd, id);
+    if (fd->undo_count == fd->undo_cap) {
+        fd->undo_cap = fd->undo_cap ? fd->undo_cap * 2 : 64;
+        fd->undo = (FoldUndo*)realloc(fd->undo, fd->undo_cap * sizeof(FoldUndo));
+        if (!fd->undo) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    }
+    fd->undo[fd->undo_count].id = id;
+    fd->undo[fd->undo_count].prev = fd->vars[id];
+    fd->undo_count++;
+
+    int32_t d = fd->next_decl++;
+    fd->vars[id] = (FoldVar){ type, d };
+    if (fd->scanning) {
+        fold_grow((void**)&fd->decls, &fd->decl_cap, (size_t)d + 1, sizeof(ConstDecl));
+        fd->decls[d] = (ConstDecl){ type, CV_UNKNOWN, NULL, -1, -1 };
+    }
+    return d;
+}
+
+/* Desfaz as declarações feitas depois de `mark` (undo_count na entrada) */
+static void leave_scope(Folder *fd, size_t mark) {
+    while (fd->undo_count > mark) {
+        FoldUndo *u = &fd->undo[--fd->undo_count];
+        fd->vars[u->id] = u->prev;
+    }
+}
+
+void fold_declare_function(Folder *fd, const char *name, TypeTag ret_type) {
+    uint32_t id = intern_id(name);
+    fold_reserve(fd, id);
+    fd->funs[id].ret = ret_type;
+}
+
+/* =========================================================
+ * Literais
+ * ========================================================= */
+static TypeTag literal_type(const Node *n) {
+    switch (n->kind) {
+        case ND_INT:    return TY_INT;
+        case ND_FLOAT:  return TY_FLOAT;
+        case ND_BOOL:   return TY_BOOL;
+        case ND_STRING: return TY_STRING;
+        default:        return TY_INVALID;
+    }
+}
+
+static inline bool safe_int(long v) {
+    return v >= -FOLD_INT_LIMIT && v <= FOLD_INT_LIMIT;
+}
+
+/* Valor numérico de um literal que o JS lê sem perda */
+static bool numeric_value(const Node *n, double *out) {
+    if (n->kind == ND_INT && safe_int(n->u.as_int.value)) {
+        *out = (double)n->u.as_int.value;
+        return true;
+    }
+    if (n->kind == ND_FLOAT) {
+        *out = n->u.as_float.value;
+        return true;
+    }
+    return false;
+}
+
+static Node *make_int(long v) {
+    return safe_int(v) ? ast_int(v) : NULL;
+}
+
+/* O IR e o JS imprimem floats com %g: só vira literal o que volta igual */
+static Node *make_float(double v) {
+    if (!isfinite(v)) return NULL;
+    char buf[64];
+    snprintf(buf, sizeof buf, "%g", v);
+    if (strtod(buf, NULL) != v || signbit(strtod(buf, NULL)) != signbit(v)) return NULL;
+    return ast_float(v);
+}
+
+/* =========================================================
+ * Regras
+ * ========================================================= */
+
+/* op entre dois literais (`type` = infer_binary); NULL se não dobra */
+static Node *fold_constants(BinOp op, const Node *l, const Node *r, TypeTag type) {
+    if (l->kind == ND_BOOL && r->kind == ND_BOOL) {
+        bool a = l->u.as_bool.value, b = r->u.as_bool.value;
+        switch (op) {
+            case BIN_EQ:  return ast_bool(a == b);
+            case BIN_NEQ: return ast_bool(a != b);
+            case BIN_AND: return ast_bool(a && b);
+            case BIN_OR:  return ast_bool(a || b);
+            default:      return NULL;
+        }
+    }
+
+    /* o pool não repete textos: mesmo id <=> mesmo conteúdo */
+    if (l->kind == ND_STRING && r->kind == ND_STRING) {
+        bool same = l->u.as_string.id == r->u.as_string.id;
+        if (op == BIN_EQ)  return ast_bool(same);
+        if (op == BIN_NEQ) return ast_bool(!same);
+        return NULL;
+    }
+
+    double a, b;
+    if (!numeric_value(l, &a) || !numeric_value(r, &b)) return NULL;
+
+    if (type == TY_INT) {
+        long x = l->u.as_int.value, y = r->u.as_int.value, v;
+        bool overflow;
+        switch (op) {
+            case BIN_ADD: overflow = __builtin_add_overflow(x, y, &v); break;
+            case BIN_SUB: overflow = __builtin_sub_overflow(x, y, &v); break;
+            case BIN_MUL: overflow = __builtin_mul_overflow(x, y, &v); break;
+            default:      return NULL;
+        }
+        return overflow ? NULL : make_int(v);
+    }
+
+    switch (op) {
+        case BIN_ADD: return make_float(a + b);
+        case BIN_SUB: return make_float(a - b);
+        case BIN_MUL: return make_float(a * b);
+        case BIN_DIV: return b != 0.0 ? make_float(a / b) : NULL;
+        case BIN_LT:  return ast_bool(a <  b);
+        case BIN_LE:  return ast_bool(a <= b);
+        case BIN_GT:  return ast_bool(a >  b);
+        case BIN_GE:  return ast_bool(a >= b);
+        case BIN_EQ:  return ast_bool(a == b);
+        case BIN_NEQ: return ast_bool(a != b);
+        default:      return NULL;
+    }
+}
+
+/* `x op c` (ou `c op x` com const_left) vale exatamente x? O tipo do
+ * resultado tem que ser o de x (x*1.0 com x int viraria float) e o
+ * valor também: com x float, x+0 troca -0.0 por 0.0 */
+static bool is_identity(BinOp op, const Node *c, bool const_left, TypeTag tx) {
+    double v;
+    if (tx == TY_INVALID || !numeric_value(c, &v)) return false;
+    if (infer_binary(op, tx, literal_type(c)) != tx) return false;
+    switch (op) {
+        case BIN_MUL: return v == 1.0;
+        case BIN_ADD: return v == 0.0 && tx == TY_INT;
+        case BIN_SUB: return !const_left && v == 0.0 && !signbit(v);
+        case BIN_DIV: return !const_left && v == 1.0;
+        default:      return false;
+    }
+}
+
+/* Simplificação de `l op r` (já simplificados); NULL se nada muda */
+static Node *simplify_binary(BinOp op, Node *l, TypeTag lt, Node *r, TypeTag rt) {
+    TypeTag type = infer_binary(op, lt, rt);
+    if (type == TY_INVALID) return NULL;
+
+    bool lc = literal_type(l) != TY_INVALID;
+    bool rc = literal_type(r) != TY_INVALID;
+    if (lc && rc) return fold_constants(op, l, r, type);
+
+    if (op == BIN_AND || op == BIN_OR) {
+        /* true && b = b, false && b = false (b nem é avaliado), e o dual;
+         * com a constante à direita, b é avaliado antes: só b && true e
+         * b || false */
+        bool absorb = (op == BIN_OR);
+        if (lc && l->kind == ND_BOOL) return l->u.as_bool.value == absorb ? l : r;
+        if (rc && r->kind == ND_BOOL && r->u.as_bool.value != absorb) return l;
+        return NULL;
+    }
+
+    if (rc && is_identity(op, r, false, lt)) return l;
+    if (lc && is_identity(op, l, true, rt)) return r;
+    return NULL;
+}
+
+static Node *simplify_unary(UnOp op, Node *x) {
+    switch (op) {
+        case UN_NEG: {
+            /* o IR calcula 0 - v (então -(0.0) é 0.0, não -0.0) */
+            if (x->kind == ND_INT && safe_int(x->u.as_int.value)) return make_int(-x->u.as_int.value);
+            if (x->kind == ND_FLOAT) return make_float(0.0 - x->u.as_float.value);
+            return NULL;
+        }
+        case UN_NOT:
+            if (x->kind == ND_BOOL) return ast_bool(!x->u.as_bool.value);
+            if (x->kind == ND_UNARY && x->u.as_unary.op == UN_NOT) return x->u.as_unary.expr;
+            return NULL;
+    }
+    return NULL;
+}
+
+/* =========================================================
+ * Expressões
+ *   Iterativo, pós-ordem (mesma pilha de quadros de infer): o filho que
+ *   acabou de terminar chega em `ret`/`ret_t`. Um nó só é recriado se
+ *   algum filho mudou.
+ *
+ *   Uma identidade que deixa só uma variável (x, ou `x = ...`) reusa o
+ *   temporário dela, que o IR builder associa ao nome. Isso só é feito
+ *   quando nada na expressão atribui (senão `(x*1) + (x = 2)` leria o x
+ *   novo) e fora da raiz de valores de declaração/atribuição (`binding`:
+ *   a variável de destino viraria um apelido da outra).
+ * ========================================================= */
+typedef struct {
+    Node   *e;
+    int     stage;
+    bool    binding;
+    size_t  i;          /* próximo argumento (ND_CALL) */
+    Node   *left;       /* lado esquerdo já simplificado */
+    TypeTag lt;
+    Node  **args;       /* argumentos copiados (só se algum mudou) */
+} FoldFrame;
+
+static void fold_push(WorkStack *s, Node *e, bool binding) {
+    FoldFrame *f = (FoldFrame*)ws_push(s);
+    f->e = e;
+    f->stage = 0;
+    f->binding = binding;
+    f->i = 0;
+    f->left = NULL;
+    f->lt = TY_INVALID;
+    f->args = NULL;
+}
+
+/* Resultado de uma regra (NULL = fica o nó original, ver acima) */
+static Node *pick(Node *simplified, bool binding, bool assigns) {
+    if (!simplified) return NULL;
+    bool named = simplified->kind == ND_IDENT || simplified->kind == ND_ASSIGN;
+    return named && (binding || assigns) ? NULL : simplified;
+}
+
+/* Alguma atribuição abaixo de `root`? */
+static bool has_inner_assign(Node *root) {
+    Node *buf[64];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(Node*));
+
+    bool found = false;
+    *(Node**)ws_push(&stack) = root;
+    while (!found && !ws_empty(&stack)) {
+        Node *e = *(Node**)ws_top(&stack);
+        ws_pop(&stack);
+        if (!e) continue;
+
+        switch (e->kind) {
+            case ND_UNARY:
+                *(Node**)ws_push(&stack) = e->u.as_unary.expr;
+                break;
+            case ND_BINARY:
+                *(Node**)ws_push(&stack) = e->u.as_binary.left;
+                *(Node**)ws_push(&stack) = e->u.as_binary.right;
+                break;
+            case ND_ASSIGN:
+                if (e != root) found = true;
+                else *(Node**)ws_push(&stack) = e->u.as_assign.value;
+                break;
+            case ND_CALL:
+                for (size_t i = 0; i < e->u.as_call.arg_count; i++)
+                    *(Node**)ws_push(&stack) = e->u.as_call.args[i];
+                break;
+            default:
+                break;
+        }
+    }
+
+    ws_free(&stack);
+    return found;
+}
+
+/* Literal de uma declaração constante (propagação); NULL se não for */
+static const Node *const_value(const Folder *fd, int32_t d) {
+    if (!fd->propagate || d < 0 || d >= fd->decl_total) return NULL;
+    return fd->decls[d].state == CV_CONST ? fd->decls[d].value : NULL;
+}
+
+static Node *fold_expr(Folder *fd, Node *root, bool binding, TypeTag *type) {
+    FoldFrame buf[32];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(FoldFrame));
+    fold_push(&stack, root, binding);
+    bool assigns = has_inner_assign(root);
+
+    Node   *ret = NULL;          /* nó do último quadro encerrado */
+    TypeTag ret_t = TY_INVALID;  /* e o tipo dele */
+
+    while (!ws_empty(&stack)) {
+        FoldFrame *f = (FoldFrame*)ws_top(&stack);
+        Node *e = f->e;
+
+        /* f não vale mais depois de fold_push: o estágio é gravado antes */
+        #define CALL(child, next, bind) do { f->stage = (next); fold_push(&stack, (child), (bind)); } while (0)
+        #define RETURN(node, t)         do { ret = (node); ret_t = (t); ws_pop(&stack); } while (0)
+
+        if (!e) { RETURN(NULL, TY_INVALID); continue; }
+
+        switch (e->kind) {
+            case ND_INT:
+            case ND_FLOAT:
+            case ND_BOOL:
+            case ND_STRING:
+                RETURN(e, literal_type(e));
+                break;
+
+            case ND_IDENT: {
+                const FoldVar *v = visible_var(fd, e->u.as_ident.name);
+                const Node *c = v ? const_value(fd, v->decl) : NULL;
+                if (c) RETURN((Node*)c, v->type);
+                else RETURN(e, v ? v->type : TY_INVALID);
+                break;
+            }
+
+            case ND_UNARY: {
+                if (f->stage == 0) { CALL(e->u.as_unary.expr, 1, false); break; }
+                UnOp op = e->u.as_unary.op;
+                TypeTag t = (op == UN_NOT) ? TY_BOOL : ret_t;
+                Node *s = pick(simplify_unary(op, ret), f->binding, assigns);
+                if (s) RETURN(s, t);
+                else if (ret != e->u.as_unary.expr) RETURN(ast_unary(op, ret), t);
+                else RETURN(e, t);
+                break;
+            }
+
+            case ND_BINARY: {
+                if (f->stage == 0) { CALL(e->u.as_binary.left, 1, false); break; }
+                if (f->stage == 1) {
+                    f->left = ret;
+                    f->lt = ret_t;
+                    CALL(e->u.as_binary.right, 2, false);
+                    break;
+                }
+                BinOp op = e->u.as_binary.op;
+                Node *l = f->left, *r = ret;
+                TypeTag t = infer_binary(op, f->lt, ret_t);
+                Node *s = pick(simplify_binary(op, l, f->lt, r, ret_t), f->binding, assigns);
+                if (s) RETURN(s, t);
+                else if (l != e->u.as_binary.left || r != e->u.as_binary.right)
+                    RETURN(ast_binary(op, l, r), t);
+                else RETURN(e, t);
+                break;
+            }
+
+            case ND_ASSIGN:
+                if (f->stage == 0) { CALL(e->u.as_assign.value, 1, true); break; }
+                RETURN(ret != e->u.as_assign.value ? ast_assign(e->u.as_assign.name, ret) : e, ret_t);
+                break;
+
+            case ND_CALL: {
+                size_t argc = e->u.as_call.arg_count;
+                if (f->stage == 1) {
+                    if (!f->args && ret != e->u.as_call.args[f->i]) {
+                        f->args = (Node**)ast_alloc(argc * sizeof(Node*));
+                        memcpy(f->args, e->u.as_call.args, argc * sizeof(Node*));
+                    }
+                    if (f->args) f->args[f->i] = ret;
+                    f->i++;
+                }
+                if (f->i < argc) { CALL(e->u.as_call.args[f->i], 1, false); break; }
+
+                TypeTag t = fun_type(fd, e->u.as_call.name);
+                RETURN(f->args ? ast_call(e->u.as_call.name, f->args, argc) : e, t);
+                break;
+            }
+
+            default:
+                RETURN(e, TY_INVALID);
+                break;
+        }
+
+        #undef CALL
+        #undef RETURN
+    }
+
+    ws_free(&stack);
+    if (type) *type = ret_t;
+    return ret;
+}
+
+/* =========================================================
+ * Statements (recursivos, como check_stmt)
+ * ========================================================= */
+static Node *fold_any(Folder *fd, Node *s);
+
+static bool is_bool(const Node *n, bool value) {
+    return n && n->kind == ND_BOOL && n->u.as_bool.value == value;
+}
+
+static Node *fold_block(Folder *fd, Node *blk) {
+    size_t mark = fd->undo_count;
+    size_t count = blk->u.as_block.count;
+    Node *out = NULL;   /* cópia, a partir da primeira instrução que mudou */
+
+    for (size_t i = 0; i < count; i++) {
+        Node *s = blk->u.as_block.stmts[i];
+        Node *t = fold_any(fd, s);
+        if (!out && t != s) {
+            out = ast_block();
+            for (size_t j = 0; j < i; j++) ast_block_add_stmt(out, blk->u.as_block.stmts[j]);
+        }
+        if (out && t) ast_block_add_stmt(out, t);
+    }
+
+    leave_scope(fd, mark);
+    return out ? out : blk;
+}
+
+static Node *fold_function(Folder *fd, Node *fn) {
+    size_t mark = fd->undo_count;
+    fold_declare_function(fd, fn->u.as_function.name, fn->u.as_function.ret_type);
+
+    for (size_t i = 0; i < fn->u.as_function.param_count; i++) {
+        Node *pd = fn->u.as_function.params[i];
+        declare_var(fd, pd->u.as_decl.name, pd->u.as_decl.type);
+    }
+    Node *body = fold_any(fd, fn->u.as_function.body);
+    leave_scope(fd, mark);
+
+    if (body == fn->u.as_function.body) return fn;
+    return ast_function(fn->u.as_function.ret_type, fn->u.as_function.name,
+                        fn->u.as_function.params, fn->u.as_function.param_count, body);
+}
+
+static Node *fold_any(Folder *fd, Node *s) {
+    if (!s) return NULL;
+    switch (s->kind) {
+        case ND_BLOCK:
+            return fold_block(fd, s);
+
+        case ND_DECL: {
+            Node *init = s->u.as_decl.init;
+            Node *v = init ? fold_expr(fd, init, true, NULL) : NULL;
+            declare_var(fd, s->u.as_decl.name, s->u.as_decl.type);
+            return v == init ? s : ast_decl(s->u.as_decl.type, s->u.as_decl.name, v);
+        }
+
+        case ND_ASSIGN:
+            return fold_expr(fd, s, false, NULL);
+
+        case ND_EXPR: {
+            Node *v = fold_expr(fd, s->u.as_expr.expr, false, NULL);
+            /* sobrou só um valor, sem efeito nenhum */
+            if (v && (literal_type(v) != TY_INVALID || v->kind == ND_IDENT)) return NULL;
+            return v == s->u.as_expr.expr ? s : ast_expr(v);
+        }
+
+        /* Os ramos descartados também são percorridos: uma declaração
+         * fora de bloco vale no escopo corrente (check_if) */
+        case ND_IF: {
+            Node *cond   = fold_expr(fd, s->u.as_if.cond, false, NULL);
+            Node *then_b = fold_any(fd, s->u.as_if.then_branch);
+            Node *else_b = fold_any(fd, s->u.as_if.else_branch);
+            if (is_bool(cond, true))  return then_b;
+            if (is_bool(cond, false)) return else_b;
+
+            if (cond == s->u.as_if.cond && then_b == s->u.as_if.then_branch &&
+                else_b == s->u.as_if.else_branch) return s;
+            return ast_if(cond, then_b ? then_b : ast_block(), else_b);
+        }
+
+        case ND_WHILE: {
+            Node *cond = fold_expr(fd, s->u.as_while.cond, false, NULL);
+            Node *body = fold_any(fd, s->u.as_while.body);
+            if (is_bool(cond, false)) return NULL;
+
+            if (cond == s->u.as_while.cond && body == s->u.as_while.body) return s;
+            return ast_while(cond, body);
+        }
+
+        case ND_FOR: {
+            /* sem escopo próprio: o init vale depois do for (check_for) */
+            Node *init = fold_any(fd, s->u.as_for.init);
+            Node *cond = fold_expr(fd, s->u.as_for.cond, false, NULL);
+            Node *step = fold_any(fd, s->u.as_for.step);
+            Node *body = fold_any(fd, s->u.as_for.body);
+            if (is_bool(cond, false)) return init;
+
+            if (init == s->u.as_for.init && cond == s->u.as_for.cond &&
+                step == s->u.as_for.step && body == s->u.as_for.body) return s;
+            return ast_for(init, cond, step, body);
+        }
+
+        case ND_RETURN: {
+            Node *v = fold_expr(fd, s->u.as_return.expr, false, NULL);
+            return v == s->u.as_return.expr ? s : ast_return(v);
+        }
+
+        case ND_FUNCTION:
+            return fold_function(fd, s);
+
+        default:
+            return s;
+    }
+}
+
+Node *fold_stmt(Folder *fd, Node *stmt) {
+    return fold_any(fd, stmt);
+}
+
+/* =========================================================
+ * Propagação de constantes (programa inteiro)
+ *   - fold_scan_stmt() percorre cada instrução de nível superior como
+ *     fold_any (mesmos escopos, mesma numeração das declarações) sem
+ *     mudar nada: o inicializador de cada declaração vira a fonte dela,
+ *     quem é atribuído em algum lugar (ou não tem inicializador) fica
+ *     CV_VARYING e os argumentos das chamadas diretas são guardados;
+ *   - fold_scan_finish() dá aos parâmetros das funções de nível superior
+ *     definidas uma só vez (e nunca aninhadas) os argumentos das
+ *     chamadas como fontes; os das outras ficam sem valor. Depois, o
+ *     ponto fixo por lista de trabalho: uma declaração só desce no
+ *     reticulado (no máximo duas vezes) e, quando desce, reavalia as
+ *     que a leem — custo linear no tamanho do programa;
+ *   - O valor é convertido para o tipo da declaração (int para float;
+ *     float para int não é propagado).
+ * ========================================================= */
+static int32_t new_link(Folder *fd, int32_t item, int32_t next) {
+    fold_grow((void**)&fd->links, &fd->link_cap, fd->link_count + 1, sizeof(ConstLink));
+    fd->links[fd->link_count] = (ConstLink){ item, next };
+    return (int32_t)fd->link_count++;
+}
+
+static int32_t new_term(Folder *fd, TermKind kind, int op, int32_t a, int32_t b, Node *lit) {
+    fold_grow((void**)&fd->terms, &fd->term_cap, fd->term_count + 1, sizeof(ConstTerm));
+    fd->terms[fd->term_count] = (ConstTerm){ kind, op, a, b, lit };
+    return (int32_t)fd->term_count++;
+}
+
+/* Termo de `e` com os nomes visíveis agora; -1 se desconhecido (chamada,
+ * atribuição, nome sem declaração ou mais de TERM_BUDGET nós) */
+static int32_t term_of(Folder *fd, Node *e, int *budget) {
+    if (!e || --*budget < 0) return -1;
+    switch (e->kind) {
+        case ND_INT:
+        case ND_FLOAT:
+        case ND_BOOL:
+        case ND_STRING:
+            return new_term(fd, TERM_LIT, 0, -1, -1, ast_copy_to(fd->arena, e));
+
+        case ND_IDENT: {
+            const FoldVar *v = visible_var(fd, e->u.as_ident.name);
+            return v ? new_term(fd, TERM_VAR, 0, v->decl, -1, NULL) : -1;
+        }
+
+        case ND_UNARY: {
+            int32_t a = term_of(fd, e->u.as_unary.expr, budget);
+            return a < 0 ? -1 : new_term(fd, TERM_UNARY, e->u.as_unary.op, a, -1, NULL);
+        }
+
+        case ND_BINARY: {
+            int32_t a = term_of(fd, e->u.as_binary.left, budget);
+            int32_t b = a < 0 ? -1 : term_of(fd, e->u.as_binary.right, budget);
+            return b < 0 ? -1 : new_term(fd, TERM_BINARY, e->u.as_binary.op, a, b, NULL);
+        }
+
+        default:
+            return -1;
+    }
+}
+
+/* A declaração `d` lê as variáveis do termo `t` */
+static void add_users(Folder *fd, int32_t t, int32_t d) {
+    const ConstTerm *term = &fd->terms[t];
+    switch (term->kind) {
+        case TERM_VAR:
+            fd->decls[term->a].users = new_link(fd, d, fd->decls[term->a].users);
+            break;
+        case TERM_UNARY:
+            add_users(fd, term->a, d);
+            break;
+        case TERM_BINARY:
+            add_users(fd, term->a, d);
+            add_users(fd, term->b, d);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Mais uma fonte de `d`; uma desconhecida (-1) já a faz variar */
+static void add_source(Folder *fd, int32_t d, int32_t t) {
+    if (t < 0) {
+        fd->decls[d].state = CV_VARYING;
+        return;
+    }
+    fd->decls[d].srcs = new_link(fd, t, fd->decls[d].srcs);
+    add_users(fd, t, d);
+}
+
+static void scan_call(Folder *fd, Node *call) {
+    uint32_t id = intern_id(call->u.as_call.name);
+    fold_reserve(fd, id);
+    size_t argc = call->u.as_call.arg_count;
+    size_t first = fd->arg_count;
+    fold_grow((void**)&fd->call_args, &fd->arg_cap, first + argc, sizeof(int32_t));
+    for (size_t i = 0; i < argc; i++) {
+        int budget = TERM_BUDGET;
+        fd->call_args[first + i] = term_of(fd, call->u.as_call.args[i], &budget);
+    }
+    fd->arg_count += argc;
+
+    fold_grow((void**)&fd->calls, &fd->call_cap, fd->call_count + 1, sizeof(ConstCall));
+    fd->calls[fd->call_count] = (ConstCall){ (int32_t)first, (uint32_t)argc, fd->funs[id].calls };
+    fd->funs[id].calls = (int32_t)fd->call_count++;
+}
+
+/* Atribuições e chamadas de uma expressão (iterativo, como has_inner_assign) */
+static void scan_expr(Folder *fd, Node *root) {
+    Node *buf[64];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(Node*));
+
+    *(Node**)ws_push(&stack) = root;
+    while (!ws_empty(&stack)) {
+        Node *e = *(Node**)ws_top(&stack);
+        ws_pop(&stack);
+        if (!e) continue;
+
+        switch (e->kind) {
+            case ND_UNARY:
+                *(Node**)ws_push(&stack) = e->u.as_unary.expr;
+                break;
+            case ND_BINARY:
+                *(Node**)ws_push(&stack) = e->u.as_binary.left;
+                *(Node**)ws_push(&stack) = e->u.as_binary.right;
+                break;
+            case ND_ASSIGN: {
+                const FoldVar *v = visible_var(fd, e->u.as_assign.name);
+                if (v) fd->decls[v->decl].state = CV_VARYING;
+                *(Node**)ws_push(&stack) = e->u.as_assign.value;
+                break;
+            }
+            case ND_CALL:
+                scan_call(fd, e);
+                for (size_t i = 0; i < e->u.as_call.arg_count; i++)
+                    *(Node**)ws_push(&stack) = e->u.as_call.args[i];
+                break;
+            default:
+                break;
+        }
+    }
+
+    ws_free(&stack);
+}
+
+static void scan_any(Folder *fd, Node *s);
+
+static void scan_function(Folder *fd, Node *fn) {
+    uint32_t id = intern_id(fn->u.as_function.name);
+    fold_reserve(fd, id);
+    FoldFun *f = &fd->funs[id];
+    f->defs++;
+    if (fd->fn_depth > 0) f->nested = true;
+    f->first_param = fd->next_decl;
+    f->param_count = (uint32_t)fn->u.as_function.param_count;
+
+    size_t mark = fd->undo_count;
+    for (size_t i = 0; i < fn->u.as_function.param_count; i++) {
+        Node *pd = fn->u.as_function.params[i];
+        declare_var(fd, pd->u.as_decl.name, pd->u.as_decl.type);
+    }
+    fd->fn_depth++;
+    scan_any(fd, fn->u.as_function.body);
+    fd->fn_depth--;
+    leave_scope(fd, mark);
+}
+
+/* Mesma ordem de fold_any (os ramos de if/while/for todos visitados) */
+static void scan_any(Folder *fd, Node *s) {
+    if (!s) return;
+    switch (s->kind) {
+        case ND_BLOCK: {
+            size_t mark = fd->undo_count;
+            for (size_t i = 0; i < s->u.as_block.count; i++) scan_any(fd, s->u.as_block.stmts[i]);
+            leave_scope(fd, mark);
+            break;
+        }
+
+        case ND_DECL: {
+            /* o termo enxerga o nome de fora, como o inicializador */
+            Node *init = s->u.as_decl.init;
+            int budget = TERM_BUDGET;
+            int32_t t = -1;
+            if (init) {
+                scan_expr(fd, init);
+                t = term_of(fd, init, &budget);
+            }
+            add_source(fd, declare_var(fd, s->u.as_decl.name, s->u.as_decl.type), t);
+            break;
+        }
+
+        case ND_ASSIGN:
+            scan_expr(fd, s);
+            break;
+
+        case ND_EXPR:
+            scan_expr(fd, s->u.as_expr.expr);
+            break;
+
+        case ND_IF:
+            scan_expr(fd, s->u.as_if.cond);
+            scan_any(fd, s->u.as_if.then_branch);
+            scan_any(fd, s->u.as_if.else_branch);
+            break;
+
+        case ND_WHILE:
+            scan_expr(fd, s->u.as_while.cond);
+            scan_any(fd, s->u.as_while.body);
+            break;
+
+        case ND_FOR:
+            scan_any(fd, s->u.as_for.init);
+            scan_expr(fd, s->u.as_for.cond);
+            scan_any(fd, s->u.as_for.step);
+            scan_any(fd, s->u.as_for.body);
+            break;
+
+        case ND_RETURN:
+            scan_expr(fd, s->u.as_return.expr);
+            break;
+
+        case ND_FUNCTION:
+            scan_function(fd, s);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void fold_scan_stmt(Folder *fd, Node *stmt) {
+    if (!fd->arena) fd->arena = arena_new();
+    fd->scanning = true;
+    scan_any(fd, stmt);
+}
+
+static bool same_literal(const Node *a, const Node *b) {
+    if (a->kind != b->kind) return false;
+    switch (a->kind) {
+        case ND_INT:    return a->u.as_int.value == b->u.as_int.value;
+        case ND_FLOAT:  return memcmp(&a->u.as_float.value, &b->u.as_float.value, sizeof(double)) == 0;
+        case ND_BOOL:   return a->u.as_bool.value == b->u.as_bool.value;
+        case ND_STRING: return a->u.as_string.id == b->u.as_string.id;
+        default:        return false;
+    }
+}
+
+/* Literal `v` como valor de uma declaração do tipo `type`; NULL se não dá */
+static Node *const_as(Node *v, TypeTag type) {
+    TypeTag t = literal_type(v);
+    double x;
+    if (t == type) return v;
+    if (type == TY_FLOAT && t == TY_INT && numeric_value(v, &x)) return make_float(x);
+    return NULL;
+}
+
+/* Valor do termo `t` (em *out, se CV_CONST) com os valores atuais */
+static ConstState term_value(Folder *fd, int32_t t, Node **out) {
+    if (t < 0) return CV_VARYING;
+    const ConstTerm *term = &fd->terms[t];
+    switch (term->kind) {
+        case TERM_LIT:
+            *out = term->lit;
+            return CV_CONST;
+
+        case TERM_VAR:
+            *out = fd->decls[term->a].value;
+            return fd->decls[term->a].state;
+
+        case TERM_UNARY: {
+            Node *x = NULL;
+            ConstState s = term_value(fd, term->a, &x);
+            if (s != CV_CONST) return s;
+            *out = simplify_unary((UnOp)term->op, x);
+            return *out ? CV_CONST : CV_VARYING;
+        }
+
+        case TERM_BINARY: {
+            Node *l = NULL, *r = NULL;
+            ConstState a = term_value(fd, term->a, &l);
+            ConstState b = term_value(fd, term->b, &r);
+            if (a == CV_VARYING || b == CV_VARYING) return CV_VARYING;
+            if (a == CV_UNKNOWN || b == CV_UNKNOWN) return CV_UNKNOWN;
+            BinOp op = (BinOp)term->op;
+            TypeTag type = infer_binary(op, literal_type(l), literal_type(r));
+            *out = type != TY_INVALID ? fold_constants(op, l, r, type) : NULL;
+            return *out ? CV_CONST : CV_VARYING;
+        }
+    }
+    return CV_VARYING;
+}
+
+/* Reavalia `d` pelas fontes; true se ela desceu no reticulado */
+static bool const_update(Folder *fd, int32_t d) {
+    ConstDecl *c = &fd->decls[d];
+    if (c->state == CV_VARYING) return false;
+
+    ConstState st = CV_UNKNOWN;
+    Node *val = NULL;
+    for (int32_t l = c->srcs; l >= 0 && st != CV_VARYING; l = fd->links[l].next) {
+        Node *v = NULL;
+        ConstState s = term_value(fd, fd->links[l].item, &v);
+        if (s == CV_CONST && !(v = const_as(v, c->type))) s = CV_VARYING;
+        if (s == CV_UNKNOWN) continue;
+        if (s == CV_VARYING || (st == CV_CONST && !same_literal(val, v))) st = CV_VARYING;
+        else if (st == CV_UNKNOWN) { st = CV_CONST; val = v; }
+    }
+
+    /* nunca sobe; um valor constante que muda passa a variar */
+    if (st < c->state) return false;
+    if (st == c->state) {
+        if (st != CV_CONST || same_literal(val, c->value)) return false;
+        st = CV_VARYING;
+    }
+    c->state = st;
+    c->value = (st == CV_CONST) ? val : NULL;
+    return true;
+}
+
+void fold_scan_finish(Folder *fd) {
+    if (!fd->arena) fd->arena = arena_new();
+    leave_scope(fd, 0);
+    fd->decl_total = fd->next_decl;
+    fd->next_decl = 0;
+    fd->scanning = false;
+    fd->propagate = true;
+
+    /* argumentos das chamadas diretas -> parâmetros */
+    for (size_t id = 0; id < fd->cap; id++) {
+        const FoldFun *f = &fd->funs[id];
+        if (f->defs != 1 || f->nested) continue;
+        for (int32_t k = f->calls; k >= 0; k = fd->calls[k].next) {
+            const ConstCall *call = &fd->calls[k];
+            for (uint32_t i = 0; i < f->param_count; i++)
+                add_source(fd, f->first_param + (int32_t)i,
+                           i < call->argc ? fd->call_args[call->args + i] : -1);
+        }
+    }
+
+    /* os literais calculados ficam na arena do Folder */
+    Arena *prev = ast_set_arena(fd->arena);
+    int32_t buf[256];
+    WorkStack work;
+    ws_init(&work, buf, sizeof buf, sizeof(int32_t));
+    for (int32_t d = fd->decl_total - 1; d >= 0; d--) *(int32_t*)ws_push(&work) = d;
+
+    while (!ws_empty(&work)) {
+        int32_t d = *(int32_t*)ws_top(&work);
+        ws_pop(&work);
+        if (!const_update(fd, d)) continue;
+        for (int32_t l = fd->decls[d].users; l >= 0; l = fd->links[l].next)
+            *(int32_t*)ws_push(&work) = fd->links[l].item;
+    }
+
+    ws_free(&work);
+    ast_set_arena(prev);
+}
@@ -1,99 +1,107 @@
 #include "ast_free.h"
+#include "work_stack.h"
 #include <stdlib.h>
 
+/* Empilha um filho (nós da arena, e seus filhos, só são liberados junto com ela) */
+static inline void push(WorkStack *s, Node *child) {
+  if (!child || (child->flags & NODE_ARENA)) return;
+  __builtin_prefetch(child);
+  *(Node **)ws_push(s) = child;
+}
+
+static void push_list(WorkStack *s, Node **items, size_t count) {
+  for (size_t i = 0; i < count; i++) push(s, items[i]);
+}
+
+/* Iterativo: a pilha de trabalho fica no heap, qualquer profundidade */
 void ast_free(Node *node) {
-  if (!node) return;
-
-  switch (node -> kind) {
-    case ND_INT:
-      break;
-
-    case ND_FLOAT:
-      break;
-
-    case ND_BOOL:
-      break;
-
-    case ND_IDENT:
-      free(node -> u.as_ident.name);
-      break;
-
-    case ND_STRING:
-      free(node -> u.as_string.value);
-      break;
-
-    case ND_UNARY:
-      ast_free(node -> u.as_unary.expr);
-      break;
-
-    case ND_BINARY:
-      ast_free(node -> u.as_binary.left);
-      ast_free(node -> u.as_binary.right);
-      break;
-
-    case ND_BLOCK:
-      for (size_t i = 0; i < node -> u.as_block.count; i++) {
-        ast_free(node -> u.as_block.stmts[i]);
-      }
-      free(node -> u.as_block.stmts);
-      break;
-
-    case ND_ASSIGN:
-      free(node -> u.as_assign.name);
-      ast_free(node -> u.as_assign.value);
-      break;
-
-    case ND_EXPR:
-      ast_free(node -> u.as_expr.expr);
-      break;
-
-    case ND_IF:
-      ast_free(node -> u.as_if.cond);
-      ast_free(node -> u.as_if.then_branch);
-      if (node->u.as_if.else_branch) ast_free(node->u.as_if.else_branch);
-      break;
-
-    case ND_DECL:
-      free(node->u.as_decl.name);
-      if (node->u.as_decl.init) ast_free(node->u.as_decl.init);
-      break;
-
-    case ND_WHILE:
-      if (node->u.as_while.cond) ast_free(node->u.as_while.cond);
-      if (node->u.as_while.body) ast_free(node->u.as_while.body);
-      break;
-
-    case ND_FOR:
-      if (node->u.as_for.init) ast_free(node->u.as_for.init);
-      if (node->u.as_for.cond) ast_free(node->u.as_for.cond);
-      if (node->u.as_for.step) ast_free(node->u.as_for.step);
-      if (node->u.as_for.body) ast_free(node->u.as_for.body);
-      break;
-
-    case ND_FUNCTION: {
-      free(node->u.as_function.name);
-      for (size_t i = 0; i < node->u.as_function.param_count; i++) {
-          ast_free(node->u.as_function.params[i]);
-      }
-      free(node->u.as_function.params);
-      ast_free(node->u.as_function.body);
-      break;
+  Node *buf[64];
+  WorkStack stack;
+  ws_init(&stack, buf, sizeof buf, sizeof(Node *));
+  push(&stack, node);
+
+  while (!ws_empty(&stack)) {
+    node = *(Node **)ws_top(&stack);
+    ws_pop(&stack);
+
+    switch (node -> kind) {
+      case ND_INT:
+        break;
+
+      case ND_FLOAT:
+        break;
+
+      case ND_BOOL:
+        break;
+
+      case ND_IDENT: /* nomes são internados (intern.h): não são liberados aqui */
+        break;
+
+      case ND_STRING: /* o texto pertence ao pool de literais (str_pool.h) */
+        break;
+
+      case ND_UNARY:
+        push(&stack, node -> u.as_unary.expr);
+        break;
+
+      case ND_BINARY:
+        push(&stack, node -> u.as_binary.left);
+        push(&stack, node -> u.as_binary.right);
+        break;
+
+      case ND_BLOCK:
+        push_list(&stack, node -> u.as_block.stmts, node -> u.as_block.count);
+        free(node -> u.as_block.stmts);
+        break;
+
+      case ND_ASSIGN:
+        push(&stack, node -> u.as_assign.value);
+        break;
+
+      case ND_EXPR:
+        push(&stack, node -> u.as_expr.expr);
+        break;
+
+      case ND_IF:
+        push(&stack, node -> u.as_if.cond);
+        push(&stack, node -> u.as_if.then_branch);
+        push(&stack, node -> u.as_if.else_branch);
+        break;
+
+      case ND_DECL:
+        push(&stack, node -> u.as_decl.init);
+        break;
+
+      case ND_WHILE:
+        push(&stack, node -> u.as_while.cond);
+        push(&stack, node -> u.as_while.body);
+        break;
+
+      case ND_FOR:
+        push(&stack, node -> u.as_for.init);
+        push(&stack, node -> u.as_for.cond);
+        push(&stack, node -> u.as_for.step);
+        push(&stack, node -> u.as_for.body);
+        break;
+
+      case ND_FUNCTION:
+        push_list(&stack, node -> u.as_function.params, node -> u.as_function.param_count);
+        free(node -> u.as_function.params);
+        push(&stack, node -> u.as_function.body);
+        break;
+
+      case ND_RETURN:
+        push(&stack, node -> u.as_return.expr);
+        break;
+
+      case ND_CALL:
+        push_list(&stack, node -> u.as_call.args, node -> u.as_call.arg_count);
+        free(node -> u.as_call.args);
+        break;
     }
 
-    case ND_RETURN:
-      if (node->u.as_return.expr) ast_free(node->u.as_return.expr);
-      break;
-
-    case ND_CALL:
-      if (node->u.as_call.args) {
-        for (size_t i = 0; i < node->u.as_call.arg_count; i++) {
-          ast_free(node->u.as_call.args[i]);
-        }
-        free(node->u.as_call.args);
-      }
-      free(node->u.as_call.name);
-      break;
+    free(node);
   }
 
-  free(node);
+  ws_free(&stack);
 }
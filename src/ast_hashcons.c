@@ -0,0 +1,291 @@
+#include "ast_hashcons.h"
+#include "arena.h"
+#include "work_stack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HASHCONS_INITIAL_SLOTS 256
+
+typedef struct {
+    Node    *node;      /* NULL = vazio */
+    uint32_t hash;
+} HcSlot;
+
+struct HashCons {
+    Arena  *arena;      /* dona dos nós compartilhados */
+    HcSlot *slots;      /* endereçamento aberto */
+    size_t  cap;        /* potência de 2 */
+    size_t  count;
+};
+
+/* Tabela corrente (uma por thread, como a arena em ast_base.c) */
+static _Thread_local HashCons *g_hashcons = NULL;
+
+HashCons *hashcons_new(Arena *arena) {
+    HashCons *hc = (HashCons*)xmalloc(sizeof(HashCons));
+    hc->arena = arena;
+    hc->slots = NULL;
+    hc->cap = 0;
+    hc->count = 0;
+    return hc;
+}
+
+void hashcons_free(HashCons *hc) {
+    if (!hc) return;
+    if (g_hashcons == hc) g_hashcons = NULL;
+    free(hc->slots);
+    free(hc);
+}
+
+HashCons *ast_set_hashcons(HashCons *hc) {
+    HashCons *prev = g_hashcons;
+    g_hashcons = hc;
+    return prev;
+}
+
+/* Só compartilha enquanto os nós novos forem para a arena da tabela */
+static HashCons *active(void) {
+    HashCons *hc = g_hashcons;
+    return hc && ast_get_arena() == hc->arena ? hc : NULL;
+}
+
+static inline uint64_t mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+static inline uint64_t ptr_bits(const void *p) { return (uint64_t)(uintptr_t)p; }
+
+/* Hash da estrutura de um nível: filhos entram pelo ponteiro (já são
+ * únicos). Retorna false para tipos que não são compartilhados. */
+static bool shallow_hash(const Node *n, uint32_t *out) {
+    uint64_t h = mix(0, (uint64_t)n->kind);
+    switch (n->kind) {
+        case ND_INT:    h = mix(h, (uint64_t)n->u.as_int.value); break;
+        case ND_BOOL:   h = mix(h, n->u.as_bool.value ? 1 : 0); break;
+        case ND_IDENT:  h = mix(h, ptr_bits(n->u.as_ident.name)); break;
+        case ND_STRING: h = mix(h, n->u.as_string.id); break;
+
+        case ND_FLOAT: {
+            uint64_t bits;
+            memcpy(&bits, &n->u.as_float.value, sizeof bits);
+            h = mix(h, bits);
+            break;
+        }
+
+        case ND_UNARY:
+            h = mix(h, (uint64_t)n->u.as_unary.op);
+            h = mix(h, ptr_bits(n->u.as_unary.expr));
+            break;
+
+        case ND_BINARY:
+            h = mix(h, (uint64_t)n->u.as_binary.op);
+            h = mix(h, ptr_bits(n->u.as_binary.left));
+            h = mix(h, ptr_bits(n->u.as_binary.right));
+            break;
+
+        default:
+            return false;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    *out = (uint32_t)h;
+    return true;
+}
+
+/* Mesma estrutura de um nível (filhos por ponteiro); floats por bits,
+ * então 0.0 e -0.0 continuam distintos */
+static bool shallow_equal(const Node *a, const Node *b) {
+    if (a->kind != b->kind) return false;
+    switch (a->kind) {
+        case ND_INT:    return a->u.as_int.value == b->u.as_int.value;
+        case ND_FLOAT:  return memcmp(&a->u.as_float.value, &b->u.as_float.value, sizeof(double)) == 0;
+        case ND_BOOL:   return a->u.as_bool.value == b->u.as_bool.value;
+        case ND_IDENT:  return a->u.as_ident.name == b->u.as_ident.name;
+        case ND_STRING: return a->u.as_string.id == b->u.as_string.id;
+        case ND_UNARY:
+            return a->u.as_unary.op == b->u.as_unary.op && a->u.as_unary.expr == b->u.as_unary.expr;
+        case ND_BINARY:
+            return a->u.as_binary.op == b->u.as_binary.op &&
+                   a->u.as_binary.left == b->u.as_binary.left &&
+                   a->u.as_binary.right == b->u.as_binary.right;
+        default:
+            return false;
+    }
+}
+
+static void grow_slots(HashCons *hc) {
+    size_t new_cap = hc->cap ? hc->cap * 2 : HASHCONS_INITIAL_SLOTS;
+    HcSlot *slots = (HcSlot*)calloc(new_cap, sizeof(HcSlot));
+    if (!slots) { fprintf(stderr, "error: calloc failed\n"); exit(1); }
+
+    for (size_t i = 0; i < hc->cap; i++) {
+        if (!hc->slots[i].node) continue;
+        size_t j = hc->slots[i].hash & (new_cap - 1);
+        while (slots[j].node) j = (j + 1) & (new_cap - 1);
+        slots[j] = hc->slots[i];
+    }
+    free(hc->slots);
+    hc->slots = slots;
+    hc->cap = new_cap;
+}
+
+Node *hashcons_intern(const Node *key) {
+    HashCons *hc = active();
+    uint32_t h;
+    if (!hc || !shallow_hash(key, &h)) return NULL;
+
+    /* mantém fator de carga <= 1/2 */
+    if ((hc->count + 1) * 2 > hc->cap) grow_slots(hc);
+
+    size_t mask = hc->cap - 1;
+    size_t i = h & mask;
+    for (Node *n; (n = hc->slots[i].node) != NULL; i = (i + 1) & mask)
+        if (hc->slots[i].hash == h && shallow_equal(n, key)) return n;
+
+    Node *node = new_node(key->kind);
+    node->flags |= NODE_SHARED;
+    node->u = key->u;
+
+    hc->slots[i].node = node;
+    hc->slots[i].hash = h;
+    hc->count++;
+    return node;
+}
+
+bool hashcons_owns(const Node *node) {
+    HashCons *hc = active();
+    uint32_t h;
+    if (!hc || !node || !(node->flags & NODE_SHARED) || hc->count == 0) return false;
+    if (!shallow_hash(node, &h)) return false;
+
+    size_t mask = hc->cap - 1;
+    for (size_t i = h & mask; hc->slots[i].node; i = (i + 1) & mask)
+        if (hc->slots[i].node == node) return true;
+    return false;
+}
+
+/* =========================================================
+ * Igualdade estrutural
+ * ========================================================= */
+typedef struct {
+    const Node *a, *b;
+} EqTask;
+
+static inline void eq_push(WorkStack *s, const Node *a, const Node *b) {
+    if (a == b) return;   /* mesmo nó (ou os dois NULL) */
+    EqTask *t = (EqTask*)ws_push(s);
+    t->a = a;
+    t->b = b;
+}
+
+static bool eq_list(WorkStack *s, Node *const *a, size_t na, Node *const *b, size_t nb) {
+    if (na != nb) return false;
+    for (size_t i = 0; i < na; i++) eq_push(s, a[i], b[i]);
+    return true;
+}
+
+/* Iterativo: pares ainda não comparados vão para a pilha */
+bool ast_equal(const Node *a, const Node *b) {
+    EqTask buf[64];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(EqTask));
+    eq_push(&stack, a, b);
+
+    bool equal = true;
+    while (equal && !ws_empty(&stack)) {
+        EqTask t = *(EqTask*)ws_top(&stack);
+        ws_pop(&stack);
+        a = t.a;
+        b = t.b;
+
+        if (!a || !b || a->kind != b->kind) { equal = false; break; }
+
+        switch (a->kind) {
+            case ND_INT:
+            case ND_FLOAT:
+            case ND_BOOL:
+            case ND_IDENT:
+            case ND_STRING:
+                equal = shallow_equal(a, b);
+                break;
+
+            case ND_UNARY:
+                equal = a->u.as_unary.op == b->u.as_unary.op;
+                eq_push(&stack, a->u.as_unary.expr, b->u.as_unary.expr);
+                break;
+
+            case ND_BINARY:
+                equal = a->u.as_binary.op == b->u.as_binary.op;
+                eq_push(&stack, a->u.as_binary.right, b->u.as_binary.right);
+                eq_push(&stack, a->u.as_binary.left,  b->u.as_binary.left);
+                break;
+
+            case ND_BLOCK:
+                equal = eq_list(&stack, a->u.as_block.stmts, a->u.as_block.count,
+                                b->u.as_block.stmts, b->u.as_block.count);
+                break;
+
+            case ND_ASSIGN:
+                equal = a->u.as_assign.name == b->u.as_assign.name;
+                eq_push(&stack, a->u.as_assign.value, b->u.as_assign.value);
+                break;
+
+            case ND_EXPR:
+                eq_push(&stack, a->u.as_expr.expr, b->u.as_expr.expr);
+                break;
+
+            case ND_IF:
+                eq_push(&stack, a->u.as_if.else_branch, b->u.as_if.else_branch);
+                eq_push(&stack, a->u.as_if.then_branch, b->u.as_if.then_branch);
+                eq_push(&stack, a->u.as_if.cond,        b->u.as_if.cond);
+                break;
+
+            case ND_DECL:
+                equal = a->u.as_decl.type == b->u.as_decl.type &&
+                        a->u.as_decl.name == b->u.as_decl.name;
+                eq_push(&stack, a->u.as_decl.init, b->u.as_decl.init);
+                break;
+
+            case ND_WHILE:
+                eq_push(&stack, a->u.as_while.body, b->u.as_while.body);
+                eq_push(&stack, a->u.as_while.cond, b->u.as_while.cond);
+                break;
+
+            case ND_FOR:
+                eq_push(&stack, a->u.as_for.body, b->u.as_for.body);
+                eq_push(&stack, a->u.as_for.step, b->u.as_for.step);
+                eq_push(&stack, a->u.as_for.cond, b->u.as_for.cond);
+                eq_push(&stack, a->u.as_for.init, b->u.as_for.init);
+                break;
+
+            case ND_FUNCTION:
+                equal = a->u.as_function.ret_type == b->u.as_function.ret_type &&
+                        a->u.as_function.name == b->u.as_function.name &&
+                        eq_list(&stack, a->u.as_function.params, a->u.as_function.param_count,
+                                b->u.as_function.params, b->u.as_function.param_count);
+                eq_push(&stack, a->u.as_function.body, b->u.as_function.body);
+                break;
+
+            case ND_RETURN:
+                eq_push(&stack, a->u.as_return.expr, b->u.as_return.expr);
+                break;
+
+            case ND_CALL:
+                equal = a->u.as_call.name == b->u.as_call.name &&
+                        eq_list(&stack, a->u.as_call.args, a->u.as_call.arg_count,
+                                b->u.as_call.args, b->u.as_call.arg_count);
+                break;
+
+            default:
+                equal = false;
+                break;
+        }
+    }
+
+    ws_free(&stack);
+    return equal;
+}
@@ -1,4 +1,5 @@
 #include "ast_printer.h"
+#include "work_stack.h"
 
 #include <stdio.h>
 
@@ -39,8 +40,61 @@ static const char *type_to_string(TypeTag type) {
     }
 }
 
-static void print (const Node *node) {
-if(!node) { printf("NULL"); return; }
+/* =========================================================
+ * Impressão iterativa
+ *   As duas impressões usam uma pilha de tarefas no heap (nó a
+ *   imprimir ou texto fixo), empilhadas em ordem inversa: a saída é
+ *   a mesma da versão recursiva, em qualquer profundidade.
+ * ========================================================= */
+typedef struct {
+  const Node *node;   /* nó a imprimir (pode ser NULL) ... */
+  const char *text;   /* ... ou texto fixo / rótulo, se não for NULL */
+  int depth;          /* recuo (só na impressão formatada) */
+} PrintTask;
+
+static void push_node(WorkStack *s, const Node *node, int depth) {
+  PrintTask *t = (PrintTask *)ws_push(s);
+  t->node = node;
+  t->text = NULL;
+  t->depth = depth;
+}
+
+static void push_text(WorkStack *s, const char *text, int depth) {
+  PrintTask *t = (PrintTask *)ws_push(s);
+  t->node = NULL;
+  t->text = text;
+  t->depth = depth;
+}
+
+/* Filhos de uma lista, do último para o primeiro, com `sep` entre eles */
+static void push_list(WorkStack *s, Node *const *items, size_t count, const char *sep) {
+  for (size_t i = count; i-- > 0; ) {
+    push_node(s, items[i], 0);
+    if (i > 0 && sep) push_text(s, sep, 0);
+  }
+}
+
+static const char *binop_spaced(BinOp op) {
+  switch (op) {
+    case BIN_ADD: return " + ";
+    case BIN_SUB: return " - ";
+    case BIN_MUL: return " * ";
+    case BIN_DIV: return " / ";
+    case BIN_EQ:  return " == ";
+    case BIN_NEQ: return " != ";
+    case BIN_LT:  return " < ";
+    case BIN_LE:  return " <= ";
+    case BIN_GT:  return " > ";
+    case BIN_GE:  return " >= ";
+    case BIN_AND: return " && ";
+    case BIN_OR:  return " || ";
+    default: return " ? ";
+  }
+}
+
+/* Imprime o começo do nó e empilha o resto (filhos e textos) */
+static void print_step(WorkStack *s, const Node *node) {
+  if (!node) { printf("NULL"); return; }
   switch (node -> kind) {
     case ND_INT:
       printf("%ld", node -> u.as_int.value);
@@ -65,55 +119,50 @@ if(!node) { printf("NULL"); return; }
     case ND_UNARY:
       printf("(");
       printf("%s", unop_to_str(node -> u.as_unary.op));
-      print(node -> u.as_unary.expr);
-      printf(")");
+      push_text(s, ")", 0);
+      push_node(s, node -> u.as_unary.expr, 0);
       break;
 
     case ND_BINARY:
       printf("(");
-      print(node -> u.as_binary.left);
-      printf(" %s ", binop_to_str(node -> u.as_binary.op));
-      print(node -> u.as_binary.right);
-      printf(")");
+      push_text(s, ")", 0);
+      push_node(s, node -> u.as_binary.right, 0);
+      push_text(s, binop_spaced(node -> u.as_binary.op), 0);
+      push_node(s, node -> u.as_binary.left, 0);
       break;
 
     case ND_BLOCK:
-    printf("{ ");
-
-    for (size_t i = 0; i < node -> u.as_block.count; i++){
-      print(node -> u.as_block.stmts[i]);
-      if (i + 1 < node -> u.as_block.count) printf(" ");
-    }
-
-    printf(" }");
-    break;
+      printf("{ ");
+      push_text(s, " }", 0);
+      push_list(s, node -> u.as_block.stmts, node -> u.as_block.count, " ");
+      break;
 
     case ND_ASSIGN:
       printf("(%s = ", node -> u.as_assign.name);
-      print(node -> u.as_assign.value);
-      printf(")");
+      push_text(s, ")", 0);
+      push_node(s, node -> u.as_assign.value, 0);
       break;
 
     case ND_EXPR:
-      print(node -> u.as_expr.expr);
-      printf(";");
+      push_text(s, ";", 0);
+      push_node(s, node -> u.as_expr.expr, 0);
       break;
 
     case ND_IF:
       printf("if (");
-      print(node -> u.as_if.cond);
-      printf(") ");
-      print(node -> u.as_if.then_branch);
       if (node -> u.as_if.else_branch) {
-        printf(" else ");
-        print(node -> u.as_if.else_branch);
+        push_node(s, node -> u.as_if.else_branch, 0);
+        push_text(s, " else ", 0);
       }
+      push_node(s, node -> u.as_if.then_branch, 0);
+      push_text(s, ") ", 0);
+      push_node(s, node -> u.as_if.cond, 0);
       break;
 
     case ND_DECL: {
       if (node->u.as_decl.init) {
         printf("%s %s = ", type_to_string(node->u.as_decl.type), node->u.as_decl.name);
-        print(node->u.as_decl.init);
+        push_node(s, node->u.as_decl.init, 0);
       } else {
         printf("%s %s", type_to_string(node->u.as_decl.type), node->u.as_decl.name);
       }
@@ -122,20 +171,20 @@ if(!node) { printf("NULL"); return; }
 
     case ND_WHILE:
       printf("while (");
-      print(node->u.as_while.cond);
-      printf(") ");
-      print(node->u.as_while.body);
+      push_node(s, node->u.as_while.body, 0);
+      push_text(s, ") ", 0);
+      push_node(s, node->u.as_while.cond, 0);
       break;
 
     case ND_FOR:
       printf("for (");
-      print(node->u.as_for.init);
-      printf("; ");
-      print(node->u.as_for.cond);
-      printf("; ");
-      print(node->u.as_for.step);
-      printf(") ");
-      print(node->u.as_for.body);
+      push_node(s, node->u.as_for.body, 0);
+      push_text(s, ") ", 0);
+      push_node(s, node->u.as_for.step, 0);
+      push_text(s, "; ", 0);
+      push_node(s, node->u.as_for.cond, 0);
+      push_text(s, "; ", 0);
+      push_node(s, node->u.as_for.init, 0);
       break;
 
     case ND_FUNCTION: {
@@ -147,26 +196,23 @@ if(!node) { printf("NULL"); return; }
         if (i + 1 < node->u.as_function.param_count) printf(", ");
       }
       printf(") ");
-      print(node->u.as_function.body);
+      push_node(s, node->u.as_function.body, 0);
       break;
     }
 
     case ND_RETURN:
       printf("return");
+      push_text(s, ";", 0);
       if (node->u.as_return.expr) {
         printf(" ");
-        print(node->u.as_return.expr);
+        push_node(s, node->u.as_return.expr, 0);
       }
-      printf(";");
       break;
 
     case ND_CALL: {
       printf("%s(", node->u.as_call.name);
-      for (size_t i = 0; i < node->u.as_call.arg_count; i++) {
-        print(node->u.as_call.args[i]);
-        if (i + 1 < node->u.as_call.arg_count) printf(", ");
-      }
-      printf(")");
+      push_text(s, ")", 0);
+      push_list(s, node->u.as_call.args, node->u.as_call.arg_count, ", ");
       break;
     }
 
@@ -174,7 +220,19 @@ if(!node) { printf("NULL"); return; }
 }
 
 void ast_print(const Node *node) {
-  print(node);
+  PrintTask buf[64];
+  WorkStack stack;
+  ws_init(&stack, buf, sizeof buf, sizeof(PrintTask));
+  push_node(&stack, node, 0);
+
+  while (!ws_empty(&stack)) {
+    PrintTask t = *(PrintTask *)ws_top(&stack);
+    ws_pop(&stack);
+    if (t.text) fputs(t.text, stdout);
+    else print_step(&stack, t.node);
+  }
+
+  ws_free(&stack);
   printf("\n");
 }
 
@@ -182,7 +240,8 @@ static void indent(int depth) {
   for (int i = 0; i < depth; i++) putchar(' ');
 }
 
-static void print_pretty(const Node *node, int depth) {
+/* Imprime a linha do nó e empilha os filhos e rótulos (em ordem inversa) */
+static void print_pretty_step(WorkStack *s, const Node *node, int depth) {
   if (!node) {
     indent(depth);
     printf("<null>\n");
@@ -213,105 +272,118 @@ static void print_pretty(const Node *node, int depth) {
 
     case ND_UNARY:
       printf("Unary(%s)\n", unop_to_str(node->u.as_unary.op));
-      print_pretty(node->u.as_unary.expr, depth + 2);
+      push_node(s, node->u.as_unary.expr, depth + 2);
       break;
 
     case ND_BINARY:
       printf("Binary(%s)\n", binop_to_str(node->u.as_binary.op));
-      print_pretty(node->u.as_binary.left,  depth + 2);
-      print_pretty(node->u.as_binary.right, depth + 2);
+      push_node(s, node->u.as_binary.right, depth + 2);
+      push_node(s, node->u.as_binary.left,  depth + 2);
       break;
 
     case ND_BLOCK:
       printf("Block\n");
-      for (size_t i = 0; i < node->u.as_block.count; i++) {
-        print_pretty(node->u.as_block.stmts[i], depth + 2);
+      for (size_t i = node->u.as_block.count; i-- > 0; ) {
+        push_node(s, node->u.as_block.stmts[i], depth + 2);
       }
       break;
 
     case ND_ASSIGN:
       printf("Assign(%s)\n", node->u.as_assign.name);
-      print_pretty(node->u.as_assign.value, depth + 2);
+      push_node(s, node->u.as_assign.value, depth + 2);
       break;
 
     case ND_EXPR:
       printf("Expression\n");
-      print_pretty(node->u.as_expr.expr, depth + 2);
+      push_node(s, node->u.as_expr.expr, depth + 2);
       break;
 
     case ND_IF:
       printf("If\n");
-      indent(depth + 2); printf("Cond:\n");
-      print_pretty(node->u.as_if.cond, depth + 4);
-      indent(depth + 2); printf("Then:\n");
-      print_pretty(node->u.as_if.then_branch, depth + 4);
       if (node->u.as_if.else_branch) {
-        indent(depth + 2); printf("Else:\n");
-        print_pretty(node->u.as_if.else_branch, depth + 4);
+        push_node(s, node->u.as_if.else_branch, depth + 4);
+        push_text(s, "Else:", depth + 2);
       }
+      push_node(s, node->u.as_if.then_branch, depth + 4);
+      push_text(s, "Then:", depth + 2);
+      push_node(s, node->u.as_if.cond, depth + 4);
+      push_text(s, "Cond:", depth + 2);
       break;
 
     case ND_DECL:
       printf("Decl(%s %s)\n", type_to_string(node->u.as_decl.type), node->u.as_decl.name);
       if (node->u.as_decl.init) {
-        indent(depth + 2); printf("Init:\n");
-        print_pretty(node->u.as_decl.init, depth + 4);
+        push_node(s, node->u.as_decl.init, depth + 4);
+        push_text(s, "Init:", depth + 2);
       }
       break;
 
     case ND_WHILE:
       printf("While\n");
-      indent(depth + 2); printf("Cond:\n");
-      print_pretty(node->u.as_while.cond, depth + 4);
-      indent(depth + 2); printf("Body:\n");
-      print_pretty(node->u.as_while.body, depth + 4);
+      push_node(s, node->u.as_while.body, depth + 4);
+      push_text(s, "Body:", depth + 2);
+      push_node(s, node->u.as_while.cond, depth + 4);
+      push_text(s, "Cond:", depth + 2);
       break;
 
     case ND_FOR:
       printf("For\n");
-      indent(depth + 2); printf("Init:\n");
-      print_pretty(node->u.as_for.init, depth + 4);
-      indent(depth + 2); printf("Cond:\n");
-      print_pretty(node->u.as_for.cond, depth + 4);
-      indent(depth + 2); printf("Step:\n");
-      print_pretty(node->u.as_for.step, depth + 4);
-      indent(depth + 2); printf("Body:\n");
-      print_pretty(node->u.as_for.body, depth + 4);
+      push_node(s, node->u.as_for.body, depth + 4);
+      push_text(s, "Body:", depth + 2);
+      push_node(s, node->u.as_for.step, depth + 4);
+      push_text(s, "Step:", depth + 2);
+      push_node(s, node->u.as_for.cond, depth + 4);
+      push_text(s, "Cond:", depth + 2);
+      push_node(s, node->u.as_for.init, depth + 4);
+      push_text(s, "Init:", depth + 2);
       break;
 
     case ND_FUNCTION:
       printf("Function(%s %s)\n", type_to_string(node->u.as_function.ret_type), node->u.as_function.name);
-      for (int i = 0; i < depth + 2; i++) putchar(' ');
-      printf("Params:\n");
-      for (size_t i = 0; i < node->u.as_function.param_count; i++) {
-        print_pretty(node->u.as_function.params[i], depth + 4);
+      push_node(s, node->u.as_function.body, depth + 4);
+      push_text(s, "Body:", depth + 2);
+      for (size_t i = node->u.as_function.param_count; i-- > 0; ) {
+        push_node(s, node->u.as_function.params[i], depth + 4);
       }
-      for (int i = 0; i < depth + 2; i++) putchar(' ');
-      printf("Body:\n");
-      print_pretty(node->u.as_function.body, depth + 4);
+      push_text(s, "Params:", depth + 2);
       break;
 
     case ND_RETURN:
       printf("Return\n");
       if (node->u.as_return.expr) {
-        for (int i = 0; i < depth + 2; i++) putchar(' ');
-        printf("Expr:\n");
-        print_pretty(node->u.as_return.expr, depth + 4);
+        push_node(s, node->u.as_return.expr, depth + 4);
+        push_text(s, "Expr:", depth + 2);
       }
       break;
 
     case ND_CALL:
       printf("Call(%s)\n", node->u.as_call.name);
       if (node->u.as_call.arg_count > 0) {
-        indent(depth + 2); printf("Args:\n");
-        for (size_t i = 0; i < node->u.as_call.arg_count; i++) {
-          print_pretty(node->u.as_call.args[i], depth + 4);
+        for (size_t i = node->u.as_call.arg_count; i-- > 0; ) {
+          push_node(s, node->u.as_call.args[i], depth + 4);
         }
+        push_text(s, "Args:", depth + 2);
       }
       break;
   }
 }
 
 void ast_print_pretty(const Node *node) {
-  print_pretty(node, 0);
+  PrintTask buf[64];
+  WorkStack stack;
+  ws_init(&stack, buf, sizeof buf, sizeof(PrintTask));
+  push_node(&stack, node, 0);
+
+  while (!ws_empty(&stack)) {
+    PrintTask t = *(PrintTask *)ws_top(&stack);
+    ws_pop(&stack);
+    if (t.text) {
+      indent(t.depth);
+      printf("%s\n", t.text);
+    } else {
+      print_pretty_step(&stack, t.node, t.depth);
+    }
+  }
+
+  ws_free(&stack);
 }
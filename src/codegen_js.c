@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include "ir.h"
+#include "intern.h"
 #include "codegen_js.h"
 
 /* -------------------------------------------------------
@@ -29,15 +30,10 @@ static int label_to_case(int label_id) {
  *  Helpers e Mapa de Variáveis
  * ------------------------------------------------------- */
 
-/* Busca nome de variável associado a um temp; se não houver, retorna NULL */
+/* Busca nome de variável associado a um temp; se não houver, retorna NULL
+ * (índice por temp em IrFunc, sem percorrer os locais) */
 static const char *js_name_for_temp(const IrFunc *f, int temp_id) {
-    if (!f) return NULL;
-    for (size_t i = 0; i < f->local_count; ++i) {
-        if (f->locals[i].temp == temp_id) {
-            return f->locals[i].name;
-        }
-    }
-    return NULL;
+    return ir_local_name(f, temp_id);
 }
 
 /* Imprime um temporário JS (nome da variável se existir) */
@@ -47,53 +43,123 @@ static void js_print_temp(const IrFunc *f, int temp_id, FILE *out) {
     else       fprintf(out, "t%d", temp_id);
 }
 
+/* Nome JS do destino: variável do fonte ou "tN" (ambos internados) */
+static const char *js_dst_name(const IrFunc *f, int temp_id) {
+    const char *vname = js_name_for_temp(f, temp_id);
+    if (vname) return vname;
+
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "t%d", temp_id);
+    return intern(buf, (size_t)n);
+}
+
 /* -------------------------------------------------------
- *  Mapa simples de variáveis declaradas em JS
+ *  Conjunto de variáveis já declaradas em JS
  *  (usado no modo SEQUENCIAL, sem labels)
+ *  Indexado pelo id do nome internado: consulta O(1), sem strcmp.
  * ------------------------------------------------------- */
-typedef struct JsTemp {
-    const char    *name;
-    struct JsTemp *next;
-} JsTemp;
-
-static JsTemp *g_temps = NULL;
+static unsigned char *g_declared = NULL;
+static size_t         g_declared_cap = 0;
 
 static int js_declared(const char *name) {
-    for (JsTemp *t = g_temps; t; t = t->next) {
-        if (strcmp(t->name, name) == 0) return 1;
-    }
-    return 0;
+    uint32_t id = intern_id(name);
+    return id < g_declared_cap && g_declared[id];
 }
 
 static void js_mark_declared(const char *name) {
-    if (js_declared(name)) return;
-
-    JsTemp *nt = (JsTemp*)malloc(sizeof(JsTemp));
-    if (!nt) {
-        fprintf(stderr, "jsgen: out of memory\n");
-        exit(1);
+    uint32_t id = intern_id(name);
+
+    if (id >= g_declared_cap) {
+        size_t new_cap = intern_count() > id ? intern_count() : (size_t)id + 1;
+        unsigned char *nd = (unsigned char*)realloc(g_declared, new_cap);
+        if (!nd) {
+            fprintf(stderr, "jsgen: out of memory\n");
+            exit(1);
+        }
+        memset(nd + g_declared_cap, 0, new_cap - g_declared_cap);
+        g_declared = nd;
+        g_declared_cap = new_cap;
     }
 
-    nt->name = strdup(name);
-    if (!nt->name) {
-        fprintf(stderr, "jsgen: out of memory (strdup)\n");
-        exit(1);
+    g_declared[id] = 1;
+}
+
+/* limpa o conjunto de variáveis declaradas */
+static void js_reset_temps(void) {
+    if (g_declared) memset(g_declared, 0, g_declared_cap);
+}
+
+/* -------------------------------------------------------
+ *  Literais de string
+ *  Cada literal do pool usado pelo IR vira uma constante no topo do
+ *  módulo ($sN: '$' não existe nos identificadores do fonte, então
+ *  não colide com variáveis nem temporários).
+ * ------------------------------------------------------- */
+
+/* Imprime o texto (já sem escapes do fonte) como literal JS entre aspas */
+static void js_print_string_literal(const char *s, size_t len, FILE *out) {
+    fputc('"', out);
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        switch (c) {
+            case '"':  fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            case '\t': fputs("\\t", out); break;
+            case '\b': fputs("\\b", out); break;
+            case '\f': fputs("\\f", out); break;
+            case '\v': fputs("\\v", out); break;
+            default:
+                if (c < 0x20 || c == 0x7f) {
+                    fprintf(out, "\\x%02x", c);
+                } else if (c == 0xe2 && i + 2 < len && (unsigned char)s[i + 1] == 0x80 &&
+                           ((unsigned char)s[i + 2] == 0xa8 || (unsigned char)s[i + 2] == 0xa9)) {
+                    /* U+2028/U+2029 (separadores de linha/parágrafo em UTF-8) */
+                    fprintf(out, "\\u202%c", (unsigned char)s[i + 2] == 0xa8 ? '8' : '9');
+                    i += 2;
+                } else {
+                    fputc(c, out);
+                }
+                break;
+        }
     }
+    fputc('"', out);
+}
 
-    nt->next = g_temps;
-    g_temps  = nt;
+static void js_mark_string(IrOperand op, unsigned char *used) {
+    if (op.kind == IR_OPER_STRING) used[op.v.str] = 1;
 }
 
-/* limpa toda a lista de variáveis declaradas */
-static void js_reset_temps(void) {
-    JsTemp *t = g_temps;
-    while (t) {
-        JsTemp *next = t->next;
-        free((char*)t->name);
-        free(t);
-        t = next;
+/* Declara os literais usados pelo programa, na ordem do pool */
+static void js_emit_string_pool(const IrProgram *prog, FILE *out) {
+    size_t count = str_pool_count(prog->strings);
+    if (count == 0) return;
+
+    unsigned char *used = (unsigned char*)calloc(count, 1);
+    if (!used) {
+        fprintf(stderr, "jsgen: out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < prog->func_count; ++i) {
+        const IrFunc *f = prog->funcs[i];
+        for (size_t k = 0; k < f->code_len; ++k) {
+            js_mark_string(f->code[k].a, used);
+            js_mark_string(f->code[k].b, used);
+        }
+    }
+
+    int any = 0;
+    for (size_t id = 0; id < count; ++id) {
+        if (!used[id]) continue;
+        fprintf(out, "const $s%zu = ", id);
+        js_print_string_literal(str_pool_get(prog->strings, (uint32_t)id),
+                                str_pool_len(prog->strings, (uint32_t)id), out);
+        fprintf(out, ";\n");
+        any = 1;
     }
-    g_temps = NULL;
+    if (any) fprintf(out, "\n");
+    free(used);
 }
 
 /* Helper para imprimir qualquer tipo de operando (incluindo STRING) */
@@ -111,9 +177,9 @@ static void js_print_operand(const IrFunc *f, IrOperand op, FILE *out) {
         case IR_OPER_BOOL:
             fprintf(out, "%s", op.v.b ? "true" : "false");
             break;
-        case IR_OPER_STRING: /* <--- IMPLEMENTAÇÃO DO SUPORTE A STRING */
-            /* Imprime string entre aspas duplas */
-            fprintf(out, "\"%s\"", op.v.str);
+        case IR_OPER_STRING:
+            /* constante declarada no topo (js_emit_string_pool) */
+            fprintf(out, "$s%u", (unsigned)op.v.str);
             break;
         case IR_OPER_LABEL:
             fprintf(out, "/* L%d */", op.v.label);
@@ -189,14 +255,9 @@ static void codegen_js_instr(const IrFunc *f, const IrInstr *ins, FILE *out, int
        * ============================ */
       case IR_CALL: {
             const char *dst_name = NULL;
-            char buf[32];
 
             if (ins->dst >= 0) {
-                dst_name = js_name_for_temp(f, ins->dst);
-                if (!dst_name) {
-                    snprintf(buf, sizeof(buf), "t%d", ins->dst);
-                    dst_name = buf;
-                }
+                dst_name = js_dst_name(f, ins->dst);
             }
 
             if (seq_mode) {
@@ -236,16 +297,7 @@ static void codegen_js_instr(const IrFunc *f, const IrInstr *ins, FILE *out, int
        * MOV
        * ============================ */
       case IR_MOV: {
-        const char *var_name = js_name_for_temp(f, ins->dst);
-        char buf[32];
-        const char *vname = NULL;
-
-        if (var_name) {
-            vname = var_name;
-        } else {
-            snprintf(buf, sizeof(buf), "t%d", ins->dst);
-            vname = buf;
-        }
+        const char *vname = js_dst_name(f, ins->dst);
 
         if (seq_mode) {
             if (!js_declared(vname)) {
@@ -268,17 +320,29 @@ static void codegen_js_instr(const IrFunc *f, const IrInstr *ins, FILE *out, int
        * CAST
        * ============================ */
       case IR_CAST: {
-        const char *vname = js_name_for_temp(f, ins->dst);
-        if (!vname) { fprintf(out, "        t%d = ", ins->dst); }
-        else        { fprintf(out, "        %s = ", vname); }
+        const char *vname = js_dst_name(f, ins->dst);
 
-        const char *cast_func = "";
+        if (seq_mode) {
+            if (!js_declared(vname)) {
+                fprintf(out, "  let %s = ", vname);
+                js_mark_declared(vname);
+            } else {
+                fprintf(out, "  %s = ", vname);
+            }
+        } else {
+            fprintf(out, "        %s = ", vname);
+        }
 
-        /* Mapeamento baseado no ast_base.h que você enviou */
+        /* Números de JS são double: int -> float não muda o valor e
+         * float -> int trunca (tipo do operando: IrFunc.temp_types) */
+        TypeTag from = ins->a.kind == IR_OPER_TEMP ? ir_temp_type(f, ins->a.v.temp) : TY_INVALID;
+        const char *cast_func = "";
         switch (ins->cast_to) {
             case TY_INT:
+                cast_func = (from == TY_FLOAT) ? "Math.trunc" : (from == TY_INT ? "" : "Number");
+                break;
             case TY_FLOAT:
-                cast_func = "Number";
+                cast_func = (from == TY_INT || from == TY_FLOAT) ? "" : "Number";
                 break;
             case TY_BOOL:
                 cast_func = "Boolean";
@@ -313,13 +377,7 @@ static void codegen_js_instr(const IrFunc *f, const IrInstr *ins, FILE *out, int
       case IR_GE:
       case IR_EQ:
       case IR_NE: {
-          const char *vname = js_name_for_temp(f, ins->dst);
-          char buf[32];
-
-          if (!vname) {
-              snprintf(buf, sizeof(buf), "t%d", ins->dst);
-              vname = buf;
-          }
+          const char *vname = js_dst_name(f, ins->dst);
 
           const char *op_str = "?";
           switch (ins->op) {
@@ -524,6 +582,8 @@ void codegen_js_program(const IrProgram *prog, FILE *out) {
 
     fprintf(out, "// Código gerado automaticamente a partir do IR\n\n");
 
+    js_emit_string_pool(prog, out);
+
     for (size_t i = 0; i < prog->func_count; ++i) {
         codegen_js_func(prog->funcs[i], out);
     }
@@ -541,5 +601,7 @@ void codegen_js_program(const IrProgram *prog, FILE *out) {
         fprintf(out, "_entry();\n");
     }
 
-    js_reset_temps();
+    free(g_declared);
+    g_declared = NULL;
+    g_declared_cap = 0;
 }
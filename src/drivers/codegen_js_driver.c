@@ -9,8 +9,6 @@
 #include "syntax_analyzer.h"
 #include "semantic_analyzer.h"
 
-extern int g_parse_errors;
-
 /* Detecta leitura de stdin */
 static bool read_from_stdin(const char *arg) {
     if (!arg) return true;
@@ -28,31 +26,38 @@ int main(int argc, char **argv) {
        1) Sintaxe
        ----------------------------- */
     SyntaxResult sr = syntax_parse_path(path);
-    if (!sr.parse_ok || sr.ast == NULL || g_parse_errors > 0) {
+    if (!sr.parse_ok || (sr.ast == NULL && sr.compact == NULL) || sr.parse_errors > 0) {
         fprintf(stderr, "JS: abortado por erro(s) sintáticos.\n");
         return 1;
     }
 
     /* -----------------------------
-       2) Semântica
+       2) Semântica e 3) IR (MESMO que irgen): duas passadas ou,
+          com ASTEROIDS_FUSED=1, uma só
        ----------------------------- */
     SymbolTable *global = st_create();
-    int ok = semantics_ok(sr.ast, global);
-    if (!ok) {
+    IrProgram *prog = NULL;
+    int errors = 0;
+    if (irb_fused_enabled()) {
+        prog = sr.compact ? irb_check_and_build_compact(sr.compact, sr.strings, global, &errors)
+                          : irb_check_and_build(sr.ast, sr.strings, global, &errors);
+    } else {
+        errors = sr.compact ? check_semantics_compact(sr.compact, global)
+                            : check_semantics(sr.ast, global);
+        if (errors == 0)
+            prog = sr.compact ? irb_build_program_compact(sr.compact, sr.strings)
+                              : irb_build_program(sr.ast, sr.strings);
+    }
+    if (errors > 0) {
         fprintf(stderr, "JS: abortado por erro(s) semânticos.\n");
         st_destroy(global);
-        ast_free(sr.ast);
+        syntax_result_free(&sr);
         return 1;
     }
-
-    /* -----------------------------
-       3) IR (usando irb_build_program - MESMO que irgen)
-       ----------------------------- */
-    IrProgram *prog = irb_build_program(sr.ast);
     if (!prog) {
         fprintf(stderr, "JS: falha ao construir programa IR.\n");
         st_destroy(global);
-        ast_free(sr.ast);
+        syntax_result_free(&sr);
         return 1;
     }
 
@@ -73,7 +78,7 @@ int main(int argc, char **argv) {
        ----------------------------- */
     ir_program_free(prog);
     st_destroy(global);
-    ast_free(sr.ast);
+    syntax_result_free(&sr);
 
     return 0;
 }
@@ -5,47 +5,65 @@
 #include "ast.h"
 #include "ir.h"
 #include "ir_builder.h"
+#include "ir_effects.h"
 #include "ir_printer.h"
 #include "syntax_analyzer.h"
 #include "semantic_analyzer.h"
 
-extern int g_parse_errors;
-extern Node *g_program_ast;
-
 static bool read_from_stdin(const char *arg) {
     if (!arg) return true;
     return (strcmp(arg, "-") == 0 || strcmp(arg, "--") == 0);
 }
 
+/* --effects: o resumo de efeitos de cada função (ir_effects.h) no lugar do IR */
+static void print_effects(const IrProgram *prog) {
+    for (size_t i = 0; i < prog->func_count; ++i)
+        printf("%s: %s\n", prog->funcs[i]->name, ir_effect_name(ir_func_effect(prog->funcs[i])));
+}
+
 int main(int argc, char **argv) {
     const char *path = NULL;
-    if (argc > 1 && !read_from_stdin(argv[1])) {
-        path = argv[1];
+    bool effects = false;
+    int arg = 1;
+    if (argc > arg && strcmp(argv[arg], "--effects") == 0) {
+        effects = true;
+        arg++;
+    }
+    if (argc > arg && !read_from_stdin(argv[arg])) {
+        path = argv[arg];
     }
 
     // 1) Sintaxe
     SyntaxResult sr = syntax_parse_path(path);
-    if (!sr.parse_ok || sr.ast == NULL || g_parse_errors > 0) {
+    if (!sr.parse_ok || (sr.ast == NULL && sr.compact == NULL) || sr.parse_errors > 0) {
         fprintf(stderr, "IR: abortado por erro(s) sintáticos.\n");
         return 1;
     }
 
-    // 2) Semântica
+    // 2) Semântica e 3) IR: duas passadas ou, com ASTEROIDS_FUSED=1, uma só
     SymbolTable *global = st_create();
-    int ok = semantics_ok(sr.ast, global);
-    if (!ok) {
+    IrProgram *prog = NULL;
+    int errors = 0;
+    if (irb_fused_enabled()) {
+        prog = sr.compact ? irb_check_and_build_compact(sr.compact, sr.strings, global, &errors)
+                          : irb_check_and_build(sr.ast, sr.strings, global, &errors);
+    } else {
+        errors = sr.compact ? check_semantics_compact(sr.compact, global)
+                            : check_semantics(sr.ast, global);
+        if (errors == 0)
+            prog = sr.compact ? irb_build_program_compact(sr.compact, sr.strings)
+                              : irb_build_program(sr.ast, sr.strings);
+    }
+    if (errors > 0) {
         fprintf(stderr, "IR: abortado por erro(s) semânticos.\n");
         st_destroy(global);
-        ast_free(sr.ast);
+        syntax_result_free(&sr);
         return 1;
     }
-
-    // 3) IR (agora via irb_build_program)
-    IrProgram *prog = irb_build_program(sr.ast);
     if (!prog) {
         fprintf(stderr, "IR: falha ao construir programa IR.\n");
         st_destroy(global);
-        ast_free(sr.ast);
+        syntax_result_free(&sr);
         return 1;
     }
 
@@ -56,12 +74,13 @@ int main(int argc, char **argv) {
     //             prog->funcs[i]->name ? prog->funcs[i]->name : "<unnamed>");
     // }
 
-    // 4) Imprime IR
-    ir_print_program(prog);
+    // 4) Imprime IR (ou os efeitos)
+    if (effects) print_effects(prog);
+    else ir_print_program(prog);
 
     // 5) Libera
     ir_program_free(prog);
     st_destroy(global);
-    ast_free(sr.ast);
+    syntax_result_free(&sr);
     return 0;
 }
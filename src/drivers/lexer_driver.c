@@ -1,14 +1,15 @@
 /* lexer_driver.c */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "../parser.tab.h" /* precisa ter sido gerado por: bison -d parser.y */
-
-extern int yylex(void);
-extern char *yytext;
-extern int yylineno;
-extern int yycolumn;
-extern int yyleng;
+#include "parse_context.h"
+#include "lexer.h"
+#include "lexer_fast.h"
+#include "token_stream.h"
 
 const char *token_name(int t) {
     switch(t) {
@@ -52,22 +53,160 @@ const char *token_name(int t) {
     }
 }
 
-int main(void) {
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Tokeniza o fonte inteiro com `kind` até somar ~0,5 s e mostra a vazão */
+static void bench_lexer(LexerKind kind, SourceBuffer *src) {
+    size_t tokens = 0, rounds = 0;
+    double start = now_seconds(), elapsed = 0.0;
+
+    do {
+        ParseContext ctx = {0};
+        ctx.lexer = kind;
+        ctx.src = *src;
+        if (!lexer_open(&ctx)) return;
+
+        YYSTYPE lval;
+        while (lexer_next(&lval, &ctx) != 0) tokens++;
+        lexer_close(&ctx);
+
+        rounds++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < 0.5);
+
+    double mb = (double)src->len * (double)rounds / (1024.0 * 1024.0);
+    printf("%-5s %-7s %10.1f MB/s %12.0f tokens/s\n",
+           lexer_kind_name(kind),
+           kind == LEXER_FAST ? fast_lexer_simd_name() : "dfa",
+           mb / elapsed, (double)tokens / elapsed);
+}
+
+/* Mesma medida, mas lendo de um fluxo de tokens já pronto (sem tokenizar) */
+static void bench_replay(SourceBuffer *src) {
+    TokenStream *ts = token_stream_build(src, lexer_default_kind());
+    if (!ts) return;
+
+    size_t tokens = 0, rounds = 0;
+    double start = now_seconds(), elapsed = 0.0;
+    do {
+        ParseContext ctx = {0};
+        ctx.lexer = LEXER_REPLAY;
+        ctx.tokens = ts;
+        ctx.quiet = true;
+        if (!lexer_open(&ctx)) break;
+
+        YYSTYPE lval;
+        while (lexer_next(&lval, &ctx) != 0) tokens++;
+        lexer_close(&ctx);
+
+        rounds++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < 0.5);
+
+    double mb = (double)src->len * (double)rounds / (1024.0 * 1024.0);
+    printf("%-5s %-7s %10.1f MB/s %12.0f tokens/s\n",
+           "replay", "", mb / elapsed, (double)tokens / elapsed);
+    token_stream_free(ts);
+}
+
+/* Tokenização paralela em pedaços (token_stream_build_parallel) */
+static void bench_parallel(SourceBuffer *src, int threads) {
+    size_t tokens = 0, rounds = 0;
+    double start = now_seconds(), elapsed = 0.0;
+    do {
+        TokenStream *ts = token_stream_build_parallel(src, LEXER_FAST, threads, 64 * 1024);
+        if (!ts) return;
+        tokens += ts->count - 1;
+        token_stream_free(ts);
+        rounds++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < 0.5);
+
+    double mb = (double)src->len * (double)rounds / (1024.0 * 1024.0);
+    printf("fast  x%-6d %10.1f MB/s %12.0f tokens/s\n",
+           threads, mb / elapsed, (double)tokens / elapsed);
+}
+
+static int run_bench(const char *path) {
+    SourceBuffer src;
+    if (!source_open(&src, path)) return 1;
+
+#ifndef LEXER_FAST_ONLY
+    bench_lexer(LEXER_FLEX, &src);
+#endif
+    bench_lexer(LEXER_FAST, &src);
+    bench_replay(&src);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int t = 1; t <= 4 || (t <= cpus && t <= 16); t *= 2) bench_parallel(&src, t);
+
+    source_close(&src);
+    return 0;
+}
+
+/* Grava o fluxo de tokens binário (token_stream.h) em `out` */
+static int run_dump(const char *path, const char *out, int threads) {
+    SourceBuffer src;
+    if (!source_open(&src, path)) return 1;
+
+    TokenStream *ts = token_stream_build_parallel(&src, lexer_default_kind(), threads,
+                                                  token_stream_env_min_chunk());
+    int ok = ts && token_stream_save(ts, out);
+    if (ts) {
+        printf("%zu tokens, %zu nomes -> %s\n", ts->count - 1, ts->name_count, out);
+        token_stream_free(ts);
+    }
+    source_close(&src);
+    return ok ? 0 : 1;
+}
+
+/* Uso: scanner [--bench | --dump saida.tok [--threads N]] [arquivo]
+ * (sem arquivo: lê de stdin) */
+int main(int argc, char **argv) {
+    const char *path = NULL, *dump = NULL;
+    int bench = 0, threads = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) bench = 1;
+        else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) dump = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else path = argv[i];
+    }
+    if (bench) return run_bench(path);
+    if (dump) return run_dump(path, dump, threads);
+
+    ParseContext ctx = {0};
+    ctx.lexer = lexer_default_kind();
+    if (!source_open(&ctx.src, path)) return 1;
+    if (!lexer_open(&ctx)) { source_close(&ctx.src); return 1; }
+
+    YYSTYPE lval;
     int tok;
-    while ((tok = yylex()) != 0) {
-        int startcol = yycolumn - yyleng + 1;
+    while ((tok = lexer_next(&lval, &ctx)) != 0) {
+        const char *text = lexer_text(&ctx);
+        int leng = (int)lexer_leng(&ctx);
+        int line = lexer_line(&ctx);
+        int col = ctx.column;
+
+        int startcol = col - leng + 1;
         if (startcol < 1) startcol = 1;
-        int endcol = yycolumn - 1;
+        int endcol = col - 1;
 
         if (tok == ERROR) {
 
-            printf("Erro lexico (linha %d, coluna %d): '%s'\n",
-                   yylineno, (yycolumn > 0 ? yycolumn : 1), yytext ? yytext : "");
+            printf("Erro lexico (linha %d, coluna %d): '%.*s'\n",
+                   line, (col > 0 ? col : 1), leng, text ? text : "");
             continue;
         }
 
-        printf("Token: %-12s | lexeme=\"%s\" | line: %d col: %d-%d\n",
-               token_name(tok), yytext ? yytext : "", yylineno, startcol, endcol);
+        printf("Token: %-12s | lexeme=\"%.*s\" | line: %d col: %d-%d\n",
+               token_name(tok), leng, text ? text : "", line, startcol, endcol);
     }
+
+    lexer_close(&ctx);
+    source_close(&ctx.src);
     return 0;
 }
@@ -1,48 +1,110 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "ast.h"
+#include "intern.h"
 #include "semantic_analyzer.h"
 #include "symbol_table.h"
-
-extern int yyparse(void);
-extern FILE *yyin;
-extern int yylex_destroy(void);
-extern Node *g_program_ast;
-extern int g_parse_errors;
+#include "syntax_analyzer.h"
 
 static void usage(const char *prog) {
-    fprintf(stderr, "Uso: %s [arquivo | --]\n", prog);
+    fprintf(stderr, "Uso: %s [--bench] [arquivo | --]\n", prog);
+    fprintf(stderr, "   --bench: mede inserção e busca na tabela de símbolos com escopos\n");
+    fprintf(stderr, "            de 16 a 2^21 nomes (sem ler arquivo).\n");
+}
+
+/* -------------------------------------------------------------------------- */
+/* Benchmark: tabela de símbolos com escopos de tamanhos crescentes           */
+/* -------------------------------------------------------------------------- */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+#define BENCH_MAX_SYMBOLS ((size_t)1 << 21)
+#define BENCH_LOOKUPS     ((size_t)1 << 22)
+
+/* `n` nomes internados distintos com o prefixo dado */
+static const char **bench_names(const char *prefix, size_t n) {
+    const char **names = (const char**)xmalloc(n * sizeof(char*));
+    char buf[32];
+    for (size_t i = 0; i < n; i++) {
+        int len = snprintf(buf, sizeof buf, "%s%zu", prefix, i);
+        names[i] = intern(buf, (size_t)len);
+    }
+    return names;
+}
+
+static void bench_symbols(void) {
+    const char **present = bench_names("s", BENCH_MAX_SYMBOLS);
+    const char **absent  = bench_names("m", BENCH_MAX_SYMBOLS);
+
+    /* ordem de busca pseudo-aleatória (LCG), igual para todos os tamanhos */
+    uint32_t *order = (uint32_t*)xmalloc(BENCH_LOOKUPS * sizeof(uint32_t));
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        order[i] = (uint32_t)(x >> 33);
+    }
+
+    printf("%10s %14s %14s %14s\n", "símbolos", "ns/inserção", "ns/busca", "ns/ausente");
+    for (size_t n = 16; n <= BENCH_MAX_SYMBOLS; n *= 8) {
+        SymbolTable *t = st_create();
+        double start = now_seconds();
+        for (size_t i = 0; i < n; i++) st_insert(t, present[i], TY_INT, NULL);
+        double insert = now_seconds() - start;
+
+        bool found;
+        size_t hits = 0;
+        start = now_seconds();
+        for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+            (void)st_lookup_type(t, present[order[i] & (n - 1)], &found);
+            hits += found;
+        }
+        double hit = now_seconds() - start;
+
+        start = now_seconds();
+        for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+            (void)st_lookup_type(t, absent[order[i] & (n - 1)], &found);
+            hits += found;
+        }
+        double miss = now_seconds() - start;
+
+        if (hits != BENCH_LOOKUPS) fprintf(stderr, "bench: %zu acertos, esperado %zu\n", hits, BENCH_LOOKUPS);
+        printf("%10zu %14.1f %14.1f %14.1f\n", n, insert * 1e9 / (double)n,
+               hit * 1e9 / (double)BENCH_LOOKUPS, miss * 1e9 / (double)BENCH_LOOKUPS);
+        st_destroy(t);
+    }
+
+    free(order);
+    free(absent);
+    free(present);
 }
 
 int main(int argc, char **argv) {
     const char *path = NULL;
     if (argc > 1 && strcmp(argv[1], "-h") == 0) { usage(argv[0]); return 2; }
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) { bench_symbols(); return 0; }
     if (argc > 1 && strcmp(argv[1], "--") != 0) {
         path = argv[1];
-        yyin = fopen(path, "r");
-        if (!yyin) { perror("Erro ao abrir arquivo"); return 2; }
-    } else {
-        yyin = stdin;
     }
 
-    g_program_ast = NULL;
-    g_parse_errors = 0;
-
-    int rc = yyparse();
-    if (yyin && yyin != stdin) fclose(yyin);
+    SyntaxResult sr = syntax_parse_path(path);
 
-    if (rc != 0 || g_parse_errors > 0) {
-        if (g_program_ast) { ast_free(g_program_ast); g_program_ast = NULL; }
-        yylex_destroy();
-        return 1; /* erro de sintaxe */
+    if (!sr.parse_ok) {
+        int io_error = (sr.ast == NULL && sr.parse_errors == 0);
+        syntax_result_free(&sr);
+        return io_error ? 2 : 1; /* erro de leitura / sintaxe */
     }
 
     SymbolTable *global = st_create();
-    int sem_errors = check_semantics(g_program_ast, global);
+    int sem_errors = sr.compact ? check_semantics_compact(sr.compact, global)
+                                : check_semantics(sr.ast, global);
     st_destroy(global);
 
-    if (g_program_ast) { ast_free(g_program_ast); g_program_ast = NULL; }
-    yylex_destroy();
+    syntax_result_free(&sr);
 
     return (sem_errors == 0) ? 0 : 1;
 }
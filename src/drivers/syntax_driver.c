@@ -10,26 +10,142 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "ast.h"
+#include "syntax_analyzer.h"
+#include "lexer.h"
+#include "token_stream.h"
+#include "incremental.h"
 // #include "semantic_analyzer.h"   // (Passo 2) por enquanto, não precisamos
 
 /* -------------------------------------------------------------------------- */
-/* Símbolos exportados pelo parser e scanner (gerados pelo Bison/Flex)        */
+/* Função utilitária: exibe uso do programa                                   */
+/* -------------------------------------------------------------------------- */
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [--tokens arquivo.tok | --bench | --edit pos:removidos:texto ...] [arquivo | --]\n", prog);
+    fprintf(stderr, "   Se não for informado um arquivo, lê da entrada padrão (stdin).\n");
+    fprintf(stderr, "   --tokens: consome os tokens gravados por `scanner --dump`; com um\n");
+    fprintf(stderr, "             arquivo-fonte, só tokeniza de novo se o fonte mudou.\n");
+    fprintf(stderr, "   --bench:  mede a vazão do parser Bison e do escrito à mão e o\n");
+    fprintf(stderr, "             custo de uma edição com a reanálise incremental.\n");
+    fprintf(stderr, "   --edit:   troca `removidos` bytes a partir de `pos` por `texto`\n");
+    fprintf(stderr, "             com a reanálise incremental (pode repetir) e imprime\n");
+    fprintf(stderr, "             a AST do texto final.\n");
+    fprintf(stderr, "   ASTEROIDS_PARSER=bison|rd escolhe o parser (padrão: rd).\n");
+}
+
 /* -------------------------------------------------------------------------- */
-extern int yyparse(void);
-extern FILE *yyin;
-extern int yylex_destroy(void);
+/* Benchmark: só o parser, consumindo tokens já prontos (sem tokenizar)      */
+/* -------------------------------------------------------------------------- */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void bench_parser(ParserKind kind, TokenStream *ts) {
+    size_t rounds = 0;
+    double start = now_seconds(), elapsed = 0.0;
+    do {
+        SyntaxResult sr = syntax_parse_stream(ts, kind);
+        syntax_result_free(&sr);
+        rounds++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < 0.5);
+
+    double mb = (double)ts->src_len * (double)rounds / (1024.0 * 1024.0);
+    printf("%-5s %10.1f MB/s %12.0f tokens/s %9.2f ms/parse\n",
+           syntax_parser_name(kind), mb / elapsed,
+           (double)(ts->count - 1) * (double)rounds / elapsed,
+           elapsed * 1000.0 / (double)rounds);
+}
 
-/* Se estes não estiverem em ast.h, deixe os extern abaixo. */
-extern Node *g_program_ast;
-extern int g_parse_errors;
+/* Simula digitação: insere e apaga um espaço no fim de linhas espalhadas
+ * pelo fonte, comparando com a análise do texto inteiro (lexer + parser) */
+static void bench_incremental(const SourceBuffer *src) {
+    double start = now_seconds();
+    IncrementalParse *ip = incr_parse_new(src->data, src->len);
+    double full = now_seconds() - start;
+
+    size_t edits = 0, bytes = 0;
+    size_t step = src->len / 200 + 1;
+    start = now_seconds();
+    for (size_t pos = 0; pos < src->len; pos += step) {
+        const char *nl = memchr(src->data + pos, '\n', src->len - pos);
+        if (!nl) break;
+        size_t off = (size_t)(nl - src->data);
+
+        incr_parse_edit(ip, off, 0, " ", 1);
+        bytes += incr_parse_stats(ip).reparsed_bytes;
+        incr_parse_edit(ip, off, 1, "", 0);
+        bytes += incr_parse_stats(ip).reparsed_bytes;
+        edits += 2;
+    }
+    double elapsed = now_seconds() - start;
+    incr_parse_free(ip);
+
+    if (edits == 0) return;
+    printf("incr  %10.1f us/edit %9zu bytes/edit %9.2f ms/parse completo\n",
+           elapsed * 1e6 / (double)edits, bytes / edits, full * 1000.0);
+}
+
+static int run_bench(const char *path) {
+    SourceBuffer src;
+    if (!source_open(&src, path)) return 2;
+
+    TokenStream *ts = token_stream_build(&src, lexer_default_kind());
+    if (!ts) { source_close(&src); return 2; }
+
+    bench_parser(PARSER_BISON, ts);
+    bench_parser(PARSER_RD, ts);
+    bench_incremental(&src);
+
+    token_stream_free(ts);
+    source_close(&src);
+    return 0;
+}
 
 /* -------------------------------------------------------------------------- */
-/* Função utilitária: exibe uso do programa                                   */
+/* Edições: aplica cada "pos:removidos:texto" com a reanálise incremental     */
 /* -------------------------------------------------------------------------- */
-static void usage(const char *prog) {
-    fprintf(stderr, "Uso: %s [arquivo | --]\n", prog);
-    fprintf(stderr, "   Se não for informado um arquivo, lê da entrada padrão (stdin).\n");
+static bool parse_edit(const char *spec, size_t *off, size_t *removed, const char **text) {
+    char *end;
+    *off = strtoul(spec, &end, 10);
+    if (end == spec || *end != ':') return false;
+    const char *p = end + 1;
+    *removed = strtoul(p, &end, 10);
+    if (end == p || *end != ':') return false;
+    *text = end + 1;
+    return true;
+}
+
+static int run_edits(const char *path, char **edits, int count) {
+    SourceBuffer src;
+    if (!source_open(&src, path)) return 2;
+    IncrementalParse *ip = incr_parse_new(src.data, src.len);
+    source_close(&src);
+
+    for (int i = 0; i < count; i++) {
+        size_t off, removed;
+        const char *text;
+        if (!parse_edit(edits[i], &off, &removed, &text) ||
+            !incr_parse_edit(ip, off, removed, text, strlen(text))) {
+            fprintf(stderr, "Edição inválida: %s\n", edits[i]);
+            incr_parse_free(ip);
+            return 2;
+        }
+    }
+
+    /* a reanálise é silenciosa: só o total de erros sai */
+    SyntaxResult sr = incr_parse_result(ip);
+    if (sr.parse_ok) {
+        printf("=== AST (Formatada) ===\n");
+        ast_print_pretty(sr.ast);
+    } else {
+        fprintf(stderr, "%d erro(s) sintático(s)\n", sr.parse_errors);
+    }
+    incr_parse_free(ip);
+    return sr.parse_ok ? 0 : 1;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -44,50 +160,56 @@ int main(int argc, char **argv) {
         return 2;
     }
 
-    if (argc > 1 && strcmp(argv[1], "--") != 0) {
-        input = argv[1];
-        yyin = fopen(input, "r");
-        if (!yyin) {
-            perror("Erro ao abrir arquivo");
-            return 2;
-        }
-    } else {
-        yyin = stdin; /* Se não houver argumento, lê da entrada padrão */
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return run_bench(argc > 2 ? argv[2] : NULL);
     }
 
-    /* Etapa 2: inicialização de globais */
-    g_program_ast = NULL;
-    g_parse_errors = 0;
-    /* REMOVIDO: push_scope(); */
+    /* --edit pos:removidos:texto, uma ou mais vezes, antes do arquivo */
+    int argi = 1, edit_count = 0;
+    char **edits = (char**)xmalloc((size_t)argc * sizeof(char*));
+    while (argi + 1 < argc && strcmp(argv[argi], "--edit") == 0) {
+        edits[edit_count++] = argv[argi + 1];
+        argi += 2;
+    }
+    if (edit_count) {
+        int rc = run_edits(argc > argi && strcmp(argv[argi], "--") != 0 ? argv[argi] : NULL,
+                           edits, edit_count);
+        free(edits);
+        return rc;
+    }
+    free(edits);
 
-    /* Etapa 3: parsing */
-    int rc = yyparse();
+    const char *tokens = NULL;
+    if (argc > 2 && strcmp(argv[1], "--tokens") == 0) {
+        tokens = argv[2];
+        argi = 3;
+    }
 
-    if (yyin && yyin != stdin)
-        fclose(yyin);
+    if (argc > argi && strcmp(argv[argi], "--") != 0) {
+        input = argv[argi]; /* Se não houver argumento, lê da entrada padrão */
+    }
 
-    /* REMOVIDO: while (scope_stack) { pop_scope(); } */
+    /* Etapas 2 e 3: parsing (fonte mapeado em memória ou tokens gravados) */
+    SyntaxResult sr = tokens ? syntax_parse_tokens(tokens, input)
+                             : syntax_parse_path(input);
 
-    /* Etapa 4: erros sintáticos */
-    if (rc != 0 || g_parse_errors > 0) {
-        if (g_program_ast) { ast_free(g_program_ast); g_program_ast = NULL; }
-        yylex_destroy();
-        return 1;
+    /* Etapa 4: erros de leitura / sintáticos */
+    if (!sr.parse_ok) {
+        int io_error = (sr.ast == NULL && sr.parse_errors == 0);
+        syntax_result_free(&sr);
+        return io_error ? 2 : 1;
     }
 
-    /* Etapa 5: saída/limpeza */
-    if (g_program_ast) {
+    /* Etapa 5: saída/limpeza (a AST compacta é impressa como Node) */
+    if (syntax_result_ast(&sr)) {
         /* Para testes sintáticos, normalmente não imprimimos AST.
            Deixe comentado por enquanto. */
         // printf("=== AST (Compacta) ===\n");
-        // ast_print(g_program_ast);
+        // ast_print(sr.ast);
         printf("=== AST (Formatada) ===\n");
-        ast_print_pretty(g_program_ast);
-
-        ast_free(g_program_ast);
-        g_program_ast = NULL;
+        ast_print_pretty(sr.ast);
     }
+    syntax_result_free(&sr);
 
-    yylex_destroy();
     return 0;
 }
@@ -0,0 +1,311 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "incremental.h"
+#include "parse_context.h"
+#include "parser_rd.h"
+#include "lexer.h"
+#include "ast.h"
+
+/* Quantos bytes o lexer pode olhar além do fim de um token antes de
+ * decidir onde ele termina (ex.: "1.5e+" diante de um não-dígito) */
+#define LEX_LOOKAHEAD 3
+
+/* Instrução de nível superior e o trecho do texto do qual ela depende */
+typedef struct {
+    size_t start;      /* primeiro token */
+    size_t end;        /* fim do último token consumido */
+    size_t scan_end;   /* último byte que o lexer pode ter lido */
+    Node  *node;       /* NULL para ';' isolado ou instrução inválida */
+    size_t stmt;       /* posição do nó (ou do próximo) no bloco raiz */
+    int    errors;
+} Region;
+
+struct IncrementalParse {
+    char     *text;        /* text[len] e text[len + 1] valem '\0' (Flex) */
+    size_t    len, cap;
+
+    Region   *regions;
+    size_t    count, region_cap;
+
+    Node     *root;        /* ND_BLOCK com os nós não nulos das regiões */
+    StrPool  *strings;     /* literais de todas as versões (só cresce) */
+    size_t    lex_first;   /* primeira região com scan_end == len (ou SIZE_MAX) */
+    int       errors;      /* soma dos erros das regiões */
+    bool      fatal;       /* comentário não fechado no fim do texto */
+    LexerKind lexer;
+    IncrStats stats;
+};
+
+/* Regiões novas de uma análise parcial */
+typedef struct {
+    Region *items;
+    size_t  count, cap;
+} RegionVec;
+
+static void region_push(RegionVec *v, Region r) {
+    if (v->count == v->cap) {
+        v->cap = v->cap ? v->cap * 2 : 16;
+        v->items = (Region*)realloc(v->items, v->cap * sizeof(Region));
+        if (!v->items) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+    }
+    v->items[v->count++] = r;
+}
+
+/* =========================================================
+ * Análise a partir de uma fronteira de instrução
+ *   A análise parte do fim da última região intacta; depois de
+ *   passar do trecho editado, cada instrução nova que termina onde
+ *   terminava uma região antiga encerra a análise: dali em diante o
+ *   texto é o mesmo e o parser está no mesmo estado (nível superior).
+ * ========================================================= */
+typedef struct {
+    size_t     base;          /* posição (no texto novo) do início da análise */
+    size_t     text_len;
+    RegionVec  out;
+
+    const Region *old;        /* regiões antigas depois da edição */
+    size_t     old_count;
+    size_t     j;
+    long long  delta;         /* tamanho novo - tamanho antigo */
+    size_t     edit_end;      /* fim do texto inserido (no texto novo) */
+
+    bool       resynced;
+    size_t     resync_index;  /* última região antiga substituída */
+} Reparse;
+
+static bool on_stmt(const RdStmt *st, void *user) {
+    Reparse *rp = (Reparse*)user;
+
+    Region r = { 0 };   /* stmt é preenchido em splice_regions */
+    r.start  = rp->base + st->start;
+    r.end    = rp->base + st->end;
+    r.node   = st->node;
+    r.errors = st->errors;
+    size_t scan = rp->base + st->scan_end + LEX_LOOKAHEAD;
+    r.scan_end = (st->lex_error || scan > rp->text_len) ? rp->text_len : scan;
+    region_push(&rp->out, r);
+
+    if (r.end < rp->edit_end) return true;
+
+    size_t old_end = (size_t)((long long)r.end - rp->delta);
+    while (rp->j < rp->old_count && rp->old[rp->j].end < old_end) rp->j++;
+    if (rp->j < rp->old_count && rp->old[rp->j].end == old_end) {
+        rp->resynced = true;
+        rp->resync_index = rp->j;
+        return false;
+    }
+    return true;
+}
+
+/* Analisa o texto a partir de `rp->base`; *scanned recebe quantos bytes
+ * foram percorridos */
+static void reparse(IncrementalParse *ip, Reparse *rp, size_t *scanned) {
+    ParseContext ctx;
+    memset(&ctx, 0, sizeof ctx);
+    ctx.lexer = ip->lexer;
+    ctx.quiet = true;     /* comentário não fechado vira fatal_line, sem exit */
+    ctx.strings = ip->strings;
+    ctx.src.data = ip->text + rp->base;
+    ctx.src.len  = ip->len - rp->base;
+    rp->text_len = ip->len;
+
+    /* sem arena: cada instrução substituída é liberada com ast_free */
+    struct Arena *prev = ast_set_arena(NULL);
+    if (lexer_open(&ctx)) {
+        (void)rd_parse_stmts(&ctx, on_stmt, rp);
+        lexer_close(&ctx);
+    }
+    parse_scratch_free(&ctx);
+    ast_set_arena(prev);
+
+    /* o estado do fim do texto só muda se a análise chegou até lá */
+    size_t last_end = rp->out.count ? rp->out.items[rp->out.count - 1].end : 0;
+    if (!rp->resynced || last_end == ip->len) ip->fatal = ctx.fatal_line != 0;
+    size_t last = rp->out.count ? rp->out.items[rp->out.count - 1].scan_end : ip->len;
+    *scanned = (rp->resynced ? last : ip->len) - rp->base;
+}
+
+/* Substitui as regiões [from, to) pelas novas e desloca as seguintes,
+ * atualizando junto o bloco raiz e o total de erros */
+static void splice_regions(IncrementalParse *ip, size_t from, size_t to,
+                           const RegionVec *fresh, long long delta) {
+    Node *root = ip->root;
+    size_t stmt = from < ip->count ? ip->regions[from].stmt : root->u.as_block.count;
+
+    size_t removed = 0;
+    for (size_t i = from; i < to; i++) {
+        if (ip->regions[i].node) removed++;
+        ip->errors -= ip->regions[i].errors;
+        ast_free(ip->regions[i].node);
+    }
+    size_t added = 0;
+    for (size_t i = 0; i < fresh->count; i++) {
+        if (fresh->items[i].node) added++;
+        ip->errors += fresh->items[i].errors;
+    }
+
+    /* regiões */
+    size_t tail = ip->count - to;
+    size_t count = from + fresh->count + tail;
+    if (count > ip->region_cap) {
+        ip->region_cap = count * 2;
+        ip->regions = (Region*)realloc(ip->regions, ip->region_cap * sizeof(Region));
+        if (!ip->regions) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+    }
+    Region *moved = ip->regions + from + fresh->count;
+    if (tail) memmove(moved, ip->regions + to, tail * sizeof(Region));
+    if (fresh->count) memcpy(ip->regions + from, fresh->items, fresh->count * sizeof(Region));
+    ip->count = count;
+
+    /* nós do bloco raiz */
+    size_t stmt_tail = root->u.as_block.count - stmt - removed;
+    size_t stmt_count = stmt + added + stmt_tail;
+    if (stmt_count > root->u.as_block.capacity) {
+        root->u.as_block.capacity = stmt_count * 2;
+        root->u.as_block.stmts = (Node**)realloc(root->u.as_block.stmts,
+                                                 root->u.as_block.capacity * sizeof(Node*));
+        if (!root->u.as_block.stmts) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+    }
+    Node **stmts = root->u.as_block.stmts;
+    if (stmt_tail) memmove(stmts + stmt + added, stmts + stmt + removed, stmt_tail * sizeof(Node*));
+    for (size_t i = from; i < from + fresh->count; i++) {
+        ip->regions[i].stmt = stmt;
+        if (ip->regions[i].node) stmts[stmt++] = ip->regions[i].node;
+    }
+    root->u.as_block.count = stmt_count;
+
+    /* posições das regiões seguintes; a primeira com erro léxico
+     * (lido até o fim do texto) pode estar entre elas */
+    if (ip->lex_first >= from) {
+        ip->lex_first = SIZE_MAX;
+        for (size_t i = from; i < from + fresh->count; i++)
+            if (ip->regions[i].scan_end == ip->len) { ip->lex_first = i; break; }
+    }
+    long long stmt_delta = (long long)added - (long long)removed;
+    for (size_t i = 0; i < tail; i++) {
+        Region *r = &moved[i];
+        r->start    = (size_t)((long long)r->start + delta);
+        r->end      = (size_t)((long long)r->end + delta);
+        r->scan_end = (size_t)((long long)r->scan_end + delta);
+        r->stmt     = (size_t)((long long)r->stmt + stmt_delta);
+        if (r->scan_end == ip->len && ip->lex_first == SIZE_MAX)
+            ip->lex_first = (size_t)(r - ip->regions);
+    }
+}
+
+/* Primeira região cuja leitura (token + lookahead) alcança `offset`.
+ * O lookahead de uma região é o primeiro token da seguinte, então só as
+ * vizinhas da busca binária pelo fim precisam ser olhadas, além da
+ * primeira que leu até o fim do texto (erro léxico). */
+static size_t first_touched(const IncrementalParse *ip, size_t offset) {
+    size_t lo = 0, hi = ip->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ip->regions[mid].end + LEX_LOOKAHEAD < offset) lo = mid + 1;
+        else hi = mid;
+    }
+    size_t i = lo ? lo - 1 : 0;
+    while (i < ip->count && ip->regions[i].scan_end < offset) i++;
+    return i < ip->lex_first ? i : ip->lex_first;
+}
+
+static void reserve_text(IncrementalParse *ip, size_t len) {
+    if (len + 2 <= ip->cap) return;
+    ip->cap = (len + 2) * 2;
+    ip->text = (char*)realloc(ip->text, ip->cap);
+    if (!ip->text) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+}
+
+IncrementalParse *incr_parse_new(const char *text, size_t len) {
+    IncrementalParse *ip = (IncrementalParse*)xmalloc(sizeof(IncrementalParse));
+    memset(ip, 0, sizeof *ip);
+    ip->lexer = lexer_default_kind();
+    ip->root = ast_block();
+    ip->strings = str_pool_new();
+    ip->lex_first = SIZE_MAX;
+
+    reserve_text(ip, len);
+    if (len) memcpy(ip->text, text, len);
+    ip->len = len;
+    ip->text[len] = ip->text[len + 1] = '\0';
+
+    Reparse rp;
+    memset(&rp, 0, sizeof rp);
+    size_t scanned;
+    reparse(ip, &rp, &scanned);
+    splice_regions(ip, 0, 0, &rp.out, 0);
+    free(rp.out.items);
+
+    ip->stats.reparsed_stmts = ip->count;
+    ip->stats.reused_stmts = 0;
+    ip->stats.reparsed_bytes = scanned;
+    return ip;
+}
+
+bool incr_parse_edit(IncrementalParse *ip, size_t offset, size_t removed,
+                     const char *text, size_t len) {
+    if (offset > ip->len || removed > ip->len - offset) return false;
+
+    /* primeira região cuja leitura alcança o trecho editado */
+    size_t first = first_touched(ip, offset);
+    size_t base = first ? ip->regions[first - 1].end : 0;
+
+    /* novo texto */
+    size_t new_len = ip->len - removed + len;
+    reserve_text(ip, new_len);
+    memmove(ip->text + offset + len, ip->text + offset + removed, ip->len - offset - removed);
+    if (len) memcpy(ip->text + offset, text, len);
+    ip->len = new_len;
+    ip->text[new_len] = ip->text[new_len + 1] = '\0';
+
+    Reparse rp;
+    memset(&rp, 0, sizeof rp);
+    rp.base      = base;
+    rp.old       = ip->regions;
+    rp.old_count = ip->count;
+    rp.j         = first;
+    rp.delta     = (long long)len - (long long)removed;
+    rp.edit_end  = offset + len;
+
+    size_t scanned;
+    reparse(ip, &rp, &scanned);
+
+    size_t to = rp.resynced ? rp.resync_index + 1 : ip->count;
+    ip->stats.reparsed_stmts = rp.out.count;
+    ip->stats.reused_stmts = ip->count - (to - first);
+    ip->stats.reparsed_bytes = scanned;
+
+    splice_regions(ip, first, to, &rp.out, rp.delta);
+    free(rp.out.items);
+    return true;
+}
+
+SyntaxResult incr_parse_result(const IncrementalParse *ip) {
+    SyntaxResult r;
+    memset(&r, 0, sizeof r);
+    r.parse_errors = ip->errors + (ip->fatal ? 1 : 0);
+    r.parse_ok = r.parse_errors == 0;
+    r.ast = ip->root;
+    r.strings = ip->strings;
+    return r;
+}
+
+const char *incr_parse_text(const IncrementalParse *ip, size_t *len) {
+    if (len) *len = ip->len;
+    return ip->text;
+}
+
+IncrStats incr_parse_stats(const IncrementalParse *ip) {
+    return ip->stats;
+}
+
+void incr_parse_free(IncrementalParse *ip) {
+    if (!ip) return;
+    ast_free(ip->root);   /* o bloco raiz contém exatamente os nós das regiões */
+    str_pool_free(ip->strings);
+    free(ip->regions);
+    free(ip->text);
+    free(ip);
+}
@@ -0,0 +1,163 @@
+#include "intern.h"
+#include "ast_base.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_INITIAL_SLOTS 256
+#define INTERN_CHUNK_SIZE    (64 * 1024)
+
+/* Cabeçalho guardado imediatamente antes dos caracteres do nome */
+typedef struct InternEntry {
+    uint32_t hash;
+    uint32_t id;
+    uint32_t len;
+    char     str[];
+} InternEntry;
+
+/* Blocos grandes de onde as entradas são alocadas (nunca se movem) */
+typedef struct InternChunk {
+    struct InternChunk *next;
+    size_t used;
+    size_t cap;
+    char   data[];
+} InternChunk;
+
+/* Posições da tabela (endereçamento aberto, potência de 2). Ao crescer,
+ * a tabela antiga fica em `prev` e não é liberada: outra thread pode
+ * ainda estar procurando nela */
+typedef struct InternTable {
+    struct InternTable *prev;
+    size_t cap;
+    _Atomic(InternEntry*) slots[];
+} InternTable;
+
+static _Atomic(InternTable*) g_table = NULL;
+static size_t        g_count = 0;
+static InternChunk  *g_chunks = NULL;
+
+/* Vários parsers podem internar nomes ao mesmo tempo (um por thread,
+ * ou um por trecho na tokenização paralela). As entradas nunca mudam
+ * depois de publicadas, e a tabela e cada posição são publicadas com
+ * store-release: a busca de um nome já internado não trava. O lock
+ * serializa só a inserção (e o crescimento); intern_hash/intern_id/
+ * intern_len leem o cabeçalho sem travar. */
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline const InternEntry *entry_of(const char *name) {
+    return (const InternEntry*)(name - offsetof(InternEntry, str));
+}
+
+/* FNV-1a (32 bits) */
+static uint32_t hash_bytes(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void *chunk_alloc(size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    if (!g_chunks || g_chunks->cap - g_chunks->used < size) {
+        size_t cap = size > INTERN_CHUNK_SIZE ? size : INTERN_CHUNK_SIZE;
+        InternChunk *c = (InternChunk*)xmalloc(sizeof(InternChunk) + cap);
+        c->next = g_chunks;
+        c->used = 0;
+        c->cap  = cap;
+        g_chunks = c;
+    }
+    void *p = g_chunks->data + g_chunks->used;
+    g_chunks->used += size;
+    return p;
+}
+
+/* Chamada com o lock: copia as entradas para uma tabela com o dobro
+ * de posições e só então a publica */
+static InternTable *grow_table(InternTable *old) {
+    size_t new_cap = old ? old->cap * 2 : INTERN_INITIAL_SLOTS;
+    InternTable *t = (InternTable*)calloc(1, sizeof(InternTable) + new_cap * sizeof(t->slots[0]));
+    if (!t) { fprintf(stderr, "error: calloc failed\n"); exit(1); }
+    t->prev = old;
+    t->cap  = new_cap;
+
+    for (size_t i = 0; old && i < old->cap; i++) {
+        InternEntry *e = atomic_load_explicit(&old->slots[i], memory_order_relaxed);
+        if (!e) continue;
+        size_t j = e->hash & (new_cap - 1);
+        while (atomic_load_explicit(&t->slots[j], memory_order_relaxed)) j = (j + 1) & (new_cap - 1);
+        atomic_store_explicit(&t->slots[j], e, memory_order_relaxed);
+    }
+    atomic_store_explicit(&g_table, t, memory_order_release);
+    return t;
+}
+
+/* Procura o nome em `t`. Devolve a entrada, ou NULL com *pos na posição
+ * vazia onde a busca parou */
+static InternEntry *probe(InternTable *t, uint32_t h, const char *s, size_t len, size_t *pos) {
+    size_t mask = t->cap - 1;
+    size_t i = h & mask;
+    for (InternEntry *e; (e = atomic_load_explicit(&t->slots[i], memory_order_acquire)) != NULL;
+         i = (i + 1) & mask) {
+        if (e->hash == h && e->len == len && memcmp(e->str, s, len) == 0) return e;
+    }
+    *pos = i;
+    return NULL;
+}
+
+const char *intern(const char *s, size_t len) {
+    uint32_t h = hash_bytes(s, len);
+    size_t i;
+
+    /* caso comum: o nome já existe (sem lock) */
+    InternTable *t = atomic_load_explicit(&g_table, memory_order_acquire);
+    InternEntry *e = t ? probe(t, h, s, len, &i) : NULL;
+    if (e) return e->str;
+
+    pthread_mutex_lock(&g_lock);
+
+    /* outra thread pode ter inserido o nome ou trocado a tabela */
+    t = atomic_load_explicit(&g_table, memory_order_relaxed);
+    /* mantém fator de carga <= 1/2 */
+    if (!t || (g_count + 1) * 2 > t->cap) t = grow_table(t);
+    e = probe(t, h, s, len, &i);
+    if (!e) {
+        e = (InternEntry*)chunk_alloc(sizeof(InternEntry) + len + 1);
+        e->hash = h;
+        e->id   = (uint32_t)g_count++;
+        e->len  = (uint32_t)len;
+        memcpy(e->str, s, len);
+        e->str[len] = '\0';
+        atomic_store_explicit(&t->slots[i], e, memory_order_release);
+    }
+
+    pthread_mutex_unlock(&g_lock);
+    return e->str;
+}
+
+const char *intern_cstr(const char *s) {
+    return intern(s, strlen(s));
+}
+
+uint32_t intern_hash(const char *name) {
+    return entry_of(name)->hash;
+}
+
+uint32_t intern_id(const char *name) {
+    return entry_of(name)->id;
+}
+
+size_t intern_len(const char *name) {
+    return entry_of(name)->len;
+}
+
+size_t intern_count(void) {
+    pthread_mutex_lock(&g_lock);
+    size_t n = g_count;
+    pthread_mutex_unlock(&g_lock);
+    return n;
+}
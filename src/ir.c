@@ -32,6 +32,7 @@ IrProgram *ir_program_new(void) {
     p->funcs = NULL;
     p->func_count = 0;
     p->func_cap = 0;
+    p->strings = NULL;
     return p;
 }
 
@@ -55,6 +56,8 @@ void ir_program_free(IrProgram *p) {
         if (f->params) free(f->params);
 
         if (f->locals) free(f->locals);
+        free(f->temp_local);
+        free(f->temp_types);
 
         free(f);
     }
@@ -79,6 +82,17 @@ IrFunc *ir_func_begin(IrProgram *p,
                       TypeTag ret_type,
                       const TypeTag *params,
                       size_t param_count)
+{
+    IrFunc *f = ir_func_new(name, ret_type, params, param_count);
+    ir_program_add(p, f);
+    return f;
+}
+
+// Cria uma função fora de qualquer programa
+IrFunc *ir_func_new(const char *name,
+                    TypeTag ret_type,
+                    const TypeTag *params,
+                    size_t param_count)
 {
     IrFunc *f = (IrFunc*)xmalloc(sizeof(IrFunc));
     f->name        = name;
@@ -91,6 +105,12 @@ IrFunc *ir_func_begin(IrProgram *p,
     f->locals      = NULL;
     f->local_count = 0;
     f->local_cap   = 0;
+    f->temp_local  = NULL;
+    f->temp_local_cap = 0;
+    f->temp_types  = NULL;
+    f->temp_types_cap = 0;
+    f->own_effects = 0;
+    f->effect      = IR_PURE;
 
     if (param_count > 0) {
         f->params = (TypeTag*)xmalloc(sizeof(TypeTag)*param_count);
@@ -100,10 +120,13 @@ IrFunc *ir_func_begin(IrProgram *p,
         f->params = NULL;
         f->param_count = 0;
     }
+    return f;
+}
 
+// Acrescenta `f` às funções do programa (que passa a ser o dono dela)
+void ir_program_add(IrProgram *p, IrFunc *f) {
     ir_program_grow_funcs(p);
     p->funcs[p->func_count++] = f;
-    return f;
 }
 
 // Finaliza a criação de uma função no programa
@@ -124,6 +147,36 @@ int ir_new_label(IrFunc *f) {
     return f->label_count++; /* L0, L1, L2, ... */
 }
 
+/* ===== Tipos dos temporários ===== */
+
+void ir_set_temp_type(IrFunc *f, int temp, TypeTag t) {
+    if (temp < 0) return;
+    if ((size_t)temp >= f->temp_types_cap) {
+        size_t cap = f->temp_types_cap ? f->temp_types_cap : 16;
+        while (cap <= (size_t)temp) cap *= 2;
+        f->temp_types = (TypeTag*)ir_xrealloc(f->temp_types, sizeof(TypeTag) * cap);
+        for (size_t i = f->temp_types_cap; i < cap; i++) f->temp_types[i] = TY_INVALID;
+        f->temp_types_cap = cap;
+    }
+    f->temp_types[temp] = t;
+}
+
+TypeTag ir_temp_type(const IrFunc *f, int temp) {
+    if (!f || temp < 0 || (size_t)temp >= f->temp_types_cap) return TY_INVALID;
+    return f->temp_types[temp];
+}
+
+static TypeTag operand_type(const IrFunc *f, IrOperand a) {
+    switch (a.kind) {
+        case IR_OPER_TEMP:   return ir_temp_type(f, a.v.temp);
+        case IR_OPER_INT:    return TY_INT;
+        case IR_OPER_FLOAT:  return TY_FLOAT;
+        case IR_OPER_BOOL:   return TY_BOOL;
+        case IR_OPER_STRING: return TY_STRING;
+        default:             return TY_INVALID;
+    }
+}
+
 /* ===== Emissão de instruções ===== */
 
 // Emite uma instrução de label
@@ -169,6 +222,7 @@ int ir_emit_mov(IrFunc *f, IrOperand a) {
     ins.a   = a;
     ins.b.kind = IR_OPER_NONE;
     ir_push(f, &ins);
+    ir_set_temp_type(f, dst, operand_type(f, a));
     return dst;
 }
 
@@ -182,6 +236,7 @@ int ir_emit_cast(IrFunc *f, IrOperand a, TypeTag to) {
     ins.cast_to = to;
     ins.b.kind = IR_OPER_NONE;
     ir_push(f, &ins);
+    ir_set_temp_type(f, dst, to);
     return dst;
 }
 
@@ -199,25 +254,32 @@ static int ir_emit_bin_like(IrFunc *f, IrOp op, IrOperand a, IrOperand b) {
 
 // Emite uma instrução binária
 int ir_emit_bin(IrFunc *f, IrOp op, IrOperand a, IrOperand b) {
-    /* deve ser IR_ADD/IR_SUB/IR_MUL/IR_DIV */
-    return ir_emit_bin_like(f, op, a, b);
+    /* deve ser IR_ADD/IR_SUB/IR_MUL/IR_DIV; operandos do mesmo tipo
+     * (o IR builder converte antes), que é o do resultado */
+    int dst = ir_emit_bin_like(f, op, a, b);
+    TypeTag ta = operand_type(f, a), tb = operand_type(f, b);
+    ir_set_temp_type(f, dst, ta == tb ? ta : TY_INVALID);
+    return dst;
 }
 
 
 // Emite uma instrução de comparação
 int ir_emit_cmp(IrFunc *f, IrOp op, IrOperand a, IrOperand b) {
     /* deve ser IR_LT/IR_LE/IR_GT/IR_GE/IR_EQ/IR_NE */
-    return ir_emit_bin_like(f, op, a, b);
+    int dst = ir_emit_bin_like(f, op, a, b);
+    ir_set_temp_type(f, dst, TY_BOOL);
+    return dst;
 }
 
 // Emite uma instrução de chamada de função
-int ir_emit_call(IrFunc *f, const char *name,
+int ir_emit_call(IrFunc *f, const char *name, int callee_index,
                  const int *arg_temps, size_t argc,
                  TypeTag ret_type)
 {
     IrInstr ins = {0};
     ins.op       = IR_CALL;
     ins.callee   = name;
+    ins.callee_index = callee_index;
     ins.argc     = argc;
     ins.ret_type = ret_type;
 
@@ -228,6 +290,7 @@ int ir_emit_call(IrFunc *f, const char *name,
 
     if (ret_type != TY_VOID) {
         ins.dst = ir_new_temp(f);
+        ir_set_temp_type(f, ins.dst, ret_type);
     } else {
         ins.dst = -1;
     }
@@ -260,15 +323,42 @@ static void ir_func_grow_locals(IrFunc *f) {
 void ir_register_local(IrFunc *f, const char *name, int temp) {
     if (!f || !name) return;
 
-    /* Não sobrescrevemos entradas antigas: cada temp mantém o nome associado. */
-    for (size_t i = 0; i < f->local_count; ++i) {
-        if (f->locals[i].temp == temp && strcmp(f->locals[i].name, name) == 0) {
-            return; /* já registramos este par nome/temp */
-        }
+    if (temp < 0) {
+        /* sem índice para temps inválidos (ex.: resultado de chamada void) */
+        for (size_t i = 0; i < f->local_count; ++i)
+            if (f->locals[i].temp == temp && f->locals[i].name == name) return;
+        ir_func_grow_locals(f);
+        f->locals[f->local_count++] = (IrLocalVar){ name, temp, 0 };
+        return;
+    }
+
+    if ((size_t)temp >= f->temp_local_cap) {
+        size_t cap = f->temp_local_cap ? f->temp_local_cap : 16;
+        while (cap <= (size_t)temp) cap *= 2;
+        f->temp_local = (int*)ir_xrealloc(f->temp_local, sizeof(int) * cap);
+        memset(f->temp_local + f->temp_local_cap, 0, sizeof(int) * (cap - f->temp_local_cap));
+        f->temp_local_cap = cap;
+    }
+
+    /* Não sobrescrevemos entradas antigas: cada temp mantém o nome associado.
+     * Só os locais do mesmo temp (encadeados por `next`) são comparados. */
+    int last = 0;
+    for (int i = f->temp_local[temp]; i; i = f->locals[i - 1].next) {
+        if (f->locals[i - 1].name == name) return; /* já registramos este par nome/temp */
+        last = i;
     }
 
     ir_func_grow_locals(f);
-    f->locals[f->local_count].name = name;
-    f->locals[f->local_count].temp = temp;
-    f->local_count++;
+    f->locals[f->local_count++] = (IrLocalVar){ name, temp, 0 };
+    if (last) f->locals[last - 1].next = (int)f->local_count;
+    else      f->temp_local[temp] = (int)f->local_count;
+}
+
+const char *ir_local_name(const IrFunc *f, int temp) {
+    if (!f || temp < 0 || (size_t)temp >= f->temp_local_cap || !f->temp_local[temp]) return NULL;
+    return f->locals[f->temp_local[temp] - 1].name;
+}
+
+void ir_mark_effect(IrFunc *f, unsigned fx) {
+    if (f) f->own_effects |= fx;
 }
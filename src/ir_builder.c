@@ -1,225 +1,481 @@
 #include "ir_builder.h"
 #include "ast_base.h"
 #include "ast_expr.h"
+#include "ast_compact.h"
+#include "ast_fold.h"
+#include "ir_effects.h"
+#include "resolve.h"
+#include "semantic_analyzer.h"
+#include "arena.h"
+#include "work_stack.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
 
 /* ---------------------------------------------------------
- *  Map simples: variável (nome) → temporário (tN)
+ *  Variável → temporário, por slot (resolve.h)
+ *  Cada instrução de nível superior é resolvida antes de ser emitida;
+ *  a célula do slot guarda o temporário com o valor atual da variável
+ *  (-1 = nenhum ainda). Um uso sem temporário (parâmetro, nome sem
+ *  declaração) ganha um novo, que vale até o fim do bloco corrente: o
+ *  registro `lazy` desfaz esses ao sair do bloco. À parte, o tipo
+ *  declarado do slot: valores atribuídos são convertidos para ele.
  * --------------------------------------------------------- */
-typedef struct VarTemp {
-    const char *name;
-    int         temp;
-    int         depth;
-    struct VarTemp *next;
-} VarTemp;
-
-static VarTemp *g_vars = NULL;
-static int g_scope_depth = 0; /* profundidade atual de escopo */
-
-/* xstrdup/xmalloc já existem em ast_base.c */
-extern void *xmalloc(size_t);
-extern char *xstrdup(const char*);
-
-/* ---------- utilitários pro map (snapshot/restore) ---------- */
-
-/* clona (shallow) a lista encadeada de VarTemp.
- * (clonamos apenas os nós; os ponteiros de name são reutilizados) */
-static VarTemp* vt_clone_list(VarTemp *head) {
-    VarTemp *copy = NULL, **tail = &copy;
-    for (VarTemp *v = head; v; v = v->next) {
-        VarTemp *nv = (VarTemp*)xmalloc(sizeof(VarTemp));
-        nv->name = v->name;
-        nv->temp = v->temp;
-        nv->depth = v->depth;
-        nv->next = NULL;
-        *tail = nv;
-        tail = &nv->next;
-    }
-    return copy;
+typedef struct {
+    int   *items;
+    size_t cap;
+    size_t used;    /* células já tocadas (limite do reset) */
+} TempSlots;
+
+typedef struct {
+    TypeTag *items;
+    size_t   cap;
+    size_t   used;
+} SlotTypes;
+
+typedef struct {
+    int32_t slot;
+    bool    captured;
+    int     depth;
+} LazyTemp;
+
+/* Estado de uma unidade: uma função ou o código global (_entry) */
+typedef struct {
+    TempSlots temps;        /* slots da unidade */
+    TempSlots captured;     /* globais usadas dentro de uma função */
+    SlotTypes local_types;  /* tipo declarado das locais da função */
+    LazyTemp *lazy;
+    size_t    lazy_count, lazy_cap;
+    int       scope_depth;  /* profundidade atual de escopo */
+    bool      in_function;
+} Unit;
+
+/* As instruções de nível superior são emitidas na ordem do fonte: cada
+ * função vai para a sua IrFunc enquanto o estado do código global fica
+ * guardado em `g_spare` (as duas guardam a memória entre usos) */
+static Unit      g_unit;
+static Unit      g_spare;
+static SlotTypes g_global_types;    /* tipo declarado das globais do programa */
+
+/* Funções de nível superior do programa em construção: o fn_index de
+ * uma chamada (resolve.h) abaixo disso é a posição dela em prog->funcs */
+static int32_t   g_program_funcs = 0;
+static Resolver *g_resolver = NULL;  /* assinaturas das funções chamadas */
+
+static int callee_index(const Node *call) {
+    int32_t i = call->u.as_call.fn_index;
+    return (i >= 0 && i < g_program_funcs) ? (int)i : -1;
+}
+
+static void temps_clear(TempSlots *ts) {
+    for (size_t i = 0; i < ts->used; i++) ts->items[i] = -1;
+    ts->used = 0;
 }
 
-static void vt_free_list(VarTemp *head) {
-    while (head) {
-        VarTemp *nx = head->next;
-        free(head);
-        head = nx;
+static int *temp_cell_in(TempSlots *ts, int32_t slot) {
+    if ((size_t)slot >= ts->cap) {
+        size_t cap = ts->cap ? ts->cap : 64;
+        while (cap <= (size_t)slot) cap *= 2;
+        ts->items = (int*)realloc(ts->items, cap * sizeof(int));
+        if (!ts->items) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+        for (size_t i = ts->cap; i < cap; i++) ts->items[i] = -1;
+        ts->cap = cap;
     }
+    if ((size_t)slot >= ts->used) ts->used = (size_t)slot + 1;
+    return &ts->items[slot];
 }
 
-/* substitui g_vars por um clone de 'src' */
-static void vt_restore_from(VarTemp *src) {
-    /* libera g_vars atual */
-    vt_free_list(g_vars);
-    g_vars = vt_clone_list(src);
+static void types_clear(SlotTypes *st) {
+    for (size_t i = 0; i < st->used; i++) st->items[i] = TY_INVALID;
+    st->used = 0;
 }
 
-static void vt_insert_manual(const char *name, int temp_id) {
-    // Verifica se já existe
-    for (VarTemp *v = g_vars; v; v = v->next) {
-        if (strcmp(v->name, name) == 0) {
-            v->temp = temp_id;
-            return;
-        }
+static void types_set(SlotTypes *st, int32_t slot, TypeTag t) {
+    if ((size_t)slot >= st->cap) {
+        size_t cap = st->cap ? st->cap : 64;
+        while (cap <= (size_t)slot) cap *= 2;
+        st->items = (TypeTag*)realloc(st->items, cap * sizeof(TypeTag));
+        if (!st->items) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+        for (size_t i = st->cap; i < cap; i++) st->items[i] = TY_INVALID;
+        st->cap = cap;
     }
+    if ((size_t)slot >= st->used) st->used = (size_t)slot + 1;
+    st->items[slot] = t;
+}
+
+static void unit_free(Unit *u) {
+    free(u->temps.items);
+    free(u->captured.items);
+    free(u->local_types.items);
+    free(u->lazy);
+    *u = (Unit){0};
+}
+
+static bool is_captured(const VarRef *ref) {
+    return g_unit.in_function && (ref->flags & VAR_GLOBAL);
+}
+
+/* Variável de fora da função sendo emitida (ir_effects.h): global ou,
+ * numa função resolvida sozinha (irb_emit_func), nome sem declaração */
+static bool is_outside(const VarRef *ref) {
+    return g_unit.in_function && (ref->flags & (VAR_GLOBAL | VAR_UNDECLARED));
+}
+
+/* célula do slot (só vale até a próxima chamada: o array pode crescer) */
+static int *temp_cell(const VarRef *ref) {
+    return temp_cell_in(is_captured(ref) ? &g_unit.captured : &g_unit.temps, ref->slot);
+}
+
+/* Globais têm o tipo guardado no programa: uma função também o enxerga */
+static SlotTypes *types_of(const VarRef *ref) {
+    return (ref->flags & VAR_GLOBAL) ? &g_global_types : &g_unit.local_types;
+}
+
+static void set_var_type(const VarRef *ref, TypeTag t) {
+    types_set(types_of(ref), ref->slot, t);
+}
+
+static TypeTag var_type(const VarRef *ref) {
+    const SlotTypes *st = types_of(ref);
+    return (size_t)ref->slot < st->cap ? st->items[ref->slot] : TY_INVALID;
+}
 
-    VarTemp *nv = (VarTemp*)xmalloc(sizeof(VarTemp));
-    nv->name = name;
-    nv->temp = temp_id;
-    nv->depth = g_scope_depth;
-    nv->next = g_vars;
-    g_vars   = nv;
+/* temporário novo para um slot usado antes de receber valor; o tipo é
+ * o declarado ou, se o slot não tem declaração (nome sem declaração),
+ * o anotado pela análise semântica em `hint` */
+static int lazy_temp(IrFunc *f, const VarRef *ref, TypeTag hint) {
+    if (g_unit.lazy_count == g_unit.lazy_cap) {
+        g_unit.lazy_cap = g_unit.lazy_cap ? g_unit.lazy_cap * 2 : 64;
+        g_unit.lazy = (LazyTemp*)realloc(g_unit.lazy, g_unit.lazy_cap * sizeof(LazyTemp));
+        if (!g_unit.lazy) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    }
+    g_unit.lazy[g_unit.lazy_count++] = (LazyTemp){ ref->slot, is_captured(ref), g_unit.scope_depth };
+    if (is_outside(ref)) ir_mark_effect(f, IR_FX_READS);
+
+    int t = ir_new_temp(f);
+    TypeTag vt = var_type(ref);
+    ir_set_temp_type(f, t, vt != TY_INVALID ? vt : hint);
+    *temp_cell(ref) = t;
+    return t;
 }
 
 void irb_reset_state(void) {
-    vt_free_list(g_vars);
-    g_vars = NULL;
-    g_scope_depth = 0;
+    temps_clear(&g_unit.temps);
+    temps_clear(&g_unit.captured);
+    types_clear(&g_unit.local_types);
+    g_unit.lazy_count = 0;
+    g_unit.scope_depth = 0;
 }
 
 static void irb_enter_scope(void) {
-    g_scope_depth++;
+    g_unit.scope_depth++;
 }
 
 static void irb_leave_scope(void) {
-    // Remove todas as variáveis declaradas neste nível
-    VarTemp **pp = &g_vars;
-    while (*pp) {
-        if ((*pp)->depth == g_scope_depth) {
-            VarTemp *dead = *pp;
-            *pp = dead->next;
-            free(dead);
-        } else {
-            pp = &(*pp)->next;
-        }
+    // Esquece os temporários criados sob demanda neste nível
+    while (g_unit.lazy_count > 0 && g_unit.lazy[g_unit.lazy_count - 1].depth >= g_unit.scope_depth) {
+        const LazyTemp *lz = &g_unit.lazy[--g_unit.lazy_count];
+        temp_cell_in(lz->captured ? &g_unit.captured : &g_unit.temps, lz->slot)[0] = -1;
     }
-    if (g_scope_depth > 0) {
-        g_scope_depth--;
+    if (g_unit.scope_depth > 0) {
+        g_unit.scope_depth--;
     }
 }
 
-/* retorna temp atual da var; se não existir e create_if_missing=true, cria um novo tN
- * decl_type é guardado para futuras extensões (store/load, init default, etc.) */
-static int vt_get(IrFunc *f, const char *name, bool create_if_missing, TypeTag decl_type, bool *was_created) {
-    for (VarTemp *v = g_vars; v; v = v->next) {
-        if (strcmp(v->name, name) == 0) {
-            if (was_created) *was_created = false;
-            return v->temp;
+/* -------------------------------------------------------
+ *  Constrói um programa IR completo a partir da AST
+ * ------------------------------------------------------- */
+
+/* Emite uma função de nível superior (ND_FUNCTION) */
+static void build_function(IrProgram *prog, Node *stmt) {
+    // Extrai informações da função
+    TypeTag ret_type = stmt->u.as_function.ret_type;
+    const char *name = stmt->u.as_function.name;
+    size_t param_count = stmt->u.as_function.param_count;
+
+    // Prepara array de tipos dos parâmetros
+    TypeTag *param_types = NULL;
+    if (param_count > 0) {
+        param_types = (TypeTag*)xmalloc(sizeof(TypeTag) * param_count);
+        for (size_t j = 0; j < param_count; j++) {
+            Node *param = stmt->u.as_function.params[j];
+            param_types[j] = param->u.as_decl.type;
         }
     }
-    if (!create_if_missing) {
-        if (was_created) *was_created = false;
-        return -1;
+
+    // Cria a função no IR
+    IrFunc *func = ir_func_begin(prog, name, ret_type, param_types, param_count);
+
+    // Emite o corpo com uma unidade própria; a do código global fica guardada
+    Unit global = g_unit;
+    g_unit = g_spare;
+    irb_reset_state();
+    g_unit.in_function = true;
+    for (size_t j = 0; j < param_count; j++)
+        set_var_type(&stmt->u.as_function.params[j]->u.as_decl.ref, param_types[j]);
+    irb_emit_stmt(func, stmt->u.as_function.body);
+    g_unit.in_function = false;
+    g_spare = g_unit;
+    g_unit = global;
+    ir_func_end(prog, func);
+
+    if (param_types) free(param_types);
+}
+
+/* Instrução de nível superior simplificada (ast_fold.h) se o passo
+ * estiver ligado, depois resolvida (resolve.h); as cópias do
+ * dobramento ficam na arena corrente */
+static Node *prepare_top(Folder *fd, Resolver *rs, Node *stmt) {
+    if (fd) stmt = fold_stmt(fd, stmt);
+    return stmt ? resolve_stmt(rs, stmt) : NULL;
+}
+
+/* Folder com todas as funções do programa já declaradas e as constantes
+ * propagadas; NULL se o passo estiver desligado */
+static Folder *fold_begin(Node *ast) {
+    if (!fold_enabled()) return NULL;
+    Folder *fd = fold_new();
+    if (ast->kind == ND_BLOCK) {
+        for (size_t i = 0; i < ast->u.as_block.count; ++i) {
+            Node *stmt = ast->u.as_block.stmts[i];
+            if (stmt->kind == ND_FUNCTION)
+                fold_declare_function(fd, stmt->u.as_function.name, stmt->u.as_function.ret_type);
+        }
+        for (size_t i = 0; i < ast->u.as_block.count; ++i)
+            fold_scan_stmt(fd, ast->u.as_block.stmts[i]);
+    } else {
+        fold_scan_stmt(fd, ast);
     }
-    VarTemp *nv = (VarTemp*)xmalloc(sizeof(VarTemp));
-    nv->name = name; /* NÃO duplico por padrão (nome vive na AST) */
-    nv->temp = ir_new_temp(f);
-    nv->depth = g_scope_depth;
-    nv->next = g_vars;
-    g_vars   = nv;
-    if (was_created) *was_created = true;
+    fold_scan_finish(fd);
+    return fd;
+}
 
-    (void)decl_type; /* por enquanto não emitimos init default */
-    return nv->temp;
+/* Programa em construção, uma instrução de nível superior por vez, na
+ * ordem do fonte: as funções vão para prog->funcs na ordem do registro
+ * de funções do resolvedor (mesmos índices) e o código global para
+ * _entry (devolvida por program_begin), que entra por último */
+static IrFunc *program_begin(Resolver *rs) {
+    g_program_funcs = resolve_function_count(rs);
+    g_resolver = rs;
+    irb_reset_state();
+    types_clear(&g_global_types);
+    return ir_func_new("_entry", TY_VOID, NULL, 0);
 }
 
-/* -------------------------------------------------------
- *  Constrói um programa IR completo a partir da AST
- * ------------------------------------------------------- */
-IrProgram *irb_build_program(Node *ast) {
+/* Emite uma instrução de nível superior já resolvida */
+static void program_stmt(IrProgram *prog, IrFunc *entry, Node *stmt) {
+    if (!stmt) return;
+    if (stmt->kind == ND_FUNCTION) build_function(prog, stmt);
+    else irb_emit_stmt(entry, stmt);
+}
+
+static void program_end(IrProgram *prog, IrFunc *entry) {
+    ir_emit_ret(entry, false, (IrOperand){.kind = IR_OPER_NONE});
+    ir_program_add(prog, entry);
+    ir_func_end(prog, entry);
+    ir_effects_compute(prog);
+    g_program_funcs = 0;
+    g_resolver = NULL;
+}
+
+IrProgram *irb_build_program(Node *ast, const StrPool *strings) {
     if (!ast) return NULL;
 
     IrProgram *prog = ir_program_new();
-    // fprintf(stderr, "DEBUG BUILDER: Iniciando construção do programa IR\n");
+    prog->strings = strings;
+
+    /* o que o dobramento copia vive só até a instrução ser emitida */
+    Resolver *rs = resolve_new();
+    resolve_declare_functions(rs, ast);
+    Folder *fd = fold_begin(ast);
+    Arena *scratch = fd ? arena_new() : NULL;
+    Arena *prev = fd ? ast_set_arena(scratch) : NULL;
+    IrFunc *entry = program_begin(rs);
 
     // Processa a AST: se for um bloco, processa cada statement
     if (ast->kind == ND_BLOCK) {
-        // fprintf(stderr, "DEBUG BUILDER: AST é um bloco com %zu statements\n", ast->u.as_block.count);
-
-        // Primeiro: processa todas as funções
         for (size_t i = 0; i < ast->u.as_block.count; ++i) {
-            Node *stmt = ast->u.as_block.stmts[i];
-            if (stmt->kind == ND_FUNCTION) {
-                // fprintf(stderr, "DEBUG BUILDER: Processando função %s\n", stmt->u.as_function.name);
-
-                // Extrai informações da função
-                TypeTag ret_type = stmt->u.as_function.ret_type;
-                const char *name = stmt->u.as_function.name;
-                size_t param_count = stmt->u.as_function.param_count;
-
-                // fprintf(stderr, "DEBUG BUILDER: Função %s -> ret_type=%d, param_count=%zu\n",
-                //        name, ret_type, param_count);
-
-                // Prepara array de tipos dos parâmetros
-                TypeTag *param_types = NULL;
-                if (param_count > 0) {
-                    param_types = (TypeTag*)xmalloc(sizeof(TypeTag) * param_count);
-                    for (size_t j = 0; j < param_count; j++) {
-                        Node *param = stmt->u.as_function.params[j];
-                        param_types[j] = param->u.as_decl.type;
-                        // fprintf(stderr, "DEBUG BUILDER: Parâmetro %zu: tipo=%d\n", j, param_types[j]);
-                    }
-                }
+            program_stmt(prog, entry, prepare_top(fd, rs, ast->u.as_block.stmts[i]));
+            if (scratch) arena_reset(scratch);
+        }
+    } else {
+        // AST não é um bloco - só _entry
+        program_stmt(prog, entry, prepare_top(fd, rs, ast));
+    }
+    program_end(prog, entry);
 
-                // Cria a função no IR
-                IrFunc *func = ir_func_begin(prog, name, ret_type, param_types, param_count);
-                // fprintf(stderr, "DEBUG BUILDER: Função %s criada no IR\n", name);
+    if (fd) {
+        ast_set_arena(prev);
+        arena_free(scratch);
+        fold_free(fd);
+    }
+    resolve_free(rs);
+    return prog;
+}
 
-                // Emite o corpo da função
-                irb_reset_state();
-                irb_emit_stmt(func, stmt->u.as_function.body);
-                ir_func_end(prog, func);
-                // fprintf(stderr, "DEBUG BUILDER: Corpo da função %s emitido\n", name);
+/* Mesma saída de irb_build_program, a partir da AST compacta.
+ * Cada instrução de nível superior, na ordem do fonte, é montada como
+ * Node numa arena temporária, simplificada, emitida e descartada. */
+IrProgram *irb_build_program_compact(const CompactAst *ast, const StrPool *strings) {
+    if (!ast || ast->root == CAST_NONE) return NULL;
+    if (cast_kind(ast, ast->root) != ND_BLOCK) {
+        Arena *arena = arena_new();
+        Arena *prev = ast_set_arena(arena);
+        IrProgram *prog = irb_build_program(cast_to_node(ast, ast->root), strings);
+        ast_set_arena(prev);
+        arena_free(arena);
+        return prog;
+    }
 
-                if (param_types) free(param_types);
-            }
+    IrProgram *prog = ir_program_new();
+    prog->strings = strings;
+
+    Arena *scratch = arena_new();
+    Arena *prev = ast_set_arena(scratch);
+    CList top = *cast_block(ast, ast->root);
+
+    Resolver *rs = resolve_new();
+    resolve_declare_functions_compact(rs, ast);
+    Folder *fd = fold_enabled() ? fold_new() : NULL;
+    for (uint32_t i = 0; fd && i < top.count; ++i) {
+        CNode n = cast_list_at(ast, top, i);
+        if (cast_kind(ast, n) != ND_FUNCTION) continue;
+        const CFunction *fn = cast_function(ast, n);
+        fold_declare_function(fd, cast_name(ast, fn->name), fn->ret_type);
+    }
+    if (fd) {
+        for (uint32_t i = 0; i < top.count; ++i) {
+            fold_scan_stmt(fd, cast_to_node(ast, cast_list_at(ast, top, i)));
+            arena_reset(scratch);
         }
+        fold_scan_finish(fd);
+    }
 
-        // Segundo: cria função _entry para código global
-        // fprintf(stderr, "DEBUG BUILDER: Criando função _entry para código global\n");
-        IrFunc *entry = ir_func_begin(prog, "_entry", TY_VOID, NULL, 0);
-        irb_reset_state();
+    IrFunc *entry = program_begin(rs);
+    for (uint32_t i = 0; i < top.count; ++i) {
+        program_stmt(prog, entry, prepare_top(fd, rs, cast_to_node(ast, cast_list_at(ast, top, i))));
+        arena_reset(scratch);
+    }
+    program_end(prog, entry);
 
-        // int global_stmts = 0;
-        for (size_t i = 0; i < ast->u.as_block.count; ++i) {
-            Node *stmt = ast->u.as_block.stmts[i];
-            if (stmt->kind != ND_FUNCTION) {
-                irb_emit_stmt(entry, stmt);
-                // global_stmts++;
-            }
-        }
-        // fprintf(stderr, "DEBUG BUILDER: _entry tem %d statements globais\n", global_stmts);
+    fold_free(fd);
+    resolve_free(rs);
+    ast_set_arena(prev);
+    arena_free(scratch);
+    return prog;
+}
 
-        ir_emit_ret(entry, false, (IrOperand){.kind = IR_OPER_NONE});
-        ir_func_end(prog, entry);
-        // fprintf(stderr, "DEBUG BUILDER: Função _entry criada\n");
+/* -------------------------------------------------------
+ *  Verificação e IR numa só passada (ASTEROIDS_FUSED=1)
+ *  Cada instrução de nível superior é resolvida uma vez e o mesmo
+ *  resolvedor (slots, registro de funções) serve à verificação e à
+ *  emissão. Depois do primeiro erro, só a verificação continua.
+ * ------------------------------------------------------- */
+bool irb_fused_enabled(void) {
+    const char *env = getenv("ASTEROIDS_FUSED");
+    return env && strcmp(env, "1") == 0;
+}
+
+static void fused_stmt(IrProgram *prog, IrFunc *entry, Resolver *rs, Node *stmt, int *errors) {
+    stmt = resolve_stmt(rs, stmt);
+    *errors += check_resolved_stmt(rs, stmt);
+    if (*errors == 0) program_stmt(prog, entry, stmt);
+}
+
+/* Fim da passada única: o programa, ou NULL se houve erro */
+static IrProgram *fused_end(IrProgram *prog, IrFunc *entry, Resolver *rs, int errors) {
+    program_end(prog, entry);
+    check_end();
+    resolve_free(rs);
+    if (errors == 0) return prog;
+    ir_program_free(prog);
+    return NULL;
+}
+
+IrProgram *irb_check_and_build(Node *ast, const StrPool *strings, SymbolTable *table, int *errors) {
+    *errors = 0;
+    if (!ast) return NULL;
+    if (fold_enabled()) {
+        /* o dobramento quer a instrução já verificada e refaz nós, que
+         * teriam de ser resolvidos de novo: ficam as duas passadas */
+        *errors = check_semantics(ast, table);
+        return *errors ? NULL : irb_build_program(ast, strings);
+    }
+
+    IrProgram *prog = ir_program_new();
+    prog->strings = strings;
+    Resolver *rs = resolve_new();
+    resolve_declare_functions(rs, ast);
+    check_begin(rs, table);
+    IrFunc *entry = program_begin(rs);
+
+    if (ast->kind == ND_BLOCK) {
+        for (size_t i = 0; i < ast->u.as_block.count; ++i)
+            fused_stmt(prog, entry, rs, ast->u.as_block.stmts[i], errors);
     } else {
-        // AST não é um bloco - cria apenas _entry
-        // fprintf(stderr, "DEBUG BUILDER: AST não é bloco, criando apenas _entry\n");
-        IrFunc *entry = ir_func_begin(prog, "_entry", TY_VOID, NULL, 0);
-        irb_reset_state();
-        irb_emit_stmt(entry, ast);
-        ir_emit_ret(entry, false, (IrOperand){.kind = IR_OPER_NONE});
-        ir_func_end(prog, entry);
+        fused_stmt(prog, entry, rs, ast, errors);
     }
+    return fused_end(prog, entry, rs, *errors);
+}
 
-    // fprintf(stderr, "DEBUG BUILDER: Programa IR construído com %zu funções\n", prog->func_count);
-    // for (size_t i = 0; i < prog->func_count; ++i) {
-    //     fprintf(stderr, "DEBUG BUILDER: Função %zu no programa: %s\n",
-    //            i, prog->funcs[i]->name ? prog->funcs[i]->name : "<unnamed>");
-    // }
+IrProgram *irb_check_and_build_compact(const CompactAst *ast, const StrPool *strings,
+                                       SymbolTable *table, int *errors) {
+    *errors = 0;
+    if (!ast || ast->root == CAST_NONE) return NULL;
+    if (fold_enabled()) {
+        *errors = check_semantics_compact(ast, table);
+        return *errors ? NULL : irb_build_program_compact(ast, strings);
+    }
 
+    IrProgram *prog = ir_program_new();
+    prog->strings = strings;
+    Arena *scratch = arena_new();
+    Arena *prev = ast_set_arena(scratch);
+    Resolver *rs = resolve_new();
+    resolve_declare_functions_compact(rs, ast);
+    check_begin(rs, table);
+    IrFunc *entry = program_begin(rs);
+
+    if (cast_kind(ast, ast->root) == ND_BLOCK) {
+        CList top = *cast_block(ast, ast->root);
+        for (uint32_t i = 0; i < top.count; ++i) {
+            fused_stmt(prog, entry, rs, cast_to_node(ast, cast_list_at(ast, top, i)), errors);
+            arena_reset(scratch);
+        }
+    } else {
+        fused_stmt(prog, entry, rs, cast_to_node(ast, ast->root), errors);
+    }
+    prog = fused_end(prog, entry, rs, *errors);
+    ast_set_arena(prev);
+    arena_free(scratch);
     return prog;
 }
 
 /* ---------------------------------------------------------
  *  Helpers de emissão
  * --------------------------------------------------------- */
-__attribute__((unused))
 static inline int is_num(TypeTag t){ return t==TY_INT || t==TY_FLOAT; }
 
+/* Converte o temporário para `to` (IR_CAST) se os dois tipos forem
+ * numéricos e diferentes; tipos desconhecidos não convertem */
+static int coerce(IrFunc *f, int t, TypeTag to) {
+    TypeTag from = ir_temp_type(f, t);
+    if (t < 0 || from == to || !is_num(from) || !is_num(to)) return t;
+    return ir_emit_cast(f, ir_temp(t), to);
+}
+
+/* Operandos numéricos de tipos diferentes vão para float; a divisão é
+ * sempre em float (infer_binary) */
+static void promote(IrFunc *f, BinOp op, int *L, int *R) {
+    TypeTag lt = ir_temp_type(f, *L), rt = ir_temp_type(f, *R);
+    if (!is_num(lt) || !is_num(rt)) return;
+    if (op == BIN_DIV || lt != rt) {
+        *L = coerce(f, *L, TY_FLOAT);
+        *R = coerce(f, *R, TY_FLOAT);
+    }
+}
+
 static int emit_bin(IrFunc *f, IrOp op, int lt, int rt) {
     return ir_emit_bin(f, op, ir_temp(lt), ir_temp(rt));
 }
@@ -229,148 +485,214 @@ static int emit_cmp(IrFunc *f, IrOp op, int lt, int rt) {
 
 /* ---------------------------------------------------------
  *  Expressões
+ *  Iterativo: uma pilha de quadros no heap faz o papel da recursão
+ *  (expressões de qualquer profundidade). Cada quadro guarda o nó, o
+ *  estágio e os temporários já obtidos; o temporário do filho que
+ *  acabou de terminar chega em `ret`. A ordem das instruções emitidas
+ *  é a mesma da definição recursiva (inclusive o lado direito de &&/||,
+ *  avaliado uma segunda vez dentro do desvio).
  * --------------------------------------------------------- */
-static int emit_unary(IrFunc *f, Node *n);
-static int emit_binary(IrFunc *f, Node *n);
-
-int irb_emit_expr(IrFunc *f, Node *e) {
-    if (!e) return -1;
-
-    switch (e->kind) {
-        case ND_INT:    return ir_emit_mov(f, ir_int(e->u.as_int.value));
-        case ND_FLOAT:  return ir_emit_mov(f, ir_float(e->u.as_float.value));
-        case ND_BOOL:   return ir_emit_mov(f, ir_bool(e->u.as_bool.value));
+typedef struct {
+    Node  *e;
+    int    stage;
+    int    a, b;      /* temporários / rótulos guardados entre estágios */
+    size_t i;         /* próximo argumento (ND_CALL) */
+    int   *argv;
+} EmitFrame;
+
+static void emit_push(WorkStack *s, Node *e) {
+    EmitFrame *f = (EmitFrame*)ws_push(s);
+    f->e = e;
+    f->stage = 0;
+    f->a = f->b = -1;
+    f->i = 0;
+    f->argv = NULL;
+}
 
-        case ND_STRING:
-            return ir_emit_mov(f, ir_string(e->u.as_string.value));
+static IrOp binop_to_ir(BinOp op) {
+    switch (op) {
+        case BIN_ADD: return IR_ADD;
+        case BIN_SUB: return IR_SUB;
+        case BIN_MUL: return IR_MUL;
+        case BIN_DIV: return IR_DIV;
+        case BIN_LT:  return IR_LT;
+        case BIN_LE:  return IR_LE;
+        case BIN_GT:  return IR_GT;
+        case BIN_GE:  return IR_GE;
+        case BIN_EQ:  return IR_EQ;
+        case BIN_NEQ: return IR_NE;
+        default:      return IR_ADD;   /* && e || não passam por aqui */
+    }
+}
 
-        case ND_IDENT: {
-            int t = vt_get(f, e->u.as_ident.name, false, TY_INT, NULL);
-            if (t < 0) {
-                t = vt_get(f, e->u.as_ident.name, true, TY_INT, NULL);
-            }
-            return t;
-        }
+int irb_emit_expr(IrFunc *f, Node *root) {
+    EmitFrame buf[32];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(EmitFrame));
+    emit_push(&stack, root);
 
-        case ND_UNARY:  return emit_unary(f, e);
-        case ND_BINARY: return emit_binary(f, e);
+    int ret = -1;   /* temporário do último quadro encerrado */
 
-        case ND_ASSIGN: {
-            int rv = irb_emit_expr(f, e->u.as_assign.value);
+    while (!ws_empty(&stack)) {
+        EmitFrame *fr = (EmitFrame*)ws_top(&stack);
+        Node *e = fr->e;
 
-            bool created = false;
-            (void)vt_get(f, e->u.as_assign.name, true, TY_INT, &created);
+        /* fr não vale mais depois de emit_push: o estágio é gravado antes */
+        #define CALL(child, next) do { fr->stage = (next); emit_push(&stack, (child)); } while (0)
+        #define RETURN(value)     do { ret = (value); ws_pop(&stack); } while (0)
 
-            for (VarTemp *v = g_vars; v; v = v->next) {
-                if (strcmp(v->name, e->u.as_assign.name) == 0) {
-                    v->temp = rv;
-                    break;
-                }
-            }
+        if (!e) { RETURN(-1); continue; }
 
-            ir_register_local(f, e->u.as_assign.name, rv);
+        switch (e->kind) {
+            case ND_INT:    RETURN(ir_emit_mov(f, ir_int(e->u.as_int.value))); break;
+            case ND_FLOAT:  RETURN(ir_emit_mov(f, ir_float(e->u.as_float.value))); break;
+            case ND_BOOL:   RETURN(ir_emit_mov(f, ir_bool(e->u.as_bool.value))); break;
 
-            return rv;
-        }
+            case ND_STRING:
+                RETURN(ir_emit_mov(f, ir_string(e->u.as_string.id)));
+                break;
 
-        case ND_EXPR:
-            return irb_emit_expr(f, e->u.as_expr.expr);
-
-        case ND_CALL: {
-            size_t argc = e->u.as_call.arg_count;
-            int *argv = NULL;
-            if (argc > 0) {
-                argv = (int*)xmalloc(sizeof(int)*argc);
-                for (size_t i=0;i<argc;i++) {
-                    argv[i] = irb_emit_expr(f, e->u.as_call.args[i]);
-                }
+            case ND_IDENT: {
+                int t = *temp_cell(&e->u.as_ident.ref);
+                if (t < 0) t = lazy_temp(f, &e->u.as_ident.ref, (TypeTag)e->type);
+                RETURN(t);
+                break;
             }
-            /* sem info de tipos de função aqui, assumimos INT por enquanto */
-            int dst = ir_emit_call(f, e->u.as_call.name, argv, argc, TY_INT);
-            if (argv) free(argv);
-            return (dst >= 0 ? dst : -1);
-        }
-
-        default:
-            return -1;
-    }
-}
-
-static int emit_unary(IrFunc *f, Node *n) {
-    int v = irb_emit_expr(f, n->u.as_unary.expr);
-    switch (n->u.as_unary.op) {
-        case UN_NEG: {
-            int z = ir_emit_mov(f, ir_int(0));
-            return emit_bin(f, IR_SUB, z, v); /* 0 - v */
-        }
-        case UN_NOT: {
-            int z = ir_emit_mov(f, ir_int(0));
-            return emit_cmp(f, IR_EQ, v, z);  /* v == 0 */
-        }
-        default:
-            return v;
-    }
-}
-
-static int emit_binary(IrFunc *f, Node *n) {
-    int L = irb_emit_expr(f, n->u.as_binary.left);
-    int R = irb_emit_expr(f, n->u.as_binary.right);
 
-    switch (n->u.as_binary.op) {
-        case BIN_ADD: return emit_bin(f, IR_ADD, L, R);
-        case BIN_SUB: return emit_bin(f, IR_SUB, L, R);
-        case BIN_MUL: return emit_bin(f, IR_MUL, L, R);
-        case BIN_DIV: return emit_bin(f, IR_DIV, L, R);
-
-        case BIN_LT:  return emit_cmp(f, IR_LT,  L, R);
-        case BIN_LE:  return emit_cmp(f, IR_LE,  L, R);
-        case BIN_GT:  return emit_cmp(f, IR_GT,  L, R);
-        case BIN_GE:  return emit_cmp(f, IR_GE,  L, R);
-        case BIN_EQ:  return emit_cmp(f, IR_EQ,  L, R);
-        case BIN_NEQ: return emit_cmp(f, IR_NE,  L, R);
-
-        case BIN_AND: {
-            int Lfalse = ir_new_label(f);
-            int Lend   = ir_new_label(f);
-
-            ir_emit_brfalse(f, ir_temp(L), Lfalse);
-
-            int tR = irb_emit_expr(f, n->u.as_binary.right);
-            int tres = ir_emit_mov(f, ir_temp(tR));
-            ir_emit_br(f, Lend);
+            case ND_UNARY:
+                if (fr->stage == 0) { CALL(e->u.as_unary.expr, 1); break; }
+                switch (e->u.as_unary.op) {
+                    case UN_NEG: {
+                        /* 0 - v, com o zero do tipo de v */
+                        bool fl = ir_temp_type(f, ret) == TY_FLOAT;
+                        int z = ir_emit_mov(f, fl ? ir_float(0.0) : ir_int(0));
+                        RETURN(emit_bin(f, IR_SUB, z, ret));
+                        break;
+                    }
+                    case UN_NOT: {
+                        /* v == false (v == 0 se o tipo não for conhecido) */
+                        bool b = ir_temp_type(f, ret) == TY_BOOL;
+                        int z = ir_emit_mov(f, b ? ir_bool(0) : ir_int(0));
+                        RETURN(emit_cmp(f, IR_EQ, ret, z));
+                        break;
+                    }
+                    default:
+                        RETURN(ret);
+                        break;
+                }
+                break;
+
+            case ND_BINARY: {
+                BinOp op = e->u.as_binary.op;
+                if (fr->stage == 0) { CALL(e->u.as_binary.left, 1); break; }
+                if (fr->stage == 1) { fr->a = ret; CALL(e->u.as_binary.right, 2); break; }
+
+                if (fr->stage == 2) {
+                    int L = fr->a, R = ret;
+                    switch (op) {
+                        case BIN_ADD: case BIN_SUB: case BIN_MUL: case BIN_DIV:
+                            promote(f, op, &L, &R);
+                            RETURN(emit_bin(f, binop_to_ir(op), L, R));
+                            break;
+
+                        case BIN_LT: case BIN_LE: case BIN_GT: case BIN_GE:
+                        case BIN_EQ: case BIN_NEQ:
+                            promote(f, op, &L, &R);
+                            RETURN(emit_cmp(f, binop_to_ir(op), L, R));
+                            break;
+
+                        case BIN_AND: {
+                            int Lfalse = ir_new_label(f);
+                            int Lend   = ir_new_label(f);
+                            ir_emit_brfalse(f, ir_temp(L), Lfalse);
+                            fr->a = Lfalse;
+                            fr->b = Lend;
+                            CALL(e->u.as_binary.right, 3);
+                            break;
+                        }
+
+                        case BIN_OR: {
+                            int Ltrue = ir_new_label(f);
+                            int Lend  = ir_new_label(f);
+                            int Lskip = ir_new_label(f);
+                            ir_emit_brfalse(f, ir_temp(L), Lskip);
+                            ir_emit_br(f, Ltrue);
+                            ir_emit_label(f, Lskip);
+                            fr->a = Ltrue;
+                            fr->b = Lend;
+                            CALL(e->u.as_binary.right, 3);
+                            break;
+                        }
+
+                        default:
+                            RETURN(-1);
+                            break;
+                    }
+                    break;
+                }
 
-            ir_emit_label(f, Lfalse);
-            int z = ir_emit_mov(f, ir_int(0));
-            (void)z;
+                /* estágio 3: lado direito de && / || emitido dentro do desvio */
+                int tres = ir_emit_mov(f, ir_temp(ret));
+                ir_emit_br(f, fr->b);
+                ir_emit_label(f, fr->a);
+                int k = ir_emit_mov(f, ir_int(op == BIN_AND ? 0 : 1));
+                (void)k;
+                ir_emit_label(f, fr->b);
+                RETURN(tres);
+                break;
+            }
 
-            ir_emit_label(f, Lend);
-            return tres;
-        }
+            case ND_ASSIGN: {
+                if (fr->stage == 0) { CALL(e->u.as_assign.value, 1); break; }
+                const VarRef *ref = &e->u.as_assign.ref;
+                int rv = coerce(f, ret, var_type(ref));
+                if (is_outside(ref)) ir_mark_effect(f, IR_FX_WRITES);
 
-        case BIN_OR: {
-            int Ltrue = ir_new_label(f);
-            int Lend  = ir_new_label(f);
+                /* sem valor ainda: reserva o temporário, como um uso */
+                if (*temp_cell(ref) < 0) (void)lazy_temp(f, ref, ir_temp_type(f, rv));
+                *temp_cell(ref) = rv;
 
-            int Lskip = ir_new_label(f);
-            ir_emit_brfalse(f, ir_temp(L), Lskip);
-            ir_emit_br(f, Ltrue);
-            ir_emit_label(f, Lskip);
+                ir_register_local(f, e->u.as_assign.name, rv);
 
-            int tR = irb_emit_expr(f, n->u.as_binary.right);
-            int tres = ir_emit_mov(f, ir_temp(tR));
-            ir_emit_br(f, Lend);
+                RETURN(rv);
+                break;
+            }
 
-            ir_emit_label(f, Ltrue);
-            int one = ir_emit_mov(f, ir_int(1));
-            (void)one;
+            case ND_EXPR:
+                if (fr->stage == 0) { CALL(e->u.as_expr.expr, 1); break; }
+                RETURN(ret);
+                break;
+
+            case ND_CALL: {
+                size_t argc = e->u.as_call.arg_count;
+                if (fr->stage == 1) fr->argv[fr->i++] = ret;
+                else if (argc > 0) fr->argv = (int*)xmalloc(sizeof(int)*argc);
+
+                if (fr->i < argc) { CALL(e->u.as_call.args[fr->i], 1); break; }
+
+                /* argumentos convertidos para os parâmetros; chamada void
+                 * não tem destino (sem assinatura: int, como antes) */
+                const FunSig *sig = resolve_function(g_resolver, e->u.as_call.fn_index);
+                for (size_t i = 0; sig && i < argc && i < sig->param_count; i++)
+                    fr->argv[i] = coerce(f, fr->argv[i], sig->params[i]);
+                TypeTag rt = sig ? sig->ret : (e->type != TY_INVALID ? (TypeTag)e->type : TY_INT);
+                int dst = ir_emit_call(f, e->u.as_call.name, callee_index(e), fr->argv, argc, rt);
+                if (fr->argv) free(fr->argv);
+                RETURN(dst >= 0 ? dst : -1);
+                break;
+            }
 
-            ir_emit_label(f, Lend);
-            return tres;
+            default:
+                RETURN(-1);
+                break;
         }
 
-        default:
-            return -1;
+        #undef CALL
+        #undef RETURN
     }
+
+    ws_free(&stack);
+    return ret;
 }
 
 /* ---------------------------------------------------------
@@ -433,24 +755,20 @@ void irb_emit_stmt(IrFunc *f, Node *s) {
 
         case ND_DECL: {
             const char *name = s->u.as_decl.name;
-            TypeTag type      = s->u.as_decl.type;
+            const VarRef *ref = &s->u.as_decl.ref;
 
-            bool created = false;
-            int t = vt_get(f, name, true, type, &created);
-            (void)t;
+            /* slot novo (inclusive quando esconde outra variável) */
+            TypeTag type = s->u.as_decl.type;
+            int t = ir_new_temp(f);
+            ir_set_temp_type(f, t, type);
+            set_var_type(ref, type);
+            *temp_cell(ref) = t;
 
             ir_register_local(f, name, t);
 
             if (s->u.as_decl.init) {
-                int rv = irb_emit_expr(f, s->u.as_decl.init);
-
-                for (VarTemp *v = g_vars; v; v = v->next) {
-                    if (strcmp(v->name, name) == 0) {
-                        v->temp = rv;
-                        break;
-                    }
-                }
-
+                int rv = coerce(f, irb_emit_expr(f, s->u.as_decl.init), type);
+                *temp_cell(ref) = rv;
                 ir_register_local(f, name, rv);
             }
 
@@ -492,7 +810,7 @@ void irb_emit_stmt(IrFunc *f, Node *s) {
 
         case ND_RETURN:
             if (s->u.as_return.expr) {
-                int v = irb_emit_expr(f, s->u.as_return.expr);
+                int v = coerce(f, irb_emit_expr(f, s->u.as_return.expr), f->ret_type);
                 ir_emit_ret(f, true, ir_temp(v));
             } else {
                 ir_emit_ret(f, false, (IrOperand){ .kind = IR_OPER_NONE });
@@ -530,20 +848,24 @@ void irb_emit_func(IrProgram *p, Node *func_node) {
         }
     }
 
-    VarTemp *global_snapshot = vt_clone_list(g_vars);
-    irb_reset_state(); // Reseta g_vars (escopo local) e o estado do builder (implicitamente feito pelo driver)
-
     // O ir_func_begin (em ir.c) já inicializa temp_count=0 e label_count=0.
     IrFunc *f = ir_func_begin(p, name, ret_type, param_types, param_count);
     if (param_types) free(param_types);
 
-    if (!f) {
-        vt_restore_from(global_snapshot);
-        vt_free_list(global_snapshot);
-        return;
-    }
+    if (!f) return;
+
+    // 2. Resolver a função sozinha, com um estado de slots próprio
+    //    (o da unidade corrente é guardado e restaurado no fim)
+    Resolver *rs = resolve_new();
+    f_node = resolve_stmt(rs, f_node);
 
-    // 2. Criar escopo interno e mapear Parâmetros
+    Unit saved = g_unit;
+    int32_t saved_program_funcs = g_program_funcs;
+    Resolver *saved_resolver = g_resolver;
+    g_program_funcs = 0;    /* índices deste resolvedor, não de p->funcs */
+    g_resolver = rs;
+    g_unit = (Unit){0};
+    g_unit.in_function = true;
 
     // Os parâmetros da função são t0, t1, t2, ...
     for (size_t i = 0; i < param_count; ++i) {
@@ -551,8 +873,9 @@ void irb_emit_func(IrProgram *p, Node *func_node) {
         const char *pname  = param_node->u.as_decl.name;
         int temp_id = (int)i;      /* t0, t1, ... */
 
-        /* registra no map interno (g_vars) */
-        vt_insert_manual(pname, temp_id);
+        *temp_cell(&param_node->u.as_decl.ref) = temp_id;
+        set_var_type(&param_node->u.as_decl.ref, param_node->u.as_decl.type);
+        ir_set_temp_type(f, temp_id, param_node->u.as_decl.type);
 
         /* informa ao IR que existe uma variável local com esse nome/temp */
         ir_register_local(f, pname, temp_id);
@@ -575,9 +898,12 @@ void irb_emit_func(IrProgram *p, Node *func_node) {
         ir_emit_ret(f, false, (IrOperand){ .kind = IR_OPER_NONE });
     }
 
-    // 3. Restaurar estado (escopo global)
-    vt_restore_from(global_snapshot);
-    vt_free_list(global_snapshot);
+    // 3. Restaurar estado (unidade corrente)
+    unit_free(&g_unit);
+    g_unit = saved;
+    g_program_funcs = saved_program_funcs;
+    g_resolver = saved_resolver;
+    resolve_free(rs);
 
     // Finaliza a função IR
     ir_func_end(p, f);
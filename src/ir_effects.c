@@ -0,0 +1,159 @@
+#include "ir_effects.h"
+#include "work_stack.h"
+
+#include <stdlib.h>
+
+/* Função chamada por `ins` (índice em p->funcs); -1 se desconhecida */
+static long callee_of(const IrProgram *p, const IrInstr *ins) {
+    if (ins->op != IR_CALL || ins->callee_index < 0) return -1;
+    return (size_t)ins->callee_index < p->func_count ? ins->callee_index : -1;
+}
+
+static IrEffect own_effect(const IrFunc *f) {
+    if (f->own_effects & IR_FX_WRITES) return IR_EFFECTFUL;
+    if (f->own_effects & IR_FX_READS)  return IR_READONLY;
+    return IR_PURE;
+}
+
+/* =========================================================
+ * Tarjan iterativo
+ *   Um quadro por função na pilha de busca, com a próxima instrução a
+ *   examinar; `index`/`low` como no algoritmo recursivo. Quando a raiz de
+ *   uma componente termina, as componentes que ela chama já estão
+ *   fechadas (com resumo): o resumo dela é o pior entre os efeitos dos
+ *   membros e os das funções chamadas fora da componente.
+ * ========================================================= */
+typedef struct {
+    size_t func;
+    size_t pc;      /* próxima instrução */
+} EffFrame;
+
+typedef struct {
+    IrProgram *p;
+    long      *index;   /* ordem de visita (-1 = não visitada) */
+    long      *low;
+    long      *comp;    /* componente fechada da função (-1 = aberta) */
+    size_t    *members; /* pilha de Tarjan */
+    size_t     member_count;
+    long       next_index;
+    long       comp_count;
+} EffState;
+
+/* Fecha a componente com raiz `root`: desempilha os membros e dá a
+ * todos o mesmo resumo */
+static void close_component(EffState *st, size_t root) {
+    long id = st->comp_count++;
+    size_t first = st->member_count;
+    do {
+        first--;
+        st->comp[st->members[first]] = id;
+    } while (st->members[first] != root);
+
+    IrEffect effect = IR_PURE;
+    for (size_t k = first; k < st->member_count && effect != IR_EFFECTFUL; k++) {
+        const IrFunc *f = st->p->funcs[st->members[k]];
+        IrEffect own = own_effect(f);
+        if (own > effect) effect = own;
+
+        for (size_t i = 0; i < f->code_len && effect != IR_EFFECTFUL; i++) {
+            const IrInstr *ins = &f->code[i];
+            if (ins->op != IR_CALL) continue;
+            long w = callee_of(st->p, ins);
+            IrEffect e = (w < 0) ? IR_EFFECTFUL
+                       : (st->comp[w] == id) ? IR_PURE : st->p->funcs[w]->effect;
+            if (e > effect) effect = e;
+        }
+    }
+
+    for (size_t k = first; k < st->member_count; k++)
+        st->p->funcs[st->members[k]]->effect = effect;
+    st->member_count = first;
+}
+
+static void visit(EffState *st, WorkStack *stack, size_t v) {
+    st->index[v] = st->low[v] = st->next_index++;
+    st->members[st->member_count++] = v;
+    *(EffFrame*)ws_push(stack) = (EffFrame){ v, 0 };
+}
+
+void ir_effects_compute(IrProgram *p) {
+    if (!p || p->func_count == 0) return;
+    size_t n = p->func_count;
+
+    EffState st;
+    st.p = p;
+    st.index   = (long*)xmalloc(n * sizeof(long));
+    st.low     = (long*)xmalloc(n * sizeof(long));
+    st.comp    = (long*)xmalloc(n * sizeof(long));
+    st.members = (size_t*)xmalloc(n * sizeof(size_t));
+    st.member_count = 0;
+    st.next_index = 0;
+    st.comp_count = 0;
+    for (size_t i = 0; i < n; i++) st.index[i] = st.comp[i] = -1;
+
+    EffFrame buf[64];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(EffFrame));
+
+    for (size_t root = 0; root < n; root++) {
+        if (st.index[root] >= 0) continue;
+        visit(&st, &stack, root);
+
+        while (!ws_empty(&stack)) {
+            EffFrame *fr = (EffFrame*)ws_top(&stack);
+            size_t v = fr->func;
+            const IrFunc *f = p->funcs[v];
+
+            /* próxima chamada ainda não visitada */
+            long w = -1;
+            while (fr->pc < f->code_len) {
+                long c = callee_of(p, &f->code[fr->pc++]);
+                if (c < 0) continue;
+                if (st.index[c] < 0) { w = c; break; }
+                if (st.comp[c] < 0 && st.index[c] < st.low[v]) st.low[v] = st.index[c];
+            }
+            if (w >= 0) {
+                visit(&st, &stack, (size_t)w);  /* fr não vale mais */
+                continue;
+            }
+
+            ws_pop(&stack);
+            if (st.low[v] == st.index[v]) close_component(&st, v);
+            if (!ws_empty(&stack)) {
+                size_t parent = ((EffFrame*)ws_top(&stack))->func;
+                if (st.low[v] < st.low[parent]) st.low[parent] = st.low[v];
+            }
+        }
+    }
+
+    ws_free(&stack);
+    free(st.index);
+    free(st.low);
+    free(st.comp);
+    free(st.members);
+}
+
+/* =========================================================
+ * Consultas
+ * ========================================================= */
+IrEffect ir_func_effect(const IrFunc *f) {
+    return f ? f->effect : IR_EFFECTFUL;
+}
+
+IrEffect ir_call_effect(const IrProgram *p, const IrInstr *call) {
+    long w = callee_of(p, call);
+    return w < 0 ? IR_EFFECTFUL : p->funcs[w]->effect;
+}
+
+bool ir_call_removable(const IrProgram *p, const IrInstr *call) {
+    return ir_call_effect(p, call) != IR_EFFECTFUL;
+}
+
+const char *ir_effect_name(IrEffect e) {
+    switch (e) {
+        case IR_PURE:      return "pure";
+        case IR_READONLY:  return "readonly";
+        case IR_EFFECTFUL: return "effectful";
+    }
+    return "?";
+}
@@ -28,7 +28,7 @@ static const char* binop_str(IrOp op) {
     }
 }
 
-static void print_operand(IrOperand o) {
+static void print_operand(const IrProgram *p, IrOperand o) {
     switch (o.kind) {
         case IR_OPER_NONE:  printf("_"); break;
         case IR_OPER_TEMP:  printf("t%d", o.v.temp); break;
@@ -36,11 +36,11 @@ static void print_operand(IrOperand o) {
         case IR_OPER_FLOAT: printf("%g", o.v.f); break;
         case IR_OPER_BOOL:  printf("%s", o.v.b ? "true" : "false"); break;
         case IR_OPER_LABEL: printf("L%d", o.v.label); break;
-        case IR_OPER_STRING:printf("%s", o.v.str ? o.v.str : "<null>"); break;
+        case IR_OPER_STRING:printf("%s", p->strings ? str_pool_get(p->strings, o.v.str) : "<null>"); break;
     }
 }
 
-static void print_instr(const IrInstr *ins) {
+static void print_instr(const IrProgram *p, const IrInstr *ins) {
     switch (ins->op) {
         case IR_LABEL:
             printf("  L%d:\n", ins->label);
@@ -51,33 +51,33 @@ static void print_instr(const IrInstr *ins) {
             break;
 
         case IR_BRFALSE:
-            printf("  brfalse "); print_operand(ins->a);
+            printf("  brfalse "); print_operand(p, ins->a);
             printf(", L%d\n", ins->label);
             break;
 
         case IR_MOV:
             printf("  t%d = mov ", ins->dst);
-            print_operand(ins->a);
+            print_operand(p, ins->a);
             printf("\n");
             break;
 
         case IR_CAST:
             printf("  t%d = cast ", ins->dst);
-            print_operand(ins->a);
+            print_operand(p, ins->a);
             printf(" : %s\n", type_str(ins->cast_to));
             break;
 
         case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV:
             printf("  t%d = %s ", ins->dst, binop_str(ins->op));
-            print_operand(ins->a); printf(", ");
-            print_operand(ins->b); printf("\n");
+            print_operand(p, ins->a); printf(", ");
+            print_operand(p, ins->b); printf("\n");
             break;
 
         case IR_LT: case IR_LE: case IR_GT: case IR_GE:
         case IR_EQ: case IR_NE:
             printf("  t%d = %s ", ins->dst, binop_str(ins->op));
-            print_operand(ins->a); printf(", ");
-            print_operand(ins->b); printf("\n");
+            print_operand(p, ins->a); printf(", ");
+            print_operand(p, ins->b); printf("\n");
             break;
 
         case IR_CALL: {
@@ -96,7 +96,7 @@ static void print_instr(const IrInstr *ins) {
             if (ins->a.kind == IR_OPER_NONE) printf("  ret\n");
             else {
                 printf("  ret ");
-                print_operand(ins->a);
+                print_operand(p, ins->a);
                 printf("\n");
             }
             break;
@@ -120,7 +120,7 @@ void ir_print_program(const IrProgram *p) {
         }
 
         for (size_t j = 0; j < f->code_len; j++) {
-            print_instr(&f->code[j]);
+            print_instr(p, &f->code[j]);
         }
 
         printf("}\n");
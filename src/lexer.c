@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lexer.h"
+#include "lexer_fast.h"
+#include "token_stream.h"
+#include "parser.tab.h"
+#include "ast_base.h"
+
+#ifndef LEXER_FAST_ONLY
+int scanner_lex(YYSTYPE *lval, yyscan_t scanner); /* gerada pelo Flex (YY_DECL) */
+#endif
+
+LexerKind lexer_default_kind(void) {
+#ifdef LEXER_FAST_ONLY
+    return LEXER_FAST;
+#else
+    const char *env = getenv("ASTEROIDS_LEXER");
+    if (env && strcmp(env, "fast") == 0) return LEXER_FAST;
+    return LEXER_FLEX;
+#endif
+}
+
+const char *lexer_kind_name(LexerKind kind) {
+    switch (kind) {
+        case LEXER_FAST:   return "fast";
+        case LEXER_REPLAY: return "replay";
+        default:           return "flex";
+    }
+}
+
+bool lexer_open(ParseContext *ctx) {
+    if (ctx->lexer == LEXER_REPLAY) {
+        ctx->tok_pos = ctx->tok_last = 0;
+        return ctx->tokens != NULL;
+    }
+#ifndef LEXER_FAST_ONLY
+    if (ctx->lexer == LEXER_FLEX) return scanner_open(ctx);
+#endif
+    ctx->lexer = LEXER_FAST;
+    return fast_lexer_open(ctx);
+}
+
+void lexer_close(ParseContext *ctx) {
+    if (ctx->lexer == LEXER_REPLAY) return;  /* o fluxo pertence a quem o criou */
+#ifndef LEXER_FAST_ONLY
+    if (ctx->lexer == LEXER_FLEX) { scanner_close(ctx); return; }
+#endif
+    fast_lexer_close(ctx);
+}
+
+int lexer_next(YYSTYPE *lval, ParseContext *ctx) {
+    if (ctx->lexer == LEXER_REPLAY) return token_stream_next(lval, ctx);
+#ifndef LEXER_FAST_ONLY
+    if (ctx->lexer == LEXER_FLEX) return scanner_lex(lval, ctx->scanner);
+#endif
+    return fast_lex(lval, ctx->fast);
+}
+
+int lexer_line(const ParseContext *ctx) {
+    if (ctx->lexer == LEXER_REPLAY) return (int)token_stream_current(ctx)->line;
+#ifndef LEXER_FAST_ONLY
+    if (ctx->lexer == LEXER_FLEX) return scanner_line(ctx);
+#endif
+    return ctx->fast->line;
+}
+
+const char *lexer_text(const ParseContext *ctx) {
+    if (ctx->lexer == LEXER_REPLAY) {
+        /* só há texto se o fonte também estiver carregado */
+        const TokenRecord *r = token_stream_current(ctx);
+        return (ctx->src.data && r->offset + r->length <= ctx->src.len)
+               ? ctx->src.data + r->offset : NULL;
+    }
+#ifndef LEXER_FAST_ONLY
+    if (ctx->lexer == LEXER_FLEX) return scanner_text(ctx);
+#endif
+    return ctx->fast->tok;
+}
+
+size_t lexer_leng(const ParseContext *ctx) {
+    if (ctx->lexer == LEXER_REPLAY) return token_stream_current(ctx)->length;
+#ifndef LEXER_FAST_ONLY
+    if (ctx->lexer == LEXER_FLEX) return scanner_leng(ctx);
+#endif
+    return ctx->fast->tok_len;
+}
+
+void lexer_unclosed_comment(ParseContext *ctx, int line) {
+    if (ctx->quiet) {
+        ctx->fatal_line = line;
+        return;
+    }
+    fprintf(stderr, "Erro léxico: comentário multilinha não fechado (linha %d)\n", line);
+    exit(1);
+}
+
+/* Decodifica as sequências de escape de um literal de string.
+ * Retorna a quantidade de bytes produzidos (no máximo `len`).
+ */
+static size_t unescape_into(char *dst, const char *text, size_t len) {
+    size_t out = 0;
+    for (size_t i = 0; i < len; i++) {
+        char c = text[i];
+        if (c == '\\' && i + 1 < len) {
+            c = text[++i];
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'v': c = '\v'; break;
+                case '\\': case '\"': case '\'': break;
+                case '0': c = '\0'; break;
+                default:
+                    // Se não for um escape reconhecido, mantém a barra e o caractere
+                    dst[out] = '\\';
+                    out++;
+                    break;
+            }
+        }
+        dst[out++] = c;
+    }
+    return out;
+}
+
+uint32_t scan_string_literal(StrPool *pool, SrcSlice lit) {
+    /* sem escapes: o pool compara (e, se for novo, copia) direto do buffer de entrada */
+    if (!memchr(lit.ptr, '\\', lit.len)) return str_pool_add(pool, lit.ptr, lit.len);
+
+    /* o texto decodificado nunca é maior que o literal */
+    char buf[256];
+    if (lit.len <= sizeof buf) {
+        size_t n = unescape_into(buf, lit.ptr, lit.len);
+        return str_pool_add(pool, buf, n);
+    }
+
+    char *heap = (char*)xmalloc(lit.len);
+    size_t n = unescape_into(heap, lit.ptr, lit.len);
+    uint32_t id = str_pool_add(pool, heap, n);
+    free(heap);
+    return id;
+}
@@ -0,0 +1,432 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lexer_fast.h"
+#include "lexer.h"
+#include "parser.tab.h"
+#include "ast_base.h"
+#include "intern.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAST_LEXER_X86 1
+#endif
+
+/* =========================================================
+ * Núcleos de varredura
+ *   Cada um recebe [p, end) e devolve o primeiro byte que NÃO pertence
+ *   à classe (ou `end`). Os laços SIMD só carregam blocos inteiros
+ *   dentro de [p, end); o resto é tratado pela versão escalar.
+ * ========================================================= */
+
+typedef struct {
+    const char *name;
+    const char *(*span_blank)(const char *p, const char *end);   /* [ \t]*        */
+    const char *(*span_ident)(const char *p, const char *end);   /* [A-Za-z0-9_]* */
+    const char *(*span_digit)(const char *p, const char *end);   /* [0-9]*        */
+    const char *(*find_byte)(const char *p, const char *end, char c);
+    const char *(*find_quote)(const char *p, const char *end);   /* '"' ou '\\'   */
+    size_t      (*count_nl)(const char *p, const char *end);     /* quantos '\n'  */
+} LexOps;
+
+static const unsigned char k_ident_char[256] = {
+    ['0'] = 1, ['1'] = 1, ['2'] = 1, ['3'] = 1, ['4'] = 1,
+    ['5'] = 1, ['6'] = 1, ['7'] = 1, ['8'] = 1, ['9'] = 1,
+    ['A'] = 1, ['B'] = 1, ['C'] = 1, ['D'] = 1, ['E'] = 1, ['F'] = 1, ['G'] = 1,
+    ['H'] = 1, ['I'] = 1, ['J'] = 1, ['K'] = 1, ['L'] = 1, ['M'] = 1, ['N'] = 1,
+    ['O'] = 1, ['P'] = 1, ['Q'] = 1, ['R'] = 1, ['S'] = 1, ['T'] = 1, ['U'] = 1,
+    ['V'] = 1, ['W'] = 1, ['X'] = 1, ['Y'] = 1, ['Z'] = 1,
+    ['a'] = 1, ['b'] = 1, ['c'] = 1, ['d'] = 1, ['e'] = 1, ['f'] = 1, ['g'] = 1,
+    ['h'] = 1, ['i'] = 1, ['j'] = 1, ['k'] = 1, ['l'] = 1, ['m'] = 1, ['n'] = 1,
+    ['o'] = 1, ['p'] = 1, ['q'] = 1, ['r'] = 1, ['s'] = 1, ['t'] = 1, ['u'] = 1,
+    ['v'] = 1, ['w'] = 1, ['x'] = 1, ['y'] = 1, ['z'] = 1,
+    ['_'] = 1,
+};
+
+static inline bool is_digit(unsigned char c) { return (unsigned)(c - '0') < 10u; }
+static inline bool is_ident_start(unsigned char c) { return k_ident_char[c] && !is_digit(c); }
+
+/* ---------- escalar ---------- */
+
+static const char *scalar_span_blank(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+static const char *scalar_span_ident(const char *p, const char *end) {
+    while (p < end && k_ident_char[(unsigned char)*p]) p++;
+    return p;
+}
+
+static const char *scalar_span_digit(const char *p, const char *end) {
+    while (p < end && is_digit((unsigned char)*p)) p++;
+    return p;
+}
+
+static const char *scalar_find_byte(const char *p, const char *end, char c) {
+    const char *q = (const char*)memchr(p, c, (size_t)(end - p));
+    return q ? q : end;
+}
+
+static const char *scalar_find_quote(const char *p, const char *end) {
+    while (p < end && *p != '"' && *p != '\\') p++;
+    return p;
+}
+
+static size_t scalar_count_nl(const char *p, const char *end) {
+    size_t n = 0;
+    for (; p < end; p++) n += (*p == '\n');
+    return n;
+}
+
+static const LexOps k_scalar_ops = {
+    "scalar",
+    scalar_span_blank, scalar_span_ident, scalar_span_digit,
+    scalar_find_byte, scalar_find_quote, scalar_count_nl,
+};
+
+#ifdef FAST_LEXER_X86
+
+/* Gera os núcleos para uma largura de vetor.
+ *   in_range(v, lo, hi): bytes com lo <= v <= hi (sem sinal), via
+ *   min(v - lo, hi - lo) == v - lo. */
+#define DEFINE_SIMD_OPS(PFX, ATTR, W, VEC, LOAD, SET1, CMPEQ, OR, SUB, MINU, MOVEMASK, MASK_T) \
+                                                                                                \
+ATTR static inline VEC PFX##_in_range(VEC v, char lo, char hi) {                                \
+    VEC off = SUB(v, SET1(lo));                                                                 \
+    return CMPEQ(MINU(off, SET1((char)(hi - lo))), off);                                        \
+}                                                                                               \
+                                                                                                \
+ATTR static const char *PFX##_span_blank(const char *p, const char *end) {                      \
+    const VEC sp = SET1(' '), tab = SET1('\t');                                                 \
+    for (; end - p >= W; p += W) {                                                              \
+        VEC v = LOAD((const VEC*)p);                                                            \
+        MASK_T m = (MASK_T)~(unsigned)MOVEMASK(OR(CMPEQ(v, sp), CMPEQ(v, tab)));                \
+        if (m) return p + __builtin_ctz(m);                                                     \
+    }                                                                                           \
+    return scalar_span_blank(p, end);                                                           \
+}                                                                                               \
+                                                                                                \
+ATTR static const char *PFX##_span_ident(const char *p, const char *end) {                      \
+    const VEC lower = SET1(0x20), under = SET1('_');                                            \
+    for (; end - p >= W; p += W) {                                                              \
+        VEC v = LOAD((const VEC*)p);                                                            \
+        VEC ok = OR(PFX##_in_range(OR(v, lower), 'a', 'z'),                                     \
+                    OR(PFX##_in_range(v, '0', '9'), CMPEQ(v, under)));                          \
+        MASK_T m = (MASK_T)~(unsigned)MOVEMASK(ok);                                             \
+        if (m) return p + __builtin_ctz(m);                                                     \
+    }                                                                                           \
+    return scalar_span_ident(p, end);                                                           \
+}                                                                                               \
+                                                                                                \
+ATTR static const char *PFX##_span_digit(const char *p, const char *end) {                      \
+    for (; end - p >= W; p += W) {                                                              \
+        VEC v = LOAD((const VEC*)p);                                                            \
+        MASK_T m = (MASK_T)~(unsigned)MOVEMASK(PFX##_in_range(v, '0', '9'));                    \
+        if (m) return p + __builtin_ctz(m);                                                     \
+    }                                                                                           \
+    return scalar_span_digit(p, end);                                                           \
+}                                                                                               \
+                                                                                                \
+ATTR static const char *PFX##_find_byte(const char *p, const char *end, char c) {               \
+    const VEC needle = SET1(c);                                                                 \
+    for (; end - p >= W; p += W) {                                                              \
+        MASK_T m = (MASK_T)MOVEMASK(CMPEQ(LOAD((const VEC*)p), needle));                        \
+        if (m) return p + __builtin_ctz(m);                                                     \
+    }                                                                                           \
+    return scalar_find_byte(p, end, c);                                                         \
+}                                                                                               \
+                                                                                                \
+ATTR static const char *PFX##_find_quote(const char *p, const char *end) {                      \
+    const VEC quote = SET1('"'), bslash = SET1('\\');                                           \
+    for (; end - p >= W; p += W) {                                                              \
+        VEC v = LOAD((const VEC*)p);                                                            \
+        MASK_T m = (MASK_T)MOVEMASK(OR(CMPEQ(v, quote), CMPEQ(v, bslash)));                     \
+        if (m) return p + __builtin_ctz(m);                                                     \
+    }                                                                                           \
+    return scalar_find_quote(p, end);                                                           \
+}                                                                                               \
+                                                                                                \
+ATTR static size_t PFX##_count_nl(const char *p, const char *end) {                             \
+    const VEC nl = SET1('\n');                                                                  \
+    size_t n = 0;                                                                               \
+    for (; end - p >= W; p += W) {                                                              \
+        n += (size_t)__builtin_popcount((MASK_T)MOVEMASK(CMPEQ(LOAD((const VEC*)p), nl)));      \
+    }                                                                                           \
+    return n + scalar_count_nl(p, end);                                                         \
+}                                                                                               \
+                                                                                                \
+static const LexOps k_##PFX##_ops = {                                                           \
+    #PFX,                                                                                       \
+    PFX##_span_blank, PFX##_span_ident, PFX##_span_digit,                                       \
+    PFX##_find_byte, PFX##_find_quote, PFX##_count_nl,                                          \
+};
+
+#define SSE2_ATTR __attribute__((target("sse2")))
+#define AVX2_ATTR __attribute__((target("avx2")))
+
+DEFINE_SIMD_OPS(sse2, SSE2_ATTR, 16, __m128i, _mm_loadu_si128, _mm_set1_epi8,
+                _mm_cmpeq_epi8, _mm_or_si128, _mm_sub_epi8, _mm_min_epu8,
+                _mm_movemask_epi8, uint16_t)
+
+DEFINE_SIMD_OPS(avx2, AVX2_ATTR, 32, __m256i, _mm256_loadu_si256, _mm256_set1_epi8,
+                _mm256_cmpeq_epi8, _mm256_or_si256, _mm256_sub_epi8, _mm256_min_epu8,
+                _mm256_movemask_epi8, uint32_t)
+
+#endif /* FAST_LEXER_X86 */
+
+/* ---------- escolha da variante (uma vez por processo) ---------- */
+
+static const LexOps *g_ops = &k_scalar_ops;
+static pthread_once_t g_ops_once = PTHREAD_ONCE_INIT;
+
+static void select_ops(void) {
+    const char *force = getenv("ASTEROIDS_SIMD");
+    g_ops = &k_scalar_ops;
+#ifdef FAST_LEXER_X86
+    __builtin_cpu_init();
+    bool has_sse2 = __builtin_cpu_supports("sse2");
+    bool has_avx2 = __builtin_cpu_supports("avx2");
+
+    if (force && strcmp(force, "scalar") == 0) return;
+    if (force && strcmp(force, "sse2") == 0) has_avx2 = false;
+
+    if (has_avx2)      g_ops = &k_avx2_ops;
+    else if (has_sse2) g_ops = &k_sse2_ops;
+#else
+    (void)force;
+#endif
+}
+
+const char *fast_lexer_simd_name(void) {
+    pthread_once(&g_ops_once, select_ops);
+    return g_ops->name;
+}
+
+/* =========================================================
+ * Lexer
+ * ========================================================= */
+
+bool fast_lexer_open(ParseContext *ctx) {
+    pthread_once(&g_ops_once, select_ops);
+
+    FastLexer *lx = (FastLexer*)xmalloc(sizeof(FastLexer));
+    lx->ctx = ctx;
+    lx->cur = ctx->src.data;
+    lx->end = ctx->src.data + ctx->src.len;
+    lx->tok = lx->cur;
+    lx->tok_len = 0;
+    lx->line = 1;
+
+    ctx->fast = lx;
+    ctx->column = 1;
+    return true;
+}
+
+void fast_lexer_close(ParseContext *ctx) {
+    free(ctx->fast);
+    ctx->fast = NULL;
+}
+
+/* Atualiza linha/coluna depois de consumir [p, q), que pode conter '\n'.
+ * A coluna volta a contar do byte seguinte à última quebra de linha,
+ * exatamente como as regras \n / \r\n / . do scanner.l. */
+static void advance_over(FastLexer *lx, const char *p, const char *q) {
+    size_t nl = g_ops->count_nl(p, q);
+    if (nl == 0) {
+        lx->ctx->column += (int)(q - p);
+        return;
+    }
+    lx->line += (int)nl;
+    const char *last = q - 1;
+    while (*last != '\n') last--;
+    lx->ctx->column = 1 + (int)(q - (last + 1));
+}
+
+/* Comentário multilinha a partir de p ("/ *"); devolve o byte após o fecho
+ * (ou o fim da entrada, se não houver fecho) */
+static const char *skip_block_comment(FastLexer *lx, const char *p) {
+    const char *q = p + 2;
+    for (;;) {
+        q = g_ops->find_byte(q, lx->end, '*');
+        if (q + 1 >= lx->end) {
+            advance_over(lx, p, lx->end);
+            lexer_unclosed_comment(lx->ctx, lx->line); /* encerra, exceto em modo quiet */
+            return lx->end;
+        }
+        if (q[1] == '/') break;
+        q++;
+    }
+    q += 2;
+    advance_over(lx, p, q);
+    return q;
+}
+
+/* Literal de string a partir de p ('"'); devolve o byte após a aspa final
+ * ou NULL se não houver um literal válido (mesma regex do scanner.l:
+ * \"([^"\\]|\\.)*\" — a string pode atravessar linhas, mas não uma
+ * barra seguida de quebra de linha). */
+static const char *scan_string(FastLexer *lx, const char *p) {
+    const char *q = p + 1;
+    for (;;) {
+        q = g_ops->find_quote(q, lx->end);
+        if (q >= lx->end) return NULL;
+        if (*q == '"') return q + 1;
+        /* barra invertida: escapa qualquer byte, menos '\n' */
+        if (q + 1 >= lx->end || q[1] == '\n') return NULL;
+        q += 2;
+    }
+}
+
+static int keyword(const char *s, size_t n, YYSTYPE *lval) {
+#define KW(str, tok) if (memcmp(s, str, n) == 0) return tok
+    switch (n) {
+        case 2:
+            KW("if", IF);
+            break;
+        case 3:
+            KW("int", KW_INT);
+            KW("for", FOR);
+            break;
+        case 4:
+            if (memcmp(s, "true", 4) == 0) { lval->boolValue = 1; return BOOL_LIT; }
+            KW("bool", KW_BOOL);
+            KW("else", ELSE);
+            KW("void", KW_VOID);
+            break;
+        case 5:
+            if (memcmp(s, "false", 5) == 0) { lval->boolValue = 0; return BOOL_LIT; }
+            KW("float", KW_FLOAT);
+            KW("while", WHILE);
+            break;
+        case 6:
+            KW("string", KW_STRING);
+            KW("return", RETURN);
+            break;
+        case 8:
+            KW("function", FUNCTION);
+            break;
+    }
+#undef KW
+    return 0;
+}
+
+/* Copia um número para um buffer terminado em '\0' (strtol/strtod) */
+static const char *number_text(char *buf, size_t cap, const char *s, size_t n) {
+    if (n >= cap) n = cap - 1;
+    memcpy(buf, s, n);
+    buf[n] = '\0';
+    return buf;
+}
+
+int fast_lex(YYSTYPE *lval, FastLexer *lx) {
+    ParseContext *ctx = lx->ctx;
+    const LexOps *ops = g_ops;
+    const char *p = lx->cur;
+    const char *end = lx->end;
+
+    /* ---------- espaços, quebras de linha e comentários ---------- */
+    for (;;) {
+        if (p >= end) {
+            lx->cur = lx->tok = p;
+            lx->tok_len = 0;
+            return 0;
+        }
+        char c = *p;
+        if (c == ' ' || c == '\t') {
+            const char *q = ops->span_blank(p + 1, end);
+            ctx->column += (int)(q - p);
+            p = q;
+        } else if (c == '\n') {
+            lx->line++;
+            ctx->column = 1;
+            p++;
+        } else if (c == '\r') {
+            ctx->column = 1;  /* \r\n: o '\n' é tratado na próxima volta */
+            p++;
+        } else if (c == '/' && p + 1 < end && p[1] == '/') {
+            const char *q = ops->find_byte(p + 2, end, '\n');
+            ctx->column += (int)(q - p);
+            p = q;
+        } else if (c == '/' && p + 1 < end && p[1] == '*') {
+            p = skip_block_comment(lx, p);
+        } else {
+            break;
+        }
+    }
+
+    /* ---------- token ---------- */
+    const char *start = p;
+    unsigned char c = (unsigned char)*p;
+    char d = (p + 1 < end) ? p[1] : '\0';
+    int tok;
+
+    if (is_digit(c)) {
+        char num[64];
+        p = ops->span_digit(p + 1, end);
+        if (p + 1 < end && *p == '.' && is_digit((unsigned char)p[1])) {
+            p = ops->span_digit(p + 2, end);
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                const char *e = p + 1;
+                if (e < end && (*e == '+' || *e == '-')) e++;
+                if (e < end && is_digit((unsigned char)*e)) p = ops->span_digit(e + 1, end);
+            }
+            lval->floatValue = strtod(number_text(num, sizeof num, start, (size_t)(p - start)), NULL);
+            tok = FLOAT_LIT;
+        } else {
+            lval->intValue = (int)strtol(number_text(num, sizeof num, start, (size_t)(p - start)), NULL, 10);
+            tok = INT_LIT;
+        }
+    } else if (is_ident_start(c)) {
+        p = ops->span_ident(p + 1, end);
+        size_t n = (size_t)(p - start);
+        tok = keyword(start, n, lval);
+        if (!tok) {
+            /* identificadores: internados direto do buffer de entrada */
+            lval->name = intern(start, n);
+            tok = IDENT;
+        }
+    } else if (c == '"' && (p = scan_string(lx, start)) != NULL) {
+        /* aponta para o buffer de entrada, sem as aspas */
+        lval->slice.ptr = start + 1;
+        lval->slice.len = (size_t)(p - start) - 2;
+        lx->line += (int)ops->count_nl(start, p);
+        tok = STRING_LIT;
+    } else {
+        p = start + 1;
+        switch (c) {
+            case '=': if (d == '=') { p++; tok = EQ; } else tok = ASSIGN; break;
+            case '!': if (d == '=') { p++; tok = NEQ; } else tok = NOT; break;
+            case '<': if (d == '=') { p++; tok = LE; } else tok = LT; break;
+            case '>': if (d == '=') { p++; tok = GE; } else tok = GT; break;
+            case '&': if (d == '&') { p++; tok = AND; } else tok = ERROR; break;
+            case '|': if (d == '|') { p++; tok = OR; } else tok = ERROR; break;
+            case '+': tok = PLUS; break;
+            case '-': tok = MINUS; break;
+            case '*': tok = TIMES; break;
+            case '/': tok = DIVIDE; break;
+            case '(': tok = LPAREN; break;
+            case ')': tok = RPAREN; break;
+            case '{': tok = LBRACE; break;
+            case '}': tok = RBRACE; break;
+            case ',': tok = COMMA; break;
+            case ';': tok = SEMICOLON; break;
+            default:  tok = ERROR; break;
+        }
+        if (tok == ERROR) {
+            /* ---------- Erro léxico (caractere não reconhecido) ---------- */
+            char msg[160];
+            snprintf(msg, sizeof msg, "caractere não reconhecido '%c'", (char)c);
+            lx->tok = start;
+            lx->tok_len = 1;
+            yyerror(ctx, msg);
+        }
+    }
+
+    lx->tok = start;
+    lx->tok_len = (size_t)(p - start);
+    lx->cur = p;
+    ctx->column += (int)lx->tok_len;  /* como o ADVANCE_COLUMN do scanner.l */
+    return tok;
+}
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parse_context.h"
+#include "ast_free.h"
+
+void parse_scratch_push(ParseContext *ctx, Node *node) {
+    if (ctx->scratch_len == ctx->scratch_cap) {
+        ctx->scratch_cap = ctx->scratch_cap ? ctx->scratch_cap * 2 : 16;
+        ctx->scratch = (Node**)realloc(ctx->scratch, ctx->scratch_cap * sizeof(Node*));
+        if (!ctx->scratch) { fprintf(stderr, "Erro de alocação de memória\n"); exit(1); }
+    }
+    ctx->scratch[ctx->scratch_len++] = node;
+}
+
+Node **parse_scratch_take(ParseContext *ctx, size_t mark, size_t *count) {
+    size_t n = ctx->scratch_len - mark;
+    *count = n;
+    if (n == 0) return NULL;
+
+    Node **items = (Node**)ast_alloc(n * sizeof(Node*));
+    memcpy(items, ctx->scratch + mark, n * sizeof(Node*));
+    ctx->scratch_len = mark;
+    return items;
+}
+
+void parse_scratch_release(ParseContext *ctx, size_t mark) {
+    while (ctx->scratch_len > mark) ast_free(ctx->scratch[--ctx->scratch_len]);
+}
+
+void parse_scratch_free(ParseContext *ctx) {
+    parse_scratch_release(ctx, 0);
+    free(ctx->scratch);
+    ctx->scratch = NULL;
+    ctx->scratch_cap = 0;
+}
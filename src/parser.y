@@ -1,44 +1,55 @@
 %{
 #include "ast.h"
+#include "source_buffer.h"
+#include "parse_context.h"
+#include "lexer.h"
 #include <stdio.h>
 #include <stdlib.h>
 
-Node *g_program_ast = NULL;
-int g_parse_errors = 0;
-
-extern int yylineno;
-extern int yycolumn;
-
-int yylex(void);
-
-void yyerror(const char *s) {
-    fprintf(stderr, "Erro sintático (%d:%d): %s\n", yylineno, yycolumn, s);
-    g_parse_errors++;
+void yyerror(ParseContext *ctx, const char *s) {
+    /* Só em modo quiet a análise continua depois de um comentário não
+     * fechado; sem quiet ela termina ali (lexer_unclosed_comment), então
+     * o erro do fim de texto que vem em seguida não conta */
+    if (ctx->fatal_line) return;
+    if (!ctx->quiet)
+        fprintf(stderr, "Erro sintático (%d:%d): %s\n", lexer_line(ctx), ctx->column, s);
+    ctx->errors++;
 }
-
-/* Buffers temporários (parâmetros de função) */
-static Node  **g_params_buf = NULL;
-static size_t  g_params_len = 0;
 %}
 
 %code requires {
   #include "ast_base.h"
+  #include "source_buffer.h"
+  #include "parse_context.h"
+}
+
+%code {
+  /* Flex ou lexer escrito à mão, conforme ctx->lexer (lexer.h) */
+  static int yylex(YYSTYPE *lval, ParseContext *ctx) {
+    return lexer_next(lval, ctx);
+  }
 }
 
+/* Parser reentrante: todo o estado vem de ctx (parse_context.h) */
+%define api.pure full
+%param { ParseContext *ctx }
+
 %union {
     struct Node* node;
     int intValue;
     double floatValue;
     int boolValue;
-    char *str;
+    const char *name;   /* identificador internado (intern.h) */
+    SrcSlice slice;
     TypeTag typeTag;
+    size_t mark;        /* início de uma lista em ctx->scratch */
 }
 
 %token <intValue> INT_LIT
 %token <floatValue> FLOAT_LIT
 %token <boolValue> BOOL_LIT
-%token <str> IDENT
-%token <str> STRING_LIT
+%token <name> IDENT
+%token <slice> STRING_LIT
 
 %token KW_INT
 %token KW_FLOAT
@@ -72,18 +83,25 @@ static size_t  g_params_len = 0;
 %define parse.error verbose
 
 %type <typeTag> TypeTag
-%type <node>    Program StmtList Stmt Block IfStmt WhileStmt ForStmt
-%type <node>    FunctionDef ParamList Param ArgList
+%type <node>    StmtList Stmt Block IfStmt WhileStmt ForStmt
+%type <node>    FunctionDef Param
+%type <mark>    ParamList ArgList
 %type <node>    Expr OrExpr AndExpr EqExpr RelExpr AddExpr MulExpr Unary Primary
 %type <node>    Num AssignExpr
 %type <node>    Decl
 
+/* Símbolos descartados na recuperação de erro: nós são liberados e
+ * listas saem da pilha de rascunho. Program não tem valor, então a
+ * AST aceita (ctx->ast) nunca passa por aqui. */
+%destructor { ast_free($$); } <node>
+%destructor { parse_scratch_release(ctx, $$); } <mark>
+
 %start Program
 
 %%
 
 Program
-    : StmtList                              { g_program_ast = $1; $$ = $1; }
+    : StmtList                              { ctx->ast = $1; }
     ;
 
 StmtList
@@ -103,7 +121,7 @@ Stmt
     | RETURN Expr SEMICOLON                 { $$ = ast_return($2); }
     | SEMICOLON                             { $$ = NULL; }
     | ERROR                                 { yyerrok; $$ = NULL; }  /* consome erro léxico isolado */
-    | error SEMICOLON                       { yyerror("recuperado: instrução inválida"); yyerrok; $$ = NULL; }
+    | error SEMICOLON                       { yyerror(ctx, "recuperado: instrução inválida"); yyerrok; $$ = NULL; }
     ;
 
 Block
@@ -119,8 +137,8 @@ TypeTag
   ;
 
 Decl
-  : TypeTag IDENT ASSIGN Expr SEMICOLON     { $$ = ast_decl($1, $2, $4); free($2); }
-  | TypeTag IDENT SEMICOLON                 { $$ = ast_decl($1, $2, NULL); free($2); }
+  : TypeTag IDENT ASSIGN Expr SEMICOLON     { $$ = ast_decl($1, $2, $4); }
+  | TypeTag IDENT SEMICOLON                 { $$ = ast_decl($1, $2, NULL); }
   ;
 
 IfStmt
@@ -138,38 +156,30 @@ ForStmt
     ;
 
 FunctionDef
-  : TypeTag IDENT LPAREN ParamList RPAREN   {
-                                              Node *plist = $4;
-                                              g_params_len = plist->u.as_block.count;
-                                              if (g_params_len > 0) {
-                                                g_params_buf = (Node**)xmalloc(sizeof(Node*) * g_params_len);
-                                                for (size_t i = 0; i < g_params_len; i++) {
-                                                  g_params_buf[i] = plist->u.as_block.stmts[i];
-                                                }
-                                              } else { g_params_buf = NULL; }
-                                              free(plist->u.as_block.stmts); free(plist);
-                                            }
-                                            Block
+  : TypeTag IDENT LPAREN ParamList RPAREN Block
                                             {
-                                              $$ = ast_function($1, $2, g_params_buf, g_params_len, $7);
-                                              g_params_buf = NULL; g_params_len = 0;
+                                              size_t count;
+                                              Node **params = parse_scratch_take(ctx, $4, &count);
+                                              $$ = ast_function($1, $2, params, count, $6);
                                             }
   ;
 
 Param
-    : TypeTag IDENT                         { $$ = ast_decl($1, $2, NULL); free($2); }
+    : TypeTag IDENT                         { $$ = ast_decl($1, $2, NULL); }
     ;
 
+/* Parâmetros e argumentos vão direto para ctx->scratch; a lista
+ * vale a marca de onde começa (parse_context.h) */
 ParamList
-    : %empty                                { $$ = ast_block(); }
-    | Param                                 { $$ = ast_block(); ast_block_add_stmt($$, $1); }
-    | ParamList COMMA Param                 { ast_block_add_stmt($1, $3); $$ = $1; }
+    : %empty                                { $$ = ctx->scratch_len; }
+    | Param                                 { $$ = ctx->scratch_len; parse_scratch_push(ctx, $1); }
+    | ParamList COMMA Param                 { parse_scratch_push(ctx, $3); $$ = $1; }
     ;
 
 ArgList
-    : %empty                                { $$ = ast_block(); }
-    | Expr                                  { $$ = ast_block(); ast_block_add_stmt($$, ast_expr($1)); }
-    | ArgList COMMA Expr                    { ast_block_add_stmt($1, ast_expr($3)); $$ = $1; }
+    : %empty                                { $$ = ctx->scratch_len; }
+    | Expr                                  { $$ = ctx->scratch_len; parse_scratch_push(ctx, $1); }
+    | ArgList COMMA Expr                    { parse_scratch_push(ctx, $3); $$ = $1; }
     ;
 
 Expr
@@ -178,7 +188,7 @@ Expr
 
 AssignExpr
     : OrExpr
-    | IDENT ASSIGN AssignExpr               { $$ = ast_assign($1, $3); free($1); }
+    | IDENT ASSIGN AssignExpr               { $$ = ast_assign($1, $3); }
     ;
 
 OrExpr
@@ -226,28 +236,13 @@ Unary
 Primary
     : LPAREN Expr RPAREN                    { $$ = $2; }
     | Num                                   { $$ = $1; }
-    | IDENT                                 { $$ = ast_ident($1); free($1); }
+    | IDENT                                 { $$ = ast_ident($1); }
     | IDENT LPAREN ArgList RPAREN           {
-                                              Node *arglist = $3;
-                                              size_t arg_count = arglist->u.as_block.count;
-
-                                              Node **args = NULL;
-                                              if(arg_count > 0) {
-                                                args = (Node**)xmalloc(sizeof(Node*) * arg_count);
-                                                for (size_t i = 0; i < arg_count; i++) {
-                                                  Node *stmt = arglist->u.as_block.stmts[i];
-                                                  args[i] = stmt->u.as_expr.expr;
-                                                  stmt->u.as_expr.expr = NULL;
-                                                }
-                                              }
-
-                                              ast_free(arglist);
-
-                                              $$ = ast_call($1, args, arg_count);
-                                              arglist = NULL; arg_count = 0;
-                                              free($1);
+                                              size_t count;
+                                              Node **args = parse_scratch_take(ctx, $3, &count);
+                                              $$ = ast_call($1, args, count);
                                             }
-    | STRING_LIT                            { $$ = ast_string($1); free($1); }
+    | STRING_LIT                            { $$ = ast_string(ctx->strings, scan_string_literal(ctx->strings, $1)); }
     ;
 
 Num
@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "parser_rd.h"
+#include "lexer.h"
+#include "parser.tab.h"
+#include "ast.h"
+
+/* Mesmo limite padrão do YYMAXDEPTH do Bison */
+#define RD_MAX_DEPTH 10000
+
+/* =========================================================
+ * Estado do parser
+ *   O próximo token só é lido quando alguém olha para ele (peek),
+ *   como o lookahead do Bison: assim as mensagens de erro saem com
+ *   a mesma linha:coluna e na mesma ordem dos erros léxicos.
+ * ========================================================= */
+typedef struct {
+    ParseContext *ctx;
+    int     tok;      /* token de lookahead (válido se have) */
+    YYSTYPE val;
+    bool    have;
+    bool    panic;    /* erro sintático: volta até a instrução mais interna */
+    bool    abort;    /* fim da entrada na recuperação ou aninhamento excessivo */
+    int     rc;
+    int     depth;
+
+    /* Posições no fonte (só com track, ver rd_parse_stmts) */
+    bool    track;
+    size_t  tok_start, tok_end;  /* último token lido */
+    size_t  consumed_end;        /* fim do último token consumido */
+    bool    lex_error;           /* leu um token ERROR */
+    int     peek_errors;         /* erros léxicos do último token lido */
+} Rd;
+
+static int peek(Rd *p) {
+    if (!p->have) {
+        int errors = p->ctx->errors;
+        p->tok = lexer_next(&p->val, p->ctx);
+        p->have = true;
+        if (p->track) {
+            const ParseContext *ctx = p->ctx;
+            p->peek_errors = ctx->errors - errors;
+            if (p->tok == YYEOF) {
+                p->tok_start = p->tok_end = ctx->src.len;
+            } else {
+                p->tok_start = (size_t)(lexer_text(ctx) - ctx->src.data);
+                p->tok_end = p->tok_start + lexer_leng(ctx);
+                if (p->tok == ERROR) p->lex_error = true;
+            }
+        }
+    }
+    return p->tok;
+}
+
+static void advance(Rd *p) {
+    p->have = false;
+    p->consumed_end = p->tok_end;
+}
+
+/* Nomes dos tokens como o Bison os mostra (parse.error verbose) */
+static const char *token_name(int tok) {
+    switch (tok) {
+        case YYEOF:      return "end of file";
+        case INT_LIT:    return "INT_LIT";
+        case FLOAT_LIT:  return "FLOAT_LIT";
+        case BOOL_LIT:   return "BOOL_LIT";
+        case IDENT:      return "IDENT";
+        case STRING_LIT: return "STRING_LIT";
+        case KW_INT:     return "KW_INT";
+        case KW_FLOAT:   return "KW_FLOAT";
+        case KW_BOOL:    return "KW_BOOL";
+        case KW_STRING:  return "KW_STRING";
+        case KW_VOID:    return "KW_VOID";
+        case LPAREN:     return "LPAREN";
+        case RPAREN:     return "RPAREN";
+        case LBRACE:     return "LBRACE";
+        case RBRACE:     return "RBRACE";
+        case PLUS:       return "PLUS";
+        case MINUS:      return "MINUS";
+        case TIMES:      return "TIMES";
+        case DIVIDE:     return "DIVIDE";
+        case EQ:         return "EQ";
+        case NEQ:        return "NEQ";
+        case LT:         return "LT";
+        case GT:         return "GT";
+        case LE:         return "LE";
+        case GE:         return "GE";
+        case AND:        return "AND";
+        case OR:         return "OR";
+        case NOT:        return "NOT";
+        case ASSIGN:     return "ASSIGN";
+        case COMMA:      return "COMMA";
+        case SEMICOLON:  return "SEMICOLON";
+        case IF:         return "IF";
+        case ELSE:       return "ELSE";
+        case WHILE:      return "WHILE";
+        case FOR:        return "FOR";
+        case FUNCTION:   return "FUNCTION";
+        case RETURN:     return "RETURN";
+        case ERROR:      return "ERROR";
+        default:         return "invalid token";
+    }
+}
+
+/* Erro no lookahead atual; `expecting` lista os tokens aceitos quando
+ * o Bison também os listaria (NULL quando são muitos) */
+static void syntax_error(Rd *p, const char *expecting) {
+    char msg[160];
+    if (expecting)
+        snprintf(msg, sizeof msg, "syntax error, unexpected %s, expecting %s",
+                 token_name(peek(p)), expecting);
+    else
+        snprintf(msg, sizeof msg, "syntax error, unexpected %s", token_name(peek(p)));
+    yyerror(p->ctx, msg);
+    p->panic = true;
+}
+
+static bool expect(Rd *p, int tok, const char *name) {
+    if (peek(p) == tok) { advance(p); return true; }
+    syntax_error(p, name);
+    return false;
+}
+
+static bool enter(Rd *p) {
+    if (++p->depth > RD_MAX_DEPTH) {
+        yyerror(p->ctx, "memory exhausted");
+        p->panic = p->abort = true;
+        p->rc = 2;
+        return false;
+    }
+    return true;
+}
+
+static void leave(Rd *p) {
+    p->depth--;
+}
+
+/* Recuperação do Bison (Stmt: error SEMICOLON): descarta tokens até
+ * um ';' e o consome; fim da entrada antes disso aborta a análise */
+static void recover(Rd *p) {
+    if (p->abort) return;
+    while (peek(p) != SEMICOLON) {
+        if (p->tok == YYEOF) { p->abort = true; p->rc = 1; return; }
+        advance(p);
+    }
+    advance(p);
+    yyerror(p->ctx, "recuperado: instrução inválida");
+    p->panic = false;
+}
+
+static bool starts_expr(int tok) {
+    switch (tok) {
+        case IDENT: case INT_LIT: case FLOAT_LIT: case BOOL_LIT: case STRING_LIT:
+        case LPAREN: case NOT: case MINUS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool type_tag(int tok, TypeTag *out) {
+    switch (tok) {
+        case KW_INT:    *out = TY_INT;    return true;
+        case KW_FLOAT:  *out = TY_FLOAT;  return true;
+        case KW_BOOL:   *out = TY_BOOL;   return true;
+        case KW_STRING: *out = TY_STRING; return true;
+        case KW_VOID:   *out = TY_VOID;   return true;
+        default:        return false;
+    }
+}
+
+/* =========================================================
+ * Expressões (Pratt)
+ *   Os níveis OrExpr..MulExpr do parser.y viram uma tabela de
+ *   precedência, todos associativos à esquerda.
+ * ========================================================= */
+
+static Node *parse_expr(Rd *p);
+
+static int binary_prec(int tok, BinOp *op) {
+    switch (tok) {
+        case OR:     *op = BIN_OR;  return 1;
+        case AND:    *op = BIN_AND; return 2;
+        case EQ:     *op = BIN_EQ;  return 3;
+        case NEQ:    *op = BIN_NEQ; return 3;
+        case LT:     *op = BIN_LT;  return 4;
+        case LE:     *op = BIN_LE;  return 4;
+        case GT:     *op = BIN_GT;  return 4;
+        case GE:     *op = BIN_GE;  return 4;
+        case PLUS:   *op = BIN_ADD; return 5;
+        case MINUS:  *op = BIN_SUB; return 5;
+        case TIMES:  *op = BIN_MUL; return 6;
+        case DIVIDE: *op = BIN_DIV; return 6;
+        default:     return 0;
+    }
+}
+
+/* IDENT já consumido: variável ou chamada IDENT ( ArgList ) */
+static Node *parse_ident_tail(Rd *p, const char *name) {
+    if (peek(p) != LPAREN) return ast_ident(name);
+    advance(p);
+
+    /* ArgList: %empty | Expr | ArgList COMMA Expr (aceita "f(, x)");
+     * os argumentos vão para ctx->scratch, como no parser.y */
+    ParseContext *ctx = p->ctx;
+    size_t mark = ctx->scratch_len;
+    if (starts_expr(peek(p))) {
+        Node *e = parse_expr(p);
+        if (!e) return NULL;
+        parse_scratch_push(ctx, e);
+    }
+    while (peek(p) == COMMA) {
+        advance(p);
+        Node *e = parse_expr(p);
+        if (!e) { parse_scratch_release(ctx, mark); return NULL; }
+        parse_scratch_push(ctx, e);
+    }
+    if (!expect(p, RPAREN, "RPAREN or COMMA")) { parse_scratch_release(ctx, mark); return NULL; }
+
+    size_t count;
+    Node **args = parse_scratch_take(ctx, mark, &count);
+    return ast_call(name, args, count);
+}
+
+static Node *parse_unary(Rd *p) {
+    if (!enter(p)) return NULL;
+    Node *n = NULL;
+
+    switch (peek(p)) {
+        case NOT:
+        case MINUS: {
+            UnOp op = p->tok == NOT ? UN_NOT : UN_NEG;
+            advance(p);
+            Node *e = parse_unary(p);
+            if (e) n = ast_unary(op, e);
+            break;
+        }
+        case LPAREN:
+            advance(p);
+            n = parse_expr(p);
+            if (n && !expect(p, RPAREN, "RPAREN")) { ast_free(n); n = NULL; }
+            break;
+        case INT_LIT:    n = ast_int(p->val.intValue);     advance(p); break;
+        case FLOAT_LIT:  n = ast_float(p->val.floatValue); advance(p); break;
+        case BOOL_LIT:   n = ast_bool(p->val.boolValue);   advance(p); break;
+        case STRING_LIT:
+            n = ast_string(p->ctx->strings, scan_string_literal(p->ctx->strings, p->val.slice));
+            advance(p);
+            break;
+        case IDENT: {
+            const char *name = p->val.name;
+            advance(p);
+            n = parse_ident_tail(p, name);
+            break;
+        }
+        default:
+            syntax_error(p, NULL);
+            break;
+    }
+
+    leave(p);
+    return n;
+}
+
+/* Operadores binários com precedência >= min_prec à direita de `left` */
+static Node *parse_binary_rest(Rd *p, Node *left, int min_prec) {
+    BinOp op;
+    int prec;
+    while ((prec = binary_prec(peek(p), &op)) >= min_prec && prec > 0) {
+        advance(p);
+        Node *right = parse_unary(p);
+        if (right) right = parse_binary_rest(p, right, prec + 1);
+        if (!right) { ast_free(left); return NULL; }
+        left = ast_binary(op, left, right);
+    }
+    return left;
+}
+
+/* AssignExpr: IDENT ASSIGN AssignExpr | OrExpr.
+ * Decidir entre as duas exige olhar o token depois do IDENT. */
+static Node *parse_expr(Rd *p) {
+    if (peek(p) != IDENT) {
+        Node *left = parse_unary(p);
+        return left ? parse_binary_rest(p, left, 1) : NULL;
+    }
+
+    const char *name = p->val.name;
+    advance(p);
+    if (peek(p) == ASSIGN) {
+        advance(p);
+        if (!enter(p)) return NULL;
+        Node *value = parse_expr(p);
+        leave(p);
+        return value ? ast_assign(name, value) : NULL;
+    }
+
+    Node *left = parse_ident_tail(p, name);
+    return left ? parse_binary_rest(p, left, 1) : NULL;
+}
+
+/* =========================================================
+ * Instruções (descida recursiva)
+ * ========================================================= */
+
+static Node *parse_stmt(Rd *p);
+
+/* Instruções até `end` (RBRACE ou fim da entrada), sem o delimitador */
+static Node *parse_stmt_list(Rd *p, int end) {
+    Node *list = ast_block();
+    while (peek(p) != end) {
+        if (p->tok == YYEOF) {  /* bloco sem '}' */
+            syntax_error(p, NULL);
+            ast_free(list);
+            return NULL;
+        }
+        Node *s = parse_stmt(p);
+        if (p->panic) { ast_free(list); return NULL; }  /* só após abortar */
+        if (s) ast_block_add_stmt(list, s);
+    }
+    return list;
+}
+
+static Node *parse_block(Rd *p) {
+    if (!expect(p, LBRACE, "LBRACE")) return NULL;
+    /* como no Bison, o bloco ocupa um nível além da instrução ('{' e a
+     * lista ficam na pilha): blocos aninhados esgotam o limite na mesma
+     * profundidade e sem chegar perto do fim da pilha do processo */
+    if (!enter(p)) return NULL;
+    Node *list = parse_stmt_list(p, RBRACE);
+    leave(p);
+    if (!list) return NULL;
+    advance(p);
+    return list;
+}
+
+/* `( Expr )` de if/while */
+static Node *parse_condition(Rd *p) {
+    if (!expect(p, LPAREN, "LPAREN")) return NULL;
+    Node *cond = parse_expr(p);
+    if (cond && !expect(p, RPAREN, "RPAREN")) { ast_free(cond); cond = NULL; }
+    return cond;
+}
+
+/* TypeTag IDENT ( ParamList ) Block, a partir do '(' */
+static Node *parse_function(Rd *p, TypeTag ret, const char *name) {
+    advance(p);
+
+    /* ParamList: %empty | Param | ParamList COMMA Param */
+    ParseContext *ctx = p->ctx;
+    size_t mark = ctx->scratch_len;
+    TypeTag t;
+    bool first = type_tag(peek(p), &t);
+    while (first || peek(p) == COMMA) {
+        if (!first) {
+            advance(p);
+            if (!type_tag(peek(p), &t)) { syntax_error(p, NULL); parse_scratch_release(ctx, mark); return NULL; }
+        }
+        first = false;
+        advance(p);
+        if (peek(p) != IDENT) { syntax_error(p, "IDENT"); parse_scratch_release(ctx, mark); return NULL; }
+        parse_scratch_push(ctx, ast_decl(t, p->val.name, NULL));
+        advance(p);
+    }
+    if (!expect(p, RPAREN, "RPAREN or COMMA")) { parse_scratch_release(ctx, mark); return NULL; }
+
+    /* os parâmetros ficam na pilha durante o corpo: funções e chamadas
+     * aninhadas empilham e desempilham acima deles */
+    Node *body = parse_block(p);
+    if (!body) { parse_scratch_release(ctx, mark); return NULL; }
+
+    size_t count;
+    Node **params = parse_scratch_take(ctx, mark, &count);
+    return ast_function(ret, name, params, count, body);
+}
+
+/* Decl ou FunctionDef: os dois começam com TypeTag IDENT */
+static Node *parse_decl(Rd *p, TypeTag type) {
+    advance(p);
+    if (peek(p) != IDENT) { syntax_error(p, "IDENT"); return NULL; }
+    const char *name = p->val.name;
+    advance(p);
+
+    switch (peek(p)) {
+        case SEMICOLON:
+            advance(p);
+            return ast_decl(type, name, NULL);
+        case ASSIGN: {
+            advance(p);
+            Node *init = parse_expr(p);
+            if (!init) return NULL;
+            if (!expect(p, SEMICOLON, "SEMICOLON")) { ast_free(init); return NULL; }
+            return ast_decl(type, name, init);
+        }
+        case LPAREN:
+            return parse_function(p, type, name);
+        default:
+            syntax_error(p, "LPAREN or ASSIGN or SEMICOLON");
+            return NULL;
+    }
+}
+
+static Node *parse_stmt_inner(Rd *p) {
+    TypeTag type;
+    if (type_tag(peek(p), &type)) return parse_decl(p, type);
+
+    switch (p->tok) {
+        case SEMICOLON:
+        case ERROR:       /* erro léxico isolado: já reportado pelo scanner */
+            advance(p);
+            return NULL;
+
+        case LBRACE:
+            return parse_block(p);
+
+        case IF: {
+            advance(p);
+            Node *cond = parse_condition(p);
+            if (!cond) return NULL;
+            Node *then_branch = parse_stmt(p);
+            if (p->panic) { ast_free(cond); return NULL; }
+            Node *else_branch = NULL;
+            if (peek(p) == ELSE) {  /* o else fica com o if mais próximo */
+                advance(p);
+                else_branch = parse_stmt(p);
+                if (p->panic) { ast_free(cond); ast_free(then_branch); return NULL; }
+            }
+            return ast_if(cond, then_branch, else_branch);
+        }
+
+        case WHILE: {
+            advance(p);
+            Node *cond = parse_condition(p);
+            if (!cond) return NULL;
+            Node *body = parse_stmt(p);
+            if (p->panic) { ast_free(cond); return NULL; }
+            return ast_while(cond, body);
+        }
+
+        case FOR: {
+            advance(p);
+            Node *parts[3] = { NULL, NULL, NULL };
+            static const int seps[3] = { SEMICOLON, SEMICOLON, RPAREN };
+            static const char *const sep_names[3] = { "SEMICOLON", "SEMICOLON", "RPAREN" };
+            bool ok = expect(p, LPAREN, "LPAREN");
+            for (int i = 0; ok && i < 3; i++) {
+                parts[i] = parse_expr(p);
+                ok = parts[i] && expect(p, seps[i], sep_names[i]);
+            }
+            Node *body = ok ? parse_stmt(p) : NULL;
+            if (!ok || p->panic) {
+                for (int i = 0; i < 3; i++) ast_free(parts[i]);
+                return NULL;
+            }
+            return ast_for(parts[0], parts[1], parts[2], body);
+        }
+
+        case RETURN: {
+            advance(p);
+            if (peek(p) == SEMICOLON) { advance(p); return ast_return(NULL); }
+            Node *e = parse_expr(p);
+            if (!e) return NULL;
+            if (!expect(p, SEMICOLON, "SEMICOLON")) { ast_free(e); return NULL; }
+            return ast_return(e);
+        }
+
+        default: {
+            Node *e = parse_expr(p);
+            if (!e) return NULL;
+            if (!expect(p, SEMICOLON, "SEMICOLON")) { ast_free(e); return NULL; }
+            return ast_expr(e);
+        }
+    }
+}
+
+/* Uma instrução; NULL para ';' isolado ou instrução inválida.
+ * Um erro dentro dela é recuperado aqui, na instrução mais interna,
+ * que é onde o Bison desempilha até achar `Stmt: error SEMICOLON`. */
+static Node *parse_stmt(Rd *p) {
+    if (!enter(p)) return NULL;
+    Node *s = parse_stmt_inner(p);
+    leave(p);
+    if (p->panic) {
+        ast_free(s);
+        recover(p);
+        return NULL;
+    }
+    return s;
+}
+
+int rd_parse_stmts(ParseContext *ctx, RdStmtFn fn, void *user) {
+    Rd p = { .ctx = ctx, .track = true };
+
+    while (peek(&p) != YYEOF) {
+        RdStmt st;
+        /* O erro léxico de um token conta para a instrução que começa
+         * nele, não para a anterior que só o leu como lookahead */
+        int errors = ctx->errors - p.peek_errors;
+        st.start = p.tok_start;
+        p.lex_error = p.tok == ERROR;
+
+        st.node = parse_stmt(&p);
+        st.end = p.abort ? ctx->src.len : p.consumed_end;
+        st.scan_end = p.tok_end;
+        st.errors = ctx->errors - (p.have ? p.peek_errors : 0) - errors;
+        st.lex_error = p.lex_error;
+
+        bool go_on = fn(&st, user);
+        if (p.abort) return p.rc;
+        if (!go_on) break;
+    }
+    return 0;
+}
+
+int rd_parse(ParseContext *ctx) {
+    Rd p = { .ctx = ctx };
+
+    Node *program = parse_stmt_list(&p, YYEOF);
+    if (!program) return p.rc ? p.rc : 1;
+
+    ctx->ast = program;
+    return 0;
+}
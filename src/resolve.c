@@ -0,0 +1,396 @@
+#include "resolve.h"
+#include "arena.h"
+#include "intern.h"
+#include "work_stack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* =========================================================
+ * Vínculos visíveis (pilha plana + registro de desfazer)
+ *   Todos os vínculos ficam num único array, na ordem de declaração;
+ *   `innermost[intern_id(nome)]` aponta para o mais interno do nome e
+ *   cada vínculo guarda o que ele esconde. Sair de um escopo desfaz os
+ *   vínculos posteriores à marca de entrada.
+ * ========================================================= */
+typedef struct {
+    const char *name;
+    int32_t     slot;
+    uint32_t    depth;      /* escopo em que foi declarado */
+    uint32_t    shadowed;   /* vínculo escondido + 1 (0 = nenhum) */
+    uint8_t     flags;      /* VAR_GLOBAL, VAR_UNDECLARED */
+} Bound;
+
+typedef struct {
+    FunSig   sig;
+    uint32_t hidden;            /* definição anterior do nome + 1 (0 = nenhuma) */
+} FunEntry;
+
+struct Resolver {
+    Bound    *binds;
+    size_t    count;
+    size_t    cap;
+    uint32_t *innermost;        /* por intern_id: índice em binds + 1 */
+    size_t    innermost_cap;
+    uint32_t  depth;            /* 0 = escopo do programa */
+
+    bool      in_function;
+    int32_t   global_slots;     /* próximos slots de cada unidade */
+    int32_t   local_slots;
+    int32_t   last_local_count;
+
+    FunEntry *funs;             /* registro de funções, pelo índice */
+    size_t    fun_count;
+    size_t    fun_cap;
+    uint32_t *fun_of;           /* por intern_id: índice em funs + 1 */
+    size_t    fun_of_cap;
+
+    bool      shared;           /* a instrução usa um nó compartilhado */
+    bool      keep_copies;      /* não esvazia a arena a cada instrução */
+    Arena    *arena;            /* cópia dessas instruções */
+};
+
+Resolver *resolve_new(void) {
+    Resolver *rs = (Resolver*)xmalloc(sizeof(Resolver));
+    memset(rs, 0, sizeof *rs);
+    return rs;
+}
+
+void resolve_free(Resolver *rs) {
+    if (!rs) return;
+    free(rs->binds);
+    free(rs->innermost);
+    for (size_t i = 0; i < rs->fun_count; i++) free(rs->funs[i].sig.params);
+    free(rs->funs);
+    free(rs->fun_of);
+    if (rs->arena) arena_free(rs->arena);
+    free(rs);
+}
+
+void resolve_keep_copies(Resolver *rs, bool keep) {
+    rs->keep_copies = keep;
+}
+
+int32_t resolve_global_count(const Resolver *rs) {
+    return rs->global_slots;
+}
+
+int32_t resolve_local_count(const Resolver *rs) {
+    return rs->last_local_count;
+}
+
+/* Garante `(*map)[id]` (mapas por intern_id, zerados) */
+static void reserve_id(uint32_t **map, size_t *cap, uint32_t id) {
+    if (id < *cap) return;
+    size_t n = intern_count() > id ? intern_count() : (size_t)id + 1;
+    *map = (uint32_t*)realloc(*map, n * sizeof(uint32_t));
+    if (!*map) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    memset(*map + *cap, 0, (n - *cap) * sizeof(uint32_t));
+    *cap = n;
+}
+
+static const Bound *innermost(const Resolver *rs, const char *name) {
+    uint32_t id = intern_id(name);
+    if (id >= rs->innermost_cap || rs->innermost[id] == 0) return NULL;
+    return &rs->binds[rs->innermost[id] - 1];
+}
+
+static VarRef ref_of(const Bound *b) {
+    return (VarRef){ b->slot, b->flags };
+}
+
+/* Vínculo novo no escopo corrente, com o próximo slot da unidade */
+static const Bound *bind(Resolver *rs, const char *name, uint8_t flags) {
+    uint32_t id = intern_id(name);
+    reserve_id(&rs->innermost, &rs->innermost_cap, id);
+    if (rs->count == rs->cap) {
+        rs->cap = rs->cap ? rs->cap * 2 : 64;
+        rs->binds = (Bound*)realloc(rs->binds, rs->cap * sizeof(Bound));
+        if (!rs->binds) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    }
+
+    if (!rs->in_function) flags |= VAR_GLOBAL;
+    Bound *b = &rs->binds[rs->count++];
+    b->name = name;
+    b->slot = rs->in_function ? rs->local_slots++ : rs->global_slots++;
+    b->depth = rs->depth;
+    b->shadowed = rs->innermost[id];
+    b->flags = flags;
+    rs->innermost[id] = (uint32_t)rs->count;
+    return b;
+}
+
+static void unwind(Resolver *rs, size_t mark) {
+    while (rs->count > mark) {
+        const Bound *b = &rs->binds[--rs->count];
+        rs->innermost[intern_id(b->name)] = b->shadowed;
+    }
+}
+
+static size_t enter_scope(Resolver *rs) {
+    rs->depth++;
+    return rs->count;
+}
+
+static void leave_scope(Resolver *rs, size_t mark) {
+    unwind(rs, mark);
+    rs->depth--;
+}
+
+/* Uso de um nome; `out` é NULL se o nó for compartilhado (não é anotado) */
+static void use(Resolver *rs, const char *name, VarRef *out) {
+    const Bound *b = innermost(rs, name);
+    if (!b) b = bind(rs, name, VAR_UNDECLARED);
+    if (out) *out = ref_of(b);
+    else rs->shared = true;
+}
+
+static void declare(Resolver *rs, Node *decl, bool param) {
+    const char *name = decl->u.as_decl.name;
+    const Bound *prev = innermost(rs, name);
+    bool declared = prev && !(prev->flags & VAR_UNDECLARED);
+
+    /* como na análise semântica, a redeclaração não substitui a primeira
+     * (parâmetros repetidos substituem) */
+    if (declared && prev->depth == rs->depth && !param) {
+        decl->u.as_decl.ref = ref_of(prev);
+        decl->u.as_decl.ref.flags |= VAR_REDECLARED;
+        return;
+    }
+    decl->u.as_decl.ref = ref_of(bind(rs, name, declared ? VAR_SHADOWS : 0));
+}
+
+/* =========================================================
+ * Registro de funções
+ *   Assinaturas num array (a posição é o índice da função) e
+ *   `fun_of[intern_id(nome)]` com a definição que as chamadas usam.
+ *   Funções não têm escopo: registrada, vale até o fim do programa.
+ * ========================================================= */
+/* Entrada nova para `name`; os tipos dos parâmetros ficam para quem chama */
+static FunSig *register_function(Resolver *rs, const char *name, TypeTag ret, size_t n) {
+    if (rs->fun_count == rs->fun_cap) {
+        rs->fun_cap = rs->fun_cap ? rs->fun_cap * 2 : 16;
+        rs->funs = (FunEntry*)realloc(rs->funs, rs->fun_cap * sizeof(FunEntry));
+        if (!rs->funs) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    }
+
+    FunEntry *e = &rs->funs[rs->fun_count++];
+    e->sig.name = name;
+    e->sig.ret = ret;
+    e->sig.param_count = n;
+    e->sig.params = n ? (TypeTag*)xmalloc(n * sizeof(TypeTag)) : NULL;
+
+    uint32_t id = intern_id(name);
+    reserve_id(&rs->fun_of, &rs->fun_of_cap, id);
+    e->hidden = rs->fun_of[id];
+    rs->fun_of[id] = (uint32_t)rs->fun_count;
+    return &e->sig;
+}
+
+static void register_node(Resolver *rs, const Node *fn) {
+    size_t n = fn->u.as_function.param_count;
+    FunSig *sig = register_function(rs, fn->u.as_function.name, fn->u.as_function.ret_type, n);
+    for (size_t i = 0; i < n; i++)
+        sig->params[i] = fn->u.as_function.params[i]->u.as_decl.type;
+}
+
+/* Desfaz os registros posteriores a `mark` */
+static void unregister_functions(Resolver *rs, size_t mark) {
+    while (rs->fun_count > mark) {
+        FunEntry *e = &rs->funs[--rs->fun_count];
+        rs->fun_of[intern_id(e->sig.name)] = e->hidden;
+        free(e->sig.params);
+    }
+}
+
+static int32_t function_index(const Resolver *rs, const char *name) {
+    uint32_t id = intern_id(name);
+    if (id >= rs->fun_of_cap || rs->fun_of[id] == 0) return FN_UNRESOLVED;
+    return (int32_t)rs->fun_of[id] - 1;
+}
+
+void resolve_declare_functions(Resolver *rs, const Node *root) {
+    if (!root || root->kind != ND_BLOCK) return;
+    for (size_t i = 0; i < root->u.as_block.count; i++) {
+        const Node *stmt = root->u.as_block.stmts[i];
+        if (stmt && stmt->kind == ND_FUNCTION) register_node(rs, stmt);
+    }
+}
+
+void resolve_declare_functions_compact(Resolver *rs, const CompactAst *ast) {
+    if (!ast || ast->root == CAST_NONE || cast_kind(ast, ast->root) != ND_BLOCK) return;
+    CList top = *cast_block(ast, ast->root);
+    for (uint32_t i = 0; i < top.count; i++) {
+        CNode n = cast_list_at(ast, top, i);
+        if (cast_kind(ast, n) != ND_FUNCTION) continue;
+
+        /* direto dos registros compactos, sem montar o corpo */
+        const CFunction *fn = cast_function(ast, n);
+        FunSig *sig = register_function(rs, cast_name(ast, fn->name), fn->ret_type, fn->params.count);
+        for (uint32_t j = 0; j < fn->params.count; j++)
+            sig->params[j] = cast_decl(ast, cast_list_at(ast, fn->params, j))->type;
+    }
+}
+
+const FunSig *resolve_function(const Resolver *rs, int32_t index) {
+    if (index < 0 || (size_t)index >= rs->fun_count) return NULL;
+    return &rs->funs[index].sig;
+}
+
+int32_t resolve_function_count(const Resolver *rs) {
+    return (int32_t)rs->fun_count;
+}
+
+/* =========================================================
+ * Travessia
+ *   Expressões com pilha explícita (profundidade qualquer); a ordem
+ *   não importa, porque expressões não declaram nada. Statements
+ *   recursivos, como check_stmt.
+ * ========================================================= */
+static void resolve_expr(Resolver *rs, Node *root) {
+    Node *buf[64];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(Node*));
+    if (root) *(Node**)ws_push(&stack) = root;
+
+    while (!ws_empty(&stack)) {
+        Node *n = *(Node**)ws_top(&stack);
+        ws_pop(&stack);
+
+        #define PUSH(child) do { if (child) *(Node**)ws_push(&stack) = (child); } while (0)
+        switch (n->kind) {
+            case ND_IDENT:
+                use(rs, n->u.as_ident.name, (n->flags & NODE_SHARED) ? NULL : &n->u.as_ident.ref);
+                break;
+
+            case ND_ASSIGN:
+                use(rs, n->u.as_assign.name, &n->u.as_assign.ref);
+                PUSH(n->u.as_assign.value);
+                break;
+
+            case ND_UNARY:
+                PUSH(n->u.as_unary.expr);
+                break;
+
+            case ND_BINARY:
+                PUSH(n->u.as_binary.right);
+                PUSH(n->u.as_binary.left);
+                break;
+
+            case ND_CALL:
+                if (n->flags & NODE_SHARED) rs->shared = true;
+                else n->u.as_call.fn_index = function_index(rs, n->u.as_call.name);
+                for (size_t i = n->u.as_call.arg_count; i-- > 0; )
+                    PUSH(n->u.as_call.args[i]);
+                break;
+
+            case ND_EXPR:
+                PUSH(n->u.as_expr.expr);
+                break;
+
+            default:
+                break;
+        }
+        #undef PUSH
+    }
+
+    ws_free(&stack);
+}
+
+static void resolve_any(Resolver *rs, Node *s);
+
+static void resolve_function_body(Resolver *rs, Node *fn) {
+    bool outer_function = rs->in_function;
+    int32_t outer_slots = rs->local_slots;
+    rs->in_function = true;
+    rs->local_slots = 0;
+
+    size_t mark = enter_scope(rs);
+    for (size_t i = 0; i < fn->u.as_function.param_count; i++)
+        declare(rs, fn->u.as_function.params[i], true);
+    resolve_any(rs, fn->u.as_function.body);
+    leave_scope(rs, mark);
+
+    if (rs->local_slots > rs->last_local_count) rs->last_local_count = rs->local_slots;
+    rs->in_function = outer_function;
+    rs->local_slots = outer_slots;
+}
+
+static void resolve_any(Resolver *rs, Node *s) {
+    if (!s) return;
+    switch (s->kind) {
+        case ND_BLOCK: {
+            size_t mark = enter_scope(rs);
+            for (size_t i = 0; i < s->u.as_block.count; i++)
+                resolve_any(rs, s->u.as_block.stmts[i]);
+            leave_scope(rs, mark);
+            break;
+        }
+
+        case ND_DECL:
+            resolve_expr(rs, s->u.as_decl.init);
+            declare(rs, s, false);
+            break;
+
+        case ND_IF:
+            resolve_expr(rs, s->u.as_if.cond);
+            resolve_any(rs, s->u.as_if.then_branch);
+            resolve_any(rs, s->u.as_if.else_branch);
+            break;
+
+        case ND_WHILE:
+            resolve_expr(rs, s->u.as_while.cond);
+            resolve_any(rs, s->u.as_while.body);
+            break;
+
+        case ND_FOR:
+            /* sem escopo próprio: o init vale depois do for (check_for) */
+            resolve_any(rs, s->u.as_for.init);
+            resolve_expr(rs, s->u.as_for.cond);
+            resolve_any(rs, s->u.as_for.step);
+            resolve_any(rs, s->u.as_for.body);
+            break;
+
+        case ND_RETURN:
+            resolve_expr(rs, s->u.as_return.expr);
+            break;
+
+        case ND_FUNCTION:
+            /* as de nível superior já vêm do pré-passo; a função fica
+             * visível no próprio corpo (recursão) */
+            if (rs->depth > 0 || rs->in_function ||
+                function_index(rs, s->u.as_function.name) == FN_UNRESOLVED)
+                register_node(rs, s);
+            resolve_function_body(rs, s);
+            break;
+
+        default:    /* ND_ASSIGN, ND_EXPR e expressões soltas */
+            resolve_expr(rs, s);
+            break;
+    }
+}
+
+Node *resolve_stmt(Resolver *rs, Node *stmt) {
+    size_t mark = rs->count;
+    size_t funs = rs->fun_count;
+    int32_t globals = rs->global_slots;
+
+    rs->shared = false;
+    rs->last_local_count = 0;
+    resolve_any(rs, stmt);
+    if (!rs->shared) return stmt;
+
+    /* identificador ou chamada compartilhados: desfaz e resolve uma
+     * cópia sem compartilhamento (fora da arena da tabela, ast_copy
+     * copia tudo) */
+    unwind(rs, mark);
+    unregister_functions(rs, funs);
+    rs->global_slots = globals;
+    if (!rs->arena) rs->arena = arena_new();
+    if (!rs->keep_copies) arena_reset(rs->arena);
+    stmt = ast_copy_to(rs->arena, stmt);
+    rs->last_local_count = 0;
+    resolve_any(rs, stmt);
+    return stmt;
+}
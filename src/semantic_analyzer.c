@@ -1,8 +1,14 @@
 #include "semantic_analyzer.h"
+#include "ast_compact.h"
+#include "arena.h"
+#include "work_stack.h"
+#include "resolve.h"
+#include "work_pool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdarg.h>
 
 /* =========================================================
  * Protótipos (para resolver ordem de chamadas internas)
@@ -14,146 +20,153 @@ static TypeTag infer      (Node *n, int *errors);
 
 
 /* =========================================================
- * Estado de escopos (pilha encadeada)
- *    - push_scope_new    : cria escopo novo "filho" do atual
- *    - push_scope_with   : empilha escopo usando uma tabela já existente
- *    - pop_scope         : desempilha (e destrói se 'owns' == 1)
+ * Tipos das variáveis, por slot (resolve.h)
+ *    - Cada instrução de nível superior passa pela resolução de nomes
+ *      antes de ser verificada: declarações, identificadores e
+ *      atribuições chegam com o slot da variável, e o tipo dela é um
+ *      acesso indexado (g_global_types ou g_local_types, da função);
+ *    - As declarações do escopo do programa também vão para a tabela
+ *      (SymbolTable) recebida pela API;
+ *    - O estado de quem verifica um corpo de função (tipos das locais,
+ *      profundidade de bloco, pilha de retorno, diagnósticos) é por
+ *      thread: na verificação paralela cada thread do pool tem o seu.
  * ========================================================= */
-typedef struct Scope {
-    SymbolTable *tab;
-    struct Scope *parent;
-    int owns; /* 1: destruir tab ao sair; 0: não destruir (tabela injetada) */
-} Scope;
+typedef struct {
+    TypeTag *items;
+    size_t   cap;
+} SlotTypes;
+
+static SymbolTable *g_table = NULL;
+static SlotTypes    g_global_types = { NULL, 0 };
+static _Thread_local SlotTypes g_local_types = { NULL, 0 };
+static _Thread_local int       g_block_depth = 0;   /* 0 = escopo do programa */
+
+static void slot_types_reserve(SlotTypes *st, int32_t count) {
+    if ((size_t)count <= st->cap) return;
+    size_t cap = st->cap ? st->cap : 64;
+    while (cap < (size_t)count) cap *= 2;
+    st->items = (TypeTag*)realloc(st->items, cap * sizeof(TypeTag));
+    if (!st->items) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    st->cap = cap;
+}
+
+static TypeTag *slot_type(const VarRef *ref) {
+    return (ref->flags & VAR_GLOBAL) ? &g_global_types.items[ref->slot]
+                                     : &g_local_types.items[ref->slot];
+}
+
+static void declare(Node *decl) {
+    *slot_type(&decl->u.as_decl.ref) = decl->u.as_decl.type;
+    if (g_block_depth == 0 && g_table)
+        (void)st_insert(g_table, decl->u.as_decl.name, decl->u.as_decl.type, NULL);
+}
 
-static Scope *g_scope = NULL;
+/* Tipo da variável de um IDENT/ASSIGN; 0 se o nome não foi declarado */
+static int lookup_type(const VarRef *ref, TypeTag *out) {
+    if (ref->slot == VAR_UNRESOLVED || (ref->flags & VAR_UNDECLARED)) return 0;
+    if (out) *out = *slot_type(ref);
+    return 1;
+}
+
+/* Reserva os tipos dos slots da última instrução resolvida */
+static void reserve_slots(Resolver *rs) {
+    slot_types_reserve(&g_global_types, resolve_global_count(rs));
+    slot_types_reserve(&g_local_types, resolve_local_count(rs));
+}
 
-static void push_scope_new(void) {
-    Scope *s = (Scope*)malloc(sizeof(Scope));
-    s->tab = st_create();
-    s->tab->parent = g_scope ? g_scope->tab : NULL;
-    s->parent = g_scope;
-    s->owns = 1;
-    g_scope = s;
+/* Resolve a próxima instrução de nível superior e reserva os tipos dos
+ * slots que ela usa */
+static Node *resolve_top(Resolver *rs, Node *stmt) {
+    stmt = resolve_stmt(rs, stmt);
+    reserve_slots(rs);
+    return stmt;
 }
 
-static void push_scope_with(SymbolTable *tab) {
-    Scope *s = (Scope*)malloc(sizeof(Scope));
-    s->tab = tab;
-    s->parent = g_scope;
-    s->owns = 0;
-    g_scope = s;
+static void local_types_release(void) {
+    free(g_local_types.items);
+    g_local_types = (SlotTypes){ NULL, 0 };
 }
 
-static void pop_scope(void) {
-    if (!g_scope) return;
-    Scope *old = g_scope;
-    g_scope = g_scope->parent;
-    if (old->owns) st_destroy(old->tab);
-    free(old);
+static void slot_types_release(void) {
+    free(g_global_types.items);
+    g_global_types = (SlotTypes){ NULL, 0 };
+    local_types_release();
+    g_table = NULL;
 }
 
 /* =========================================================
- * Helpers de escopo/lookup
- *    - exists_local : verifica redeclaração apenas no escopo atual
- *    - lookup_type  : procura tipo de IDENT subindo a cadeia de escopos
+ * Diagnósticos
+ *    - Direto no stderr, ou no buffer da instrução de nível superior
+ *      sendo verificada (verificação paralela), que é impresso depois
+ *      na ordem do fonte.
  * ========================================================= */
-static bool exists_local(const char *name) {
-    if (!g_scope || !g_scope->tab) return false;
-    SymbolTable *t = g_scope->tab;
-    SymbolTable *saved_parent = t->parent;
-    t->parent = NULL;
-    bool found = false;
-    (void)st_lookup_type_recursive(t, name, &found);
-    t->parent = saved_parent;
-    return found;
-}
-
-static int lookup_type(const char *name, TypeTag *out) {
-    for (Scope *s = g_scope; s; s = s->parent) {
-        bool ok = false;
-        TypeTag t = st_lookup_type_recursive(s->tab, name, &ok);
-        if (ok) { if (out) *out = t; return 1; }
+typedef struct {
+    char  *data;
+    size_t len;
+    size_t cap;
+} DiagBuf;
+
+static _Thread_local DiagBuf *g_diag = NULL;   /* NULL = stderr */
+
+static void diag(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    if (!g_diag) {
+        vfprintf(stderr, fmt, ap);
+        va_end(ap);
+        return;
+    }
+
+    va_list again;
+    va_copy(again, ap);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        DiagBuf *b = g_diag;
+        if (b->len + (size_t)n + 1 > b->cap) {
+            size_t cap = b->cap ? b->cap : 128;
+            while (cap < b->len + (size_t)n + 1) cap *= 2;
+            b->data = (char*)realloc(b->data, cap);
+            if (!b->data) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+            b->cap = cap;
+        }
+        vsnprintf(b->data + b->len, (size_t)n + 1, fmt, again);
+        b->len += (size_t)n;
     }
-    return 0;
+    va_end(again);
 }
 
 /* =========================================================
  * Pilha de tipo de retorno de função
  * ========================================================= */
 #define MAX_FUN_STACK 64
-static TypeTag g_fun_ret_stack[MAX_FUN_STACK];
-static int     g_fun_sp = 0;
+static _Thread_local TypeTag g_fun_ret_stack[MAX_FUN_STACK];
+static _Thread_local int     g_fun_sp = 0;
 
 static void push_fun_ret(TypeTag t) { if (g_fun_sp < MAX_FUN_STACK) g_fun_ret_stack[g_fun_sp++] = t; }
 static void pop_fun_ret(void) { if (g_fun_sp > 0) g_fun_sp--; }
 static TypeTag current_fun_ret(void) { return (g_fun_sp>0)? g_fun_ret_stack[g_fun_sp-1] : TY_VOID; }
 
 /* =========================================================
- * Registro e lookup de funções globais
+ * Funções: as assinaturas ficam no registro do resolvedor; cada
+ * ND_CALL chega com o índice da função chamada (resolve.h)
  * ========================================================= */
-typedef struct FunSig {
-    const char *name;
-    TypeTag     ret;
-    TypeTag    *params;
-    size_t      param_count;
-    struct FunSig *next;
-} FunSig;
-
-static FunSig *g_funs = NULL;
-
-/**
- * Procura uma função registrada por nome.
- */
-static const FunSig* find_fun(const char *name) {
-    for (const FunSig *f = g_funs; f; f = f->next)
-        if (strcmp(f->name, name) == 0)
-            return f;
-    return NULL;
-}
-
-/**
- * Registra uma função global.
- * Copia tipos e armazena em lista encadeada global.
- */
-static void register_fun(const char *name, TypeTag ret, Node **param_nodes, size_t n) {
-    FunSig *f = (FunSig*)malloc(sizeof(FunSig));
-    f->name  = xstrdup(name);
-    f->ret   = ret;
-    f->param_count = n;
-    if (n > 0) {
-        f->params = (TypeTag*)malloc(sizeof(TypeTag) * n);
-        for (size_t i = 0; i < n; i++) {
-            Node *pd = param_nodes[i]; /* ND_DECL */
-            f->params[i] = pd->u.as_decl.type;
-        }
-    } else {
-        f->params = NULL;
-    }
-    f->next = g_funs;
-    g_funs = f;
+static Resolver *g_resolver = NULL;
+
+static const FunSig *find_fun(const Node *call) {
+    return resolve_function(g_resolver, call->u.as_call.fn_index);
 }
 
 /* =========================================================
  * Helpers de tipo e inferência de expressões
  *    - is_numeric
- *    - infer_* (unário/binário)
- *    - infer (despacha por nó)
+ *    - infer_binary (regra de tipos dos operadores binários)
+ *    - infer (despacha por nó, com pilha de quadros explícita)
  * ========================================================= */
 static inline int is_numeric(TypeTag t) { return t == TY_INT || t == TY_FLOAT; }
 
-static TypeTag infer_unary(Node *n, int *errors) {
-    TypeTag t = infer(n->u.as_unary.expr, errors);
-    switch (n->u.as_unary.op) {
-        case UN_NEG: return is_numeric(t) ? t : TY_INVALID;
-        case UN_NOT: return (t == TY_BOOL) ? TY_BOOL : TY_INVALID;
-        default:     return TY_INVALID;
-    }
-}
-
-static TypeTag infer_binary(Node *n, int *errors) {
-    TypeTag L = infer(n->u.as_binary.left,  errors);
-    TypeTag R = infer(n->u.as_binary.right, errors);
-    switch (n->u.as_binary.op) {
+TypeTag infer_binary(BinOp op, TypeTag L, TypeTag R) {
+    switch (op) {
         case BIN_ADD: case BIN_SUB: case BIN_MUL:
             return (is_numeric(L) && is_numeric(R)) ? ((L==TY_FLOAT||R==TY_FLOAT)?TY_FLOAT:TY_INT) : TY_INVALID;
         case BIN_DIV:
@@ -170,71 +183,176 @@ static TypeTag infer_binary(Node *n, int *errors) {
     return TY_INVALID;
 }
 
-static TypeTag infer(Node *n, int *errors) {
-    if (!n) return TY_INVALID;
-    switch (n->kind) {
-        case ND_INT:    return TY_INT;
-        case ND_FLOAT:  return TY_FLOAT;
-        case ND_BOOL:   return TY_BOOL;
-        case ND_STRING: return TY_STRING;
-        case ND_IDENT: {
-            TypeTag t;
-            if (!lookup_type(n->u.as_ident.name, &t)) {
-                fprintf(stderr, "Erro semântico: identificador '%s' não declarado\n", n->u.as_ident.name);
-                (*errors)++;
-                return TY_INVALID;
-            }
-            return t;
-        }
-        case ND_UNARY:  return infer_unary(n, errors);
-        case ND_BINARY: return infer_binary(n, errors);
-        case ND_ASSIGN: {
-            check_assign(n, errors);
-            return infer(n->u.as_assign.value, errors);
-        }
+/* Quadro da inferência iterativa: o nó, em que ponto dele estamos e
+ * o que já foi calculado (o tipo do filho que acabou de terminar chega
+ * em `ret`, ver infer) */
+typedef struct {
+    Node         *n;
+    int           stage;
+    size_t        i;      /* próximo argumento (ND_CALL) */
+    TypeTag       t;      /* tipo do lado esquerdo / da variável */
+    const FunSig *fs;     /* função chamada (ND_CALL) */
+} InferFrame;
+
+/* Guarda o tipo inferido no nó, para as fases seguintes (os nós
+ * compartilhados são imutáveis: o tipo de um nome depende do escopo) */
+static inline void annotate(Node *n, TypeTag t) {
+    if (n && !(n->flags & NODE_SHARED)) n->type = (unsigned char)t;
+}
 
-        case ND_EXPR:
-            return infer(n->u.as_expr.expr, errors);
+static void infer_push(WorkStack *s, Node *n) {
+    InferFrame *f = (InferFrame*)ws_push(s);
+    f->n = n;
+    f->stage = 0;
+    f->i = 0;
+    f->t = TY_INVALID;
+    f->fs = NULL;
+}
 
-        case ND_CALL: {
-        const FunSig *fs = find_fun(n->u.as_call.name);
-        if (!fs) {
-            fprintf(stderr, "Erro semântico: função '%s' não declarada\n", n->u.as_call.name);
-            (*errors)++;
-            for (size_t i=0;i<n->u.as_call.arg_count;i++) (void)infer(n->u.as_call.args[i], errors);
-            return TY_INVALID;
-        }
-        if (fs->param_count != n->u.as_call.arg_count) {
-            fprintf(stderr, "Erro semântico: chamada a '%s' com aridade incorreta (esperado %zu, obtido %zu)\n",
-                    n->u.as_call.name, fs->param_count, n->u.as_call.arg_count);
-            (*errors)++;
-        }
-        size_t m = (fs->param_count < n->u.as_call.arg_count) ? fs->param_count : n->u.as_call.arg_count;
-        for (size_t i=0;i<m;i++) {
-            TypeTag got = infer(n->u.as_call.args[i], errors);
-            TypeTag want = fs->params[i];
-            if (!(got==want || (is_numeric(got)&&is_numeric(want)))) {
-                fprintf(stderr, "Erro semântico: argumento %zu de '%s' incompatível (esperado %d, obtido %d)\n",
-                        i+1, n->u.as_call.name, (int)want, (int)got);
-                (*errors)++;
+/* Iterativa (pilha de quadros no heap): expressões de qualquer profundidade.
+ * Mesma ordem de visita e de mensagens da definição recursiva:
+ *   unário/binário: filhos e depois a regra de tipos;
+ *   atribuição: check_assign e depois o tipo do valor (visitado de novo);
+ *   chamada: aridade, depois cada argumento seguido da sua verificação.
+ * O tipo de cada nó visitado fica em Node.type. */
+static TypeTag infer(Node *root, int *errors) {
+    InferFrame buf[32];
+    WorkStack stack;
+    ws_init(&stack, buf, sizeof buf, sizeof(InferFrame));
+    infer_push(&stack, root);
+
+    TypeTag ret = TY_INVALID;   /* resultado do último quadro encerrado */
+
+    while (!ws_empty(&stack)) {
+        InferFrame *f = (InferFrame*)ws_top(&stack);
+        Node *n = f->n;
+
+        /* f não vale mais depois de infer_push: o estágio é gravado antes */
+        #define CALL(child, next) do { f->stage = (next); infer_push(&stack, (child)); } while (0)
+        #define RETURN(value)     do { ret = (value); annotate(n, ret); ws_pop(&stack); } while (0)
+
+        if (!n) { RETURN(TY_INVALID); continue; }
+
+        switch (n->kind) {
+            case ND_INT:    RETURN(TY_INT); break;
+            case ND_FLOAT:  RETURN(TY_FLOAT); break;
+            case ND_BOOL:   RETURN(TY_BOOL); break;
+            case ND_STRING: RETURN(TY_STRING); break;
+
+            case ND_IDENT: {
+                TypeTag t;
+                if (!lookup_type(&n->u.as_ident.ref, &t)) {
+                    diag("Erro semântico: identificador '%s' não declarado\n", n->u.as_ident.name);
+                    (*errors)++;
+                    t = TY_INVALID;
+                }
+                RETURN(t);
+                break;
             }
+
+            case ND_UNARY:
+                if (f->stage == 0) { CALL(n->u.as_unary.expr, 1); break; }
+                switch (n->u.as_unary.op) {
+                    case UN_NEG: RETURN(is_numeric(ret) ? ret : TY_INVALID); break;
+                    case UN_NOT: RETURN((ret == TY_BOOL) ? TY_BOOL : TY_INVALID); break;
+                    default:     RETURN(TY_INVALID); break;
+                }
+                break;
+
+            case ND_BINARY:
+                if (f->stage == 0) { CALL(n->u.as_binary.left, 1); break; }
+                if (f->stage == 1) { f->t = ret; CALL(n->u.as_binary.right, 2); break; }
+                RETURN(infer_binary(n->u.as_binary.op, f->t, ret));
+                break;
+
+            case ND_ASSIGN:
+                /* 0: check_assign; 2: compara com o lado esquerdo; 3: tipo do valor */
+                if (f->stage == 0) {
+                    if (!lookup_type(&n->u.as_assign.ref, &f->t)) {
+                        diag("Erro semântico: variável '%s' não declarada\n", n->u.as_assign.name);
+                        (*errors)++;
+                        CALL(n->u.as_assign.value, 3);
+                    } else {
+                        CALL(n->u.as_assign.value, 2);
+                    }
+                    break;
+                }
+                if (f->stage == 2) {
+                    if (!(ret==f->t || (is_numeric(ret)&&is_numeric(f->t)))) {
+                        diag("Erro semântico: tipos incompatíveis na atribuição a '%s'\n", n->u.as_assign.name);
+                        (*errors)++;
+                    }
+                    CALL(n->u.as_assign.value, 3);
+                    break;
+                }
+                RETURN(ret);
+                break;
+
+            case ND_EXPR:
+                if (f->stage == 0) { CALL(n->u.as_expr.expr, 1); break; }
+                RETURN(ret);
+                break;
+
+            case ND_CALL: {
+                size_t argc = n->u.as_call.arg_count;
+                if (f->stage == 0) {
+                    f->fs = find_fun(n);
+                    if (!f->fs) {
+                        diag("Erro semântico: função '%s' não declarada\n", n->u.as_call.name);
+                        (*errors)++;
+                        f->stage = 1;
+                    } else {
+                        if (f->fs->param_count != argc) {
+                            diag("Erro semântico: chamada a '%s' com aridade incorreta (esperado %zu, obtido %zu)\n",
+                                 n->u.as_call.name, f->fs->param_count, argc);
+                            (*errors)++;
+                        }
+                        f->stage = 2;
+                    }
+                    continue;
+                }
+                if (f->stage == 1) {   /* função desconhecida: só visita os argumentos */
+                    if (f->i < argc) { f->i++; CALL(n->u.as_call.args[f->i - 1], 1); }
+                    else RETURN(TY_INVALID);
+                    break;
+                }
+                if (f->stage == 3) {   /* argumento f->i acabou de ser inferido */
+                    TypeTag want = f->fs->params[f->i];
+                    if (!(ret==want || (is_numeric(ret)&&is_numeric(want)))) {
+                        diag("Erro semântico: argumento %zu de '%s' incompatível (esperado %d, obtido %d)\n",
+                             f->i+1, n->u.as_call.name, (int)want, (int)ret);
+                        (*errors)++;
+                    }
+                    f->i++;
+                    f->stage = 2;
+                }
+                size_t m = (f->fs->param_count < argc) ? f->fs->param_count : argc;
+                if (f->i < m) CALL(n->u.as_call.args[f->i], 3);
+                else RETURN(f->fs->ret);
+                break;
+            }
+
+            default:
+                RETURN(TY_INVALID);
+                break;
         }
-        return fs->ret;
-    }
 
-        default:
-            return TY_INVALID;
+        #undef CALL
+        #undef RETURN
     }
+
+    ws_free(&stack);
+    return ret;
 }
 
 /* =========================================================
  * Visitantes de statements (check_*)
  * ========================================================= */
 static void check_block(Node *blk, int *errors) {
-    push_scope_new();
+    g_block_depth++;
     for (size_t i = 0; i < blk->u.as_block.count; i++)
         check_stmt(blk->u.as_block.stmts[i], errors);
-    pop_scope();
+    g_block_depth--;
 }
 
 static void check_decl(Node *decl, int *errors) {
@@ -245,18 +363,18 @@ static void check_decl(Node *decl, int *errors) {
     if (init) {
         TypeTag tinf = infer(init, errors);
         if (!(tinf == tdecl || (is_numeric(tinf) && is_numeric(tdecl)))) {
-            fprintf(stderr, "Erro semântico: tipo incompatível na inicialização de '%s'\n", name);
+            diag("Erro semântico: tipo incompatível na inicialização de '%s'\n", name);
             (*errors)++;
         }
     }
 
-    if (exists_local(name)) {
-        fprintf(stderr, "Erro semântico: variável '%s' já declarada neste escopo\n", name);
+    if (decl->u.as_decl.ref.flags & VAR_REDECLARED) {
+        diag("Erro semântico: variável '%s' já declarada neste escopo\n", name);
         (*errors)++;
         return;
     }
 
-    (void)st_insert(g_scope->tab, name, tdecl, NULL);
+    declare(decl);
 }
 
 static void check_assign(Node *as, int *errors) {
@@ -264,21 +382,21 @@ static void check_assign(Node *as, int *errors) {
     Node *rhs = as->u.as_assign.value;
 
     TypeTag lhs_t;
-    if (!lookup_type(name, &lhs_t)) {
-        fprintf(stderr, "Erro semântico: variável '%s' não declarada\n", name);
+    if (!lookup_type(&as->u.as_assign.ref, &lhs_t)) {
+        diag("Erro semântico: variável '%s' não declarada\n", name);
         (*errors)++;
         return;
     }
     TypeTag rt = infer(rhs, errors);
     if (!(rt==lhs_t || (is_numeric(rt)&&is_numeric(lhs_t)))) {
-        fprintf(stderr, "Erro semântico: tipos incompatíveis na atribuição a '%s'\n", name);
+        diag("Erro semântico: tipos incompatíveis na atribuição a '%s'\n", name);
         (*errors)++;
     }
 }
 
 static void check_if(Node *ifn, int *errors) {
     if (!ifn->u.as_if.cond || infer(ifn->u.as_if.cond, errors) != TY_BOOL) {
-        fprintf(stderr, "Erro semântico: condição do if deve ser bool\n");
+        diag("Erro semântico: condição do if deve ser bool\n");
         (*errors)++;
     }
     if (ifn->u.as_if.then_branch) check_stmt(ifn->u.as_if.then_branch, errors);
@@ -287,7 +405,7 @@ static void check_if(Node *ifn, int *errors) {
 
 static void check_while(Node *wn, int *errors) {
     if (!wn->u.as_while.cond || infer(wn->u.as_while.cond, errors) != TY_BOOL) {
-        fprintf(stderr, "Erro semântico: condição do while deve ser bool\n");
+        diag("Erro semântico: condição do while deve ser bool\n");
         (*errors)++;
     }
     if (wn->u.as_while.body) check_stmt(wn->u.as_while.body, errors);
@@ -296,7 +414,7 @@ static void check_while(Node *wn, int *errors) {
 static void check_for(Node *fn, int *errors) {
     if (fn->u.as_for.init)  check_stmt(fn->u.as_for.init, errors);
     if (!fn->u.as_for.cond || infer(fn->u.as_for.cond, errors) != TY_BOOL) {
-        fprintf(stderr, "Erro semântico: condição do for deve ser bool\n");
+        diag("Erro semântico: condição do for deve ser bool\n");
         (*errors)++;
     }
     if (fn->u.as_for.step)  check_stmt(fn->u.as_for.step, errors);
@@ -307,40 +425,33 @@ static void check_return(Node *rn, int *errors) {
     TypeTag want = current_fun_ret();
     if (!rn->u.as_return.expr) {
         if (want != TY_VOID) {
-            fprintf(stderr, "Erro semântico: retorno vazio em função não-void\n");
+            diag("Erro semântico: retorno vazio em função não-void\n");
             (*errors)++;
         }
         return;
     }
     if (want == TY_VOID) {
-        fprintf(stderr, "Erro semântico: return com valor em função void\n");
+        diag("Erro semântico: return com valor em função void\n");
         (*errors)++;
         return;
     }
     TypeTag got = infer(rn->u.as_return.expr, errors);
     if (!(got==want || (is_numeric(got)&&is_numeric(want)))) {
-        fprintf(stderr, "Erro semântico: tipo de retorno incompatível\n");
+        diag("Erro semântico: tipo de retorno incompatível\n");
         (*errors)++;
     }
 }
 
 static void check_function(Node *fn, int *errors) {
-    register_fun(fn->u.as_function.name,
-                 fn->u.as_function.ret_type,
-                 fn->u.as_function.params,
-                 fn->u.as_function.param_count);
-
     push_fun_ret(fn->u.as_function.ret_type);
-    push_scope_new();
+    g_block_depth++;
 
-    for (size_t i = 0; i < fn->u.as_function.param_count; i++) {
-        Node *pd = fn->u.as_function.params[i];
-        st_insert(g_scope->tab, pd->u.as_decl.name, pd->u.as_decl.type, NULL);
-    }
+    for (size_t i = 0; i < fn->u.as_function.param_count; i++)
+        declare(fn->u.as_function.params[i]);
 
     check_stmt(fn->u.as_function.body, errors);
 
-    pop_scope();
+    g_block_depth--;
     pop_fun_ret();
 }
 
@@ -360,6 +471,90 @@ static void check_stmt(Node *n, int *errors) {
     }
 }
 
+/* =========================================================
+ * Verificação paralela (ASTEROIDS_CHECK_THREADS=N)
+ *    1) todas as instruções de nível superior são resolvidas, em ordem
+ *       (as assinaturas já vêm do pré-passo);
+ *    2) o código global é verificado nesta thread, em ordem: ele dá os
+ *       tipos das globais e preenche a SymbolTable;
+ *    3) os corpos das funções de nível superior são verificados no pool
+ *       (work_pool.h), que só lê os tipos das globais e o registro de
+ *       funções;
+ *    4) cada instrução tem o seu buffer de diagnósticos, impressos na
+ *       ordem do fonte: a saída é a mesma da verificação serial.
+ * ========================================================= */
+typedef struct {
+    Node   *stmt;       /* já resolvida */
+    int32_t locals;     /* slots locais das funções dela */
+    int     errors;
+    DiagBuf diag;
+} TopStmt;
+
+typedef struct {
+    TopStmt *items;
+    size_t   count, cap;
+    size_t  *funs;      /* posições das funções em items */
+    size_t   fun_count;
+} TopLevel;
+
+static int check_env_threads(void) {
+    const char *env = getenv("ASTEROIDS_CHECK_THREADS");
+    return env ? atoi(env) : 0;
+}
+
+static void top_add(TopLevel *t, Resolver *rs, Node *stmt) {
+    if (t->count == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 64;
+        t->items = (TopStmt*)realloc(t->items, t->cap * sizeof(TopStmt));
+        if (!t->items) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    }
+    stmt = resolve_stmt(rs, stmt);
+    TopStmt *ts = &t->items[t->count++];
+    memset(ts, 0, sizeof *ts);
+    ts->stmt = stmt;
+    ts->locals = resolve_local_count(rs);
+}
+
+static void check_top(TopStmt *ts) {
+    g_diag = &ts->diag;
+    slot_types_reserve(&g_local_types, ts->locals);
+    check_stmt(ts->stmt, &ts->errors);
+    g_diag = NULL;
+}
+
+static void check_function_task(void *ctx, size_t k) {
+    TopLevel *t = (TopLevel*)ctx;
+    check_top(&t->items[t->funs[k]]);
+}
+
+static void check_worker_exit(void *ctx) {
+    (void)ctx;
+    local_types_release();
+}
+
+static int check_top_level(TopLevel *t, Resolver *rs, int threads) {
+    slot_types_reserve(&g_global_types, resolve_global_count(rs));
+
+    t->funs = (size_t*)xmalloc((t->count ? t->count : 1) * sizeof(size_t));
+    for (size_t i = 0; i < t->count; i++) {
+        TopStmt *ts = &t->items[i];
+        if (ts->stmt && ts->stmt->kind == ND_FUNCTION) t->funs[t->fun_count++] = i;
+        else check_top(ts);
+    }
+    work_pool_run(t->fun_count, threads, check_function_task, check_worker_exit, t);
+
+    int errors = 0;
+    for (size_t i = 0; i < t->count; i++) {
+        TopStmt *ts = &t->items[i];
+        if (ts->diag.len) fwrite(ts->diag.data, 1, ts->diag.len, stderr);
+        free(ts->diag.data);
+        errors += ts->errors;
+    }
+    free(t->items);
+    free(t->funs);
+    return errors;
+}
+
 /* =========================================================
  * API pública
  * ========================================================= */
@@ -367,13 +562,90 @@ int check_semantics(Node *ast_root, SymbolTable *table) {
     int errors = 0;
     if (!ast_root) return 0;
 
-    push_scope_with(table);
-    check_stmt(ast_root, &errors);
-    pop_scope();
+    Resolver *rs = resolve_new();
+    g_table = table;
+    g_resolver = rs;
+
+    /* todas as funções visíveis desde a primeira instrução */
+    resolve_declare_functions(rs, ast_root);
+    int threads = check_env_threads();
+
+    if (ast_root->kind == ND_BLOCK && threads > 1) {
+        TopLevel top = {0};
+        resolve_keep_copies(rs, true);
+        for (size_t i = 0; i < ast_root->u.as_block.count; i++)
+            top_add(&top, rs, ast_root->u.as_block.stmts[i]);
+        errors = check_top_level(&top, rs, threads);
+    } else if (ast_root->kind == ND_BLOCK) {
+        /* o bloco raiz é o escopo do programa: uma instrução por vez */
+        for (size_t i = 0; i < ast_root->u.as_block.count; i++)
+            check_stmt(resolve_top(rs, ast_root->u.as_block.stmts[i]), &errors);
+    } else {
+        check_stmt(resolve_top(rs, ast_root), &errors);
+    }
+
+    slot_types_release();
+    resolve_free(rs);
+    g_resolver = NULL;
+    return errors;
+}
+
+void check_begin(Resolver *rs, SymbolTable *table) {
+    g_table = table;
+    g_resolver = rs;
+}
 
+int check_resolved_stmt(Resolver *rs, Node *stmt) {
+    int errors = 0;
+    reserve_slots(rs);
+    check_stmt(stmt, &errors);
     return errors;
 }
 
+void check_end(void) {
+    slot_types_release();
+    g_resolver = NULL;
+}
+
 int semantics_ok(Node *root, SymbolTable *table) {
     return check_semantics(root, table) == 0 ? 1 : 0;
 }
+
+int check_semantics_compact(const CompactAst *ast, SymbolTable *table) {
+    int errors = 0;
+    if (!ast || ast->root == CAST_NONE) return 0;
+
+    Arena *scratch = arena_new();
+    Arena *prev = ast_set_arena(scratch);
+    Resolver *rs = resolve_new();
+    g_table = table;
+    g_resolver = rs;
+    resolve_declare_functions_compact(rs, ast);
+    int threads = check_env_threads();
+
+    if (cast_kind(ast, ast->root) == ND_BLOCK && threads > 1) {
+        /* os nós montados ficam na arena até o fim da verificação */
+        CList list = *cast_block(ast, ast->root);
+        TopLevel top = {0};
+        resolve_keep_copies(rs, true);
+        for (uint32_t i = 0; i < list.count; i++)
+            top_add(&top, rs, cast_to_node(ast, cast_list_at(ast, list, i)));
+        errors = check_top_level(&top, rs, threads);
+    } else if (cast_kind(ast, ast->root) == ND_BLOCK) {
+        /* como check_semantics, uma instrução por vez */
+        CList top = *cast_block(ast, ast->root);
+        for (uint32_t i = 0; i < top.count; i++) {
+            check_stmt(resolve_top(rs, cast_to_node(ast, cast_list_at(ast, top, i))), &errors);
+            arena_reset(scratch);
+        }
+    } else {
+        check_stmt(resolve_top(rs, cast_to_node(ast, ast->root)), &errors);
+    }
+
+    slot_types_release();
+    resolve_free(rs);
+    g_resolver = NULL;
+    ast_set_arena(prev);
+    arena_free(scratch);
+    return errors;
+}
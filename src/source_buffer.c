@@ -0,0 +1,94 @@
+#include "source_buffer.h"
+#include "ast_base.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Lê todo o conteúdo de um descritor em uma única alocação */
+static bool read_all(SourceBuffer *sb, int fd) {
+    size_t cap = 64 * 1024, len = 0;
+    char *buf = (char*)xmalloc(cap);
+
+    for (;;) {
+        if (cap - len < 2) {
+            cap *= 2;
+            char *nb = (char*)realloc(buf, cap);
+            if (!nb) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+            buf = nb;
+        }
+        ssize_t n = read(fd, buf + len, cap - len - 2);
+        if (n < 0) { perror("Erro ao ler entrada"); free(buf); return false; }
+        if (n == 0) break;
+        len += (size_t)n;
+    }
+
+    buf[len] = '\0';
+    buf[len + 1] = '\0';
+    sb->data = buf;
+    sb->len = len;
+    sb->map_len = 0;
+    return true;
+}
+
+/* Tenta mapear o arquivo; só funciona se sobrarem 2 bytes zerados
+ * na última página (o kernel preenche o fim da página com zeros). */
+static bool map_file(SourceBuffer *sb, int fd, size_t size) {
+    long page = sysconf(_SC_PAGESIZE);
+    if (size == 0 || page <= 0) return false;
+
+    size_t tail = size % (size_t)page;
+    if (tail == 0 || (size_t)page - tail < 2) return false;
+
+    /* PROT_WRITE: o Flex escreve '\0' temporários no fim de cada token */
+    void *p = mmap(NULL, size + 2, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) return false;
+
+#ifdef MADV_SEQUENTIAL
+    (void)madvise(p, size + 2, MADV_SEQUENTIAL);
+#endif
+
+    sb->data = (char*)p;
+    sb->len = size;
+    sb->map_len = size + 2;
+    return true;
+}
+
+bool source_open(SourceBuffer *sb, const char *path) {
+    sb->data = NULL;
+    sb->len = 0;
+    sb->map_len = 0;
+
+    if (!path || strcmp(path, "--") == 0) {
+        return read_all(sb, STDIN_FILENO);
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Erro ao abrir arquivo");
+        return false;
+    }
+
+    struct stat st;
+    bool ok = false;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        ok = map_file(sb, fd, (size_t)st.st_size);
+    }
+    if (!ok) ok = read_all(sb, fd);
+
+    close(fd);
+    return ok;
+}
+
+void source_close(SourceBuffer *sb) {
+    if (!sb || !sb->data) return;
+    if (sb->map_len) munmap(sb->data, sb->map_len);
+    else             free(sb->data);
+    sb->data = NULL;
+    sb->len = 0;
+    sb->map_len = 0;
+}
@@ -0,0 +1,134 @@
+#include "str_pool.h"
+#include "ast_base.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_INITIAL_SLOTS 64
+#define POOL_CHUNK_SIZE    (16 * 1024)
+
+typedef struct {
+    const char *str;
+    uint32_t    len;
+    uint32_t    hash;
+} PoolEntry;
+
+/* Blocos de onde os textos são alocados (nunca se movem) */
+typedef struct PoolChunk {
+    struct PoolChunk *next;
+    size_t used;
+    size_t cap;
+    char   data[];
+} PoolChunk;
+
+struct StrPool {
+    PoolEntry *entries;     /* por índice */
+    size_t     count, cap;
+
+    uint32_t  *slots;       /* endereçamento aberto: índice + 1 (0 = vazio) */
+    size_t     slot_cap;    /* potência de 2 */
+
+    PoolChunk *chunks;
+};
+
+/* FNV-1a (32 bits), como em intern.c */
+static uint32_t hash_bytes(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char *chunk_alloc(StrPool *pool, size_t size) {
+    if (!pool->chunks || pool->chunks->cap - pool->chunks->used < size) {
+        size_t cap = size > POOL_CHUNK_SIZE ? size : POOL_CHUNK_SIZE;
+        PoolChunk *c = (PoolChunk*)xmalloc(sizeof(PoolChunk) + cap);
+        c->next = pool->chunks;
+        c->used = 0;
+        c->cap  = cap;
+        pool->chunks = c;
+    }
+    char *p = pool->chunks->data + pool->chunks->used;
+    pool->chunks->used += size;
+    return p;
+}
+
+static void grow_slots(StrPool *pool) {
+    size_t new_cap = pool->slot_cap ? pool->slot_cap * 2 : POOL_INITIAL_SLOTS;
+    uint32_t *slots = (uint32_t*)calloc(new_cap, sizeof(uint32_t));
+    if (!slots) { fprintf(stderr, "error: calloc failed\n"); exit(1); }
+
+    for (size_t i = 0; i < pool->count; i++) {
+        size_t j = pool->entries[i].hash & (new_cap - 1);
+        while (slots[j]) j = (j + 1) & (new_cap - 1);
+        slots[j] = (uint32_t)i + 1;
+    }
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slot_cap = new_cap;
+}
+
+StrPool *str_pool_new(void) {
+    StrPool *pool = (StrPool*)xmalloc(sizeof(StrPool));
+    memset(pool, 0, sizeof *pool);
+    return pool;
+}
+
+void str_pool_free(StrPool *pool) {
+    if (!pool) return;
+    PoolChunk *c = pool->chunks;
+    while (c) {
+        PoolChunk *next = c->next;
+        free(c);
+        c = next;
+    }
+    free(pool->slots);
+    free(pool->entries);
+    free(pool);
+}
+
+uint32_t str_pool_add(StrPool *pool, const char *s, size_t len) {
+    /* mantém fator de carga <= 1/2 */
+    if ((pool->count + 1) * 2 > pool->slot_cap) grow_slots(pool);
+
+    uint32_t h = hash_bytes(s, len);
+    size_t mask = pool->slot_cap - 1;
+    size_t i = h & mask;
+
+    for (uint32_t slot; (slot = pool->slots[i]) != 0; i = (i + 1) & mask) {
+        const PoolEntry *e = &pool->entries[slot - 1];
+        if (e->hash == h && e->len == len && memcmp(e->str, s, len) == 0) return slot - 1;
+    }
+
+    if (pool->count == pool->cap) {
+        pool->cap = pool->cap ? pool->cap * 2 : 16;
+        pool->entries = (PoolEntry*)realloc(pool->entries, pool->cap * sizeof(PoolEntry));
+        if (!pool->entries) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    }
+
+    char *str = chunk_alloc(pool, len + 1);
+    memcpy(str, s, len);
+    str[len] = '\0';
+
+    uint32_t id = (uint32_t)pool->count++;
+    pool->entries[id].str  = str;
+    pool->entries[id].len  = (uint32_t)len;
+    pool->entries[id].hash = h;
+    pool->slots[i] = id + 1;
+    return id;
+}
+
+const char *str_pool_get(const StrPool *pool, uint32_t id) {
+    return pool->entries[id].str;
+}
+
+size_t str_pool_len(const StrPool *pool, uint32_t id) {
+    return pool->entries[id].len;
+}
+
+size_t str_pool_count(const StrPool *pool) {
+    return pool ? pool->count : 0;
+}
@@ -1,94 +1,128 @@
 // symbol_table.c
 #include "ast.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define INITIAL_CAPACITY 16
+#define INITIAL_CAPACITY 16     /* posições; sempre potência de 2 */
+#define NO_SLOT ((size_t)-1)
 
-// Função hash simples para strings
-static size_t hash(const char *str, size_t capacity) {
-    size_t hash_value = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash_value = ((hash_value << 5) + hash_value) + c; // hash * 33 + c
+/* Distância da posição `pos` até a posição ideal do hash */
+static inline size_t probe_dist(const SymbolTable *table, size_t pos, uint32_t hash) {
+    return (pos - hash) & (table->capacity - 1);
+}
+
+/* Posição do símbolo `name` ou NO_SLOT.
+ * Nomes são internados: o hash já vem pré-calculado pela tabela de nomes
+ * e, com o hash guardado em cada posição, só um acerto toca no símbolo.
+ * Robin Hood: a busca para assim que passa de um símbolo mais perto da
+ * própria posição ideal do que o procurado estaria. */
+static size_t find_slot(const SymbolTable *table, const char *name) {
+    if (table->size == 0) return NO_SLOT;
+
+    uint32_t h = intern_hash(name);
+    size_t mask = table->capacity - 1;
+    for (size_t pos = h & mask, dist = 0; ; pos = (pos + 1) & mask, dist++) {
+        const SymSlot *slot = &table->slots[pos];
+        if (slot->sym == 0 || probe_dist(table, pos, slot->hash) < dist) return NO_SLOT;
+        if (slot->hash == h && table->symbols[slot->sym - 1].name == name) return pos;
+    }
+}
+
+static Symbol *find(const SymbolTable *table, const char *name) {
+    size_t pos = find_slot(table, name);
+    return pos == NO_SLOT ? NULL : &table->symbols[table->slots[pos].sym - 1];
+}
+
+/* Coloca uma entrada nova (sem procurar duplicata): quem está mais longe
+ * da posição ideal fica com a posição, e o deslocado segue adiante */
+static void place(SymbolTable *table, SymSlot entry) {
+    size_t mask = table->capacity - 1;
+    for (size_t pos = entry.hash & mask, dist = 0; ; pos = (pos + 1) & mask, dist++) {
+        SymSlot *slot = &table->slots[pos];
+        if (slot->sym == 0) { *slot = entry; return; }
+
+        size_t other = probe_dist(table, pos, slot->hash);
+        if (other < dist) {
+            SymSlot displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+            dist = other;
+        }
     }
-    return hash_value % capacity;
+}
+
+static void grow_slots(SymbolTable *table) {
+    size_t old_cap = table->capacity;
+    SymSlot *old = table->slots;
+
+    table->capacity = old_cap ? old_cap * 2 : INITIAL_CAPACITY;
+    table->slots = (SymSlot*)calloc(table->capacity, sizeof(SymSlot));
+    if (!table->slots) { fprintf(stderr, "error: calloc failed\n"); exit(1); }
+
+    for (size_t i = 0; i < old_cap; i++)
+        if (old[i].sym) place(table, old[i]);
+    free(old);
 }
 
 SymbolTable* st_create(void) {
     SymbolTable *table = (SymbolTable*)xmalloc(sizeof(SymbolTable));
-    table->capacity = INITIAL_CAPACITY;
+    table->symbols = NULL;
     table->size = 0;
+    table->symbols_cap = 0;
+    table->slots = NULL;
+    table->capacity = 0;
     table->parent = NULL;
-    table->buckets = (Symbol**)xmalloc(table->capacity * sizeof(Symbol*));
-
-    for (size_t i = 0; i < table->capacity; i++) {
-        table->buckets[i] = NULL;
-    }
     return table;
 }
 
 void st_destroy(SymbolTable *table) {
     if (!table) return;
 
-    for (size_t i = 0; i < table->capacity; i++) {
-        Symbol *current = table->buckets[i];
-        while (current) {
-            Symbol *next = current->next;
-            free(current->name);
-            ast_free(current->value);
-            free(current);
-            current = next;
-        }
-    }
-    free(table->buckets);
+    for (size_t i = 0; i < table->size; i++) ast_free(table->symbols[i].value);
+    free(table->symbols);
+    free(table->slots);
     free(table);
 }
 
 bool st_insert(SymbolTable *table, const char *name, TypeTag type, Node *value) {
     if (!table || !name) return false;
 
-    size_t index = hash(name, table->capacity);
-    Symbol *current = table->buckets[index];
-
     // Verifica se já existe
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            // Atualiza tipo e valor existentes
-            current->type = type;
-            ast_free(current->value);
-            current->value = value;
-            return true;
-        }
-        current = current->next;
+    Symbol *current = find(table, name);
+    if (current) {
+        // Atualiza tipo e valor existentes
+        current->type = type;
+        ast_free(current->value);
+        current->value = value;
+        return true;
+    }
+
+    // mantém ocupação <= 3/4
+    if ((table->size + 1) * 4 > table->capacity * 3) grow_slots(table);
+
+    if (table->size == table->symbols_cap) {
+        table->symbols_cap = table->symbols_cap ? table->symbols_cap * 2 : 8;
+        table->symbols = (Symbol*)realloc(table->symbols, table->symbols_cap * sizeof(Symbol));
+        if (!table->symbols) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
     }
 
     // Cria novo símbolo
-    Symbol *new_symbol = (Symbol*)xmalloc(sizeof(Symbol));
-    new_symbol->name = xstrdup(name);
+    Symbol *new_symbol = &table->symbols[table->size];
+    new_symbol->name = name;
     new_symbol->type = type;
     new_symbol->value = value;
-    new_symbol->next = table->buckets[index];
-    table->buckets[index] = new_symbol;
     table->size++;
 
+    place(table, (SymSlot){ .hash = intern_hash(name), .sym = (uint32_t)table->size });
     return true;
 }
 
 Node* st_lookup(SymbolTable *table, const char *name) {
     if (!table || !name) return NULL;
-
-    size_t index = hash(name, table->capacity);
-    Symbol *current = table->buckets[index];
-
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            return current->value;
-        }
-        current = current->next;
-    }
-    return NULL;
+    Symbol *current = find(table, name);
+    return current ? current->value : NULL;
 }
 
 Node* st_lookup_recursive(SymbolTable *table, const char *name) {
@@ -104,27 +138,33 @@ Node* st_lookup_recursive(SymbolTable *table, const char *name) {
 bool st_remove(SymbolTable *table, const char *name) {
     if (!table || !name) return false;
 
-    size_t index = hash(name, table->capacity);
-    Symbol *current = table->buckets[index];
-    Symbol *prev = NULL;
+    size_t pos = find_slot(table, name);
+    if (pos == NO_SLOT) return false;
 
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            if (prev) {
-                prev->next = current->next;
-            } else {
-                table->buckets[index] = current->next;
-            }
-            free(current->name);
-            ast_free(current->value);
-            free(current);
-            table->size--;
-            return true;
-        }
-        prev = current;
-        current = current->next;
+    size_t index = table->slots[pos].sym - 1;
+    size_t mask = table->capacity - 1;
+
+    // Robin Hood: os seguintes que não estão na posição ideal voltam uma casa
+    for (;;) {
+        size_t next = (pos + 1) & mask;
+        SymSlot *slot = &table->slots[next];
+        if (slot->sym == 0 || probe_dist(table, next, slot->hash) == 0) break;
+        table->slots[pos] = *slot;
+        pos = next;
     }
-    return false;
+    table->slots[pos].sym = 0;
+
+    ast_free(table->symbols[index].value);
+    table->size--;
+
+    // o último símbolo ocupa o buraco; a posição dele passa a apontar para cá
+    // (find_slot ainda o encontra pelo índice antigo, que não foi apagado)
+    if (index != table->size) {
+        table->symbols[index] = table->symbols[table->size];
+        size_t moved = find_slot(table, table->symbols[index].name);
+        table->slots[moved].sym = (uint32_t)index + 1;
+    }
+    return true;
 }
 
 void st_print(SymbolTable *table) {
@@ -133,80 +173,56 @@ void st_print(SymbolTable *table) {
         return;
     }
 
-    printf("Tabela de símbolos (%zu símbolos):\n", table->size);
+    printf("Tabela de símbolos (%zu símbolos, %zu posições):\n", table->size, table->capacity);
     for (size_t i = 0; i < table->capacity; i++) {
-        Symbol *current = table->buckets[i];
-        if (current) {
-            printf("  [%zu]: ", i);
-            while (current) {
-                printf("%s -> ", current->name);
-                current = current->next;
-            }
-            printf("NULL\n");
+        const SymSlot *slot = &table->slots[i];
+        if (slot->sym) {
+            printf("  [%zu]: %s (distância %zu)\n", i, table->symbols[slot->sym - 1].name,
+                   probe_dist(table, i, slot->hash));
         }
     }
 }
 
 bool st_update(SymbolTable *table, const char *name, Node *new_value) {
     if (!table || !name) return false;
-    size_t index = hash(name, table->capacity);
-    for (Symbol *cur = table->buckets[index]; cur; cur = cur->next) {
-        if (strcmp(cur->name, name) == 0) {
-            ast_free(cur->value);
-            cur->value = new_value;
-            return true;
-        }
-    }
-    return false;
+    Symbol *cur = find(table, name);
+    if (!cur) return false;
+    ast_free(cur->value);
+    cur->value = new_value;
+    return true;
 }
 
 bool st_update_recursive(SymbolTable *table, const char *name, Node *new_value) {
     if (!table || !name) return false;
 
-    size_t index = hash(name, table->capacity);
-    Symbol *current = table->buckets[index];
-
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            ast_free(current->value);
-            current->value = new_value;
+    for (SymbolTable *t = table; t; t = t->parent) {
+        Symbol *cur = find(t, name);
+        if (cur) {
+            ast_free(cur->value);
+            cur->value = new_value;
             return true;
         }
-        current = current->next;
     }
-
-    if (table->parent) {
-        return st_update_recursive(table->parent, name, new_value);
-    }
-
     return false;
 }
 
 TypeTag st_lookup_type(SymbolTable *table, const char *name, bool *found) {
-    if (!table || !name) {
-        if (found) *found = false;
-        return TY_INVALID;
-    }
     if (found) *found = false;
-    size_t index = hash(name, table->capacity);
-    for (Symbol *cur = table->buckets[index]; cur; cur = cur->next) {
-        if (strcmp(cur->name, name) == 0) {
-            if (found) *found = true;
-            return cur->type;
-        }
-    }
-    return TY_INVALID;
+    if (!table || !name) return TY_INVALID;
+
+    Symbol *cur = find(table, name);
+    if (!cur) return TY_INVALID;
+    if (found) *found = true;
+    return cur->type;
 }
 
 TypeTag st_lookup_type_recursive(SymbolTable *table, const char *name, bool *found) {
     if (found) *found = false;
     for (SymbolTable *t = table; t; t = t->parent) {
-        size_t index = hash(name, t->capacity);
-        for (Symbol *cur = t->buckets[index]; cur; cur = cur->next) {
-            if (strcmp(cur->name, name) == 0) {
-                if (found) *found = true;
-                return cur->type;
-            }
+        Symbol *cur = find(t, name);
+        if (cur) {
+            if (found) *found = true;
+            return cur->type;
         }
     }
     return TY_INVALID;
@@ -1,43 +1,260 @@
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "syntax_analyzer.h"
+#include "parse_context.h"
+#include "parser_rd.h"
+#include "lexer.h"
+#include "token_stream.h"
+#include "parser.tab.h"
 #include "ast.h"
+#include "arena.h"
+#include "ast_compact.h"
+#include "ast_hashcons.h"
+#include "ast_cache.h"
 
-extern int yyparse(void);
-extern FILE *yyin;
-extern int yylex_destroy(void);
-extern Node *g_program_ast;
-extern int g_parse_errors;
+void syntax_result_free(SyntaxResult *r) {
+    if (r->arena) arena_free(r->arena);   /* todos os nós de uma vez */
+    else if (r->ast) ast_free(r->ast);
+    cast_free(r->compact);
+    hashcons_free(r->hashcons);
+    str_pool_free(r->strings);
+    r->ast = NULL;
+    r->strings = NULL;
+    r->arena = NULL;
+    r->compact = NULL;
+    r->hashcons = NULL;
+}
+
+Node *syntax_result_ast(SyntaxResult *r) {
+    if (!r->ast && r->compact) {
+        if (!r->arena) r->arena = arena_new();
+        Arena *prev = ast_set_arena(r->arena);
+        r->ast = cast_to_node(r->compact, r->compact->root);
+        ast_set_arena(prev);
+    }
+    return r->ast;
+}
+
+bool syntax_use_compact(void) {
+    const char *env = getenv("ASTEROIDS_AST");
+    return env && strcmp(env, "compact") == 0;
+}
+
+bool syntax_use_shared(void) {
+    const char *env = getenv("ASTEROIDS_AST");
+    return env && strcmp(env, "shared") == 0;
+}
+
+ParserKind syntax_default_parser(void) {
+    const char *env = getenv("ASTEROIDS_PARSER");
+    if (env && strcmp(env, "bison") == 0) return PARSER_BISON;
+    return PARSER_RD;
+}
+
+const char *syntax_parser_name(ParserKind kind) {
+    return kind == PARSER_BISON ? "bison" : "rd";
+}
+
+/* Roda o parser sobre um contexto já preparado (fonte e/ou tokens) */
+static SyntaxResult run_parser_with(ParseContext *ctx, ParserKind kind) {
+    SyntaxResult r = { .parse_ok = 0, .parse_errors = 0, .ast = NULL, .strings = NULL, .arena = NULL, .compact = NULL, .hashcons = NULL };
+
+    /* Os nós da AST (e os nós descartados na recuperação de erros)
+     * ficam na arena, liberada de uma vez em syntax_result_free */
+    ctx->strings = str_pool_new();
+    r.arena = arena_new();
+    Arena *prev = ast_set_arena(r.arena);
+
+    /* Expressões iguais viram um nó só, na mesma arena */
+    HashCons *prev_hc = NULL;
+    if (syntax_use_shared()) {
+        r.hashcons = hashcons_new(r.arena);
+        prev_hc = ast_set_hashcons(r.hashcons);
+    }
+
+    int rc = 1;
+    if (lexer_open(ctx)) {
+        rc = kind == PARSER_BISON ? yyparse(ctx) : rd_parse(ctx);
+        lexer_close(ctx);
+        parse_scratch_free(ctx);
+    }
+    ast_set_arena(prev);
+    if (r.hashcons) ast_set_hashcons(prev_hc);
+
+    r.parse_ok = (rc == 0 && ctx->errors == 0);
+    r.parse_errors = ctx->errors;
+    r.ast = ctx->ast;
+    r.strings = ctx->strings;
+    return r;
+}
+
+/* Modo compacto: cada instrução vai para a AST compacta e a arena
+ * temporária é esvaziada antes da próxima */
+typedef struct {
+    CompactAst *compact;
+    Arena      *scratch;
+} CompactSink;
+
+static bool compact_stmt(const RdStmt *st, void *user) {
+    CompactSink *sink = (CompactSink*)user;
+    cast_add_top(sink->compact, st->node);
+    arena_reset(sink->scratch);
+    return true;
+}
+
+static SyntaxResult run_parser_compact(ParseContext *ctx, ParserKind kind) {
+    SyntaxResult r = { .parse_ok = 0, .parse_errors = 0, .ast = NULL, .strings = NULL, .arena = NULL, .compact = NULL, .hashcons = NULL };
+
+    ctx->strings = str_pool_new();
+    CompactSink sink = { cast_new(ctx->strings), arena_new() };
+    Arena *prev = ast_set_arena(sink.scratch);
+
+    /* rd_parse_stmts precisa das posições dos tokens no fonte */
+    bool stream = kind == PARSER_RD && (ctx->lexer != LEXER_REPLAY || ctx->src.data);
+
+    int rc = 1;
+    if (lexer_open(ctx)) {
+        if (stream) {
+            rc = rd_parse_stmts(ctx, compact_stmt, &sink);
+        } else {
+            rc = kind == PARSER_BISON ? yyparse(ctx) : rd_parse(ctx);
+            if (rc == 0) {
+                Node *root = ctx->ast;
+                for (size_t i = 0; i < root->u.as_block.count; i++)
+                    cast_add_top(sink.compact, root->u.as_block.stmts[i]);
+            }
+        }
+        lexer_close(ctx);
+        parse_scratch_free(ctx);
+    }
+    ast_set_arena(prev);
+    arena_free(sink.scratch);
+
+    /* como na AST normal: análise abortada não tem árvore */
+    if (rc == 0) {
+        cast_finish(sink.compact);
+        r.compact = sink.compact;
+    } else {
+        cast_free(sink.compact);
+    }
+
+    r.parse_ok = (rc == 0 && ctx->errors == 0);
+    r.parse_errors = ctx->errors;
+    r.strings = ctx->strings;
+    return r;
+}
+
+static SyntaxResult run_parser(ParseContext *ctx) {
+    if (syntax_use_compact())
+        return run_parser_compact(ctx, syntax_default_parser());
+    return run_parser_with(ctx, syntax_default_parser());
+}
+
+/* Grava o cache de uma análise sem erros (a AST em Node é convertida
+ * para a compacta só para isso) */
+static void save_cache(const SyntaxResult *r, const char *path, uint64_t src_len, uint64_t src_hash) {
+    if (r->compact) {
+        (void)ast_cache_save(path, r->compact, r->strings, src_len, src_hash);
+    } else if (r->ast) {
+        CompactAst *c = cast_from_node(r->ast, r->strings);
+        (void)ast_cache_save(path, c, r->strings, src_len, src_hash);
+        cast_free(c);
+    }
+}
 
 SyntaxResult syntax_parse_path(const char *path) {
-    SyntaxResult r = { .parse_ok = 0, .parse_errors = 0, .ast = NULL };
+    SyntaxResult r = { .parse_ok = 0, .parse_errors = 0, .ast = NULL, .strings = NULL, .arena = NULL, .compact = NULL, .hashcons = NULL };
+
+    /* Todo o estado da análise fica neste contexto (nada global),
+     * então chamadas em threads diferentes não interferem entre si. */
+    ParseContext ctx;
+    memset(&ctx, 0, sizeof ctx);
+    ctx.lexer = lexer_default_kind();
 
-    if (path && strcmp(path, "--") != 0) {
-        yyin = fopen(path, "r");
-        if (!yyin) {
-            perror("Erro ao abrir arquivo");
+    /* O fonte inteiro fica em memória (mmap ou leitura única) e o scanner
+     * varre direto desse buffer, sem passar por FILE* / stdio. */
+    if (!source_open(&ctx.src, path)) return r;
+
+    /* Cache da AST ao lado do fonte (ASTEROIDS_AST_CACHE=1): com o mesmo
+     * conteúdo, a AST compacta gravada é mapeada e o parser nem roda */
+    char *cache = ast_cache_enabled() ? ast_cache_path(path) : NULL;
+    uint64_t src_hash = cache ? token_stream_hash(ctx.src.data, ctx.src.len) : 0;
+    if (cache) {
+        r.compact = ast_cache_load(cache, ctx.src.len, src_hash, &r.strings);
+        if (r.compact) {
+            r.parse_ok = 1;
+            free(cache);
+            source_close(&ctx.src);
             return r;
         }
-    } else {
-        yyin = stdin;
     }
 
-    g_program_ast = NULL;
-    g_parse_errors = 0;
+    /* Fonte grande: tokeniza em pedaços paralelos e o parser reproduz
+     * os tokens (mesmos tokens e diagnósticos do modo serial) */
+    int threads = token_stream_env_threads();
+    size_t min_chunk = token_stream_env_min_chunk();
+    if (threads > 1 && ctx.src.len >= 2 * min_chunk) {
+        ctx.tokens = token_stream_build_parallel(&ctx.src, ctx.lexer, threads, min_chunk);
+        if (ctx.tokens) ctx.lexer = LEXER_REPLAY;
+    }
 
-    int rc = yyparse();
+    r = run_parser(&ctx);
+    token_stream_free(ctx.tokens);
 
-    if (yyin && yyin != stdin) fclose(yyin);
+    if (cache && r.parse_ok && r.parse_errors == 0) save_cache(&r, cache, ctx.src.len, src_hash);
+    free(cache);
 
-    if (rc == 0 && g_parse_errors == 0) {
-        r.parse_ok = 1;
-        r.ast = g_program_ast;
-    } else {
-        r.parse_ok = 0;
-        r.ast = g_program_ast;
+    /* A AST só referencia nomes internados e o pool de literais: o buffer pode ser liberado */
+    source_close(&ctx.src);
+    return r;
+}
+
+SyntaxResult syntax_parse_tokens(const char *tok_path, const char *src_path) {
+    SyntaxResult r = { .parse_ok = 0, .parse_errors = 0, .ast = NULL, .strings = NULL, .arena = NULL, .compact = NULL, .hashcons = NULL };
+
+    ParseContext ctx;
+    memset(&ctx, 0, sizeof ctx);
+    ctx.lexer = LEXER_REPLAY;
+
+    /* Só o arquivo de tokens: o parser consome direto dele */
+    if (!src_path) {
+        ctx.tokens = token_stream_load(tok_path);
+        if (!ctx.tokens) return r;
+        r = run_parser(&ctx);
+        token_stream_free(ctx.tokens);
+        return r;
+    }
+
+    if (!source_open(&ctx.src, src_path)) return r;
+
+    /* Fonte inalterado: reaproveita os tokens gravados */
+    if (access(tok_path, R_OK) == 0) {
+        ctx.tokens = token_stream_load(tok_path);
+        if (ctx.tokens && !token_stream_matches(ctx.tokens, &ctx.src)) {
+            token_stream_free(ctx.tokens);
+            ctx.tokens = NULL;
+        }
     }
 
-    r.parse_errors = g_parse_errors;
+    /* Fonte novo ou alterado: tokeniza uma vez, grava e reproduz */
+    if (!ctx.tokens) {
+        ctx.tokens = token_stream_build(&ctx.src, lexer_default_kind());
+        if (ctx.tokens) (void)token_stream_save(ctx.tokens, tok_path);
+    }
 
-    yylex_destroy();
+    if (ctx.tokens) {
+        r = run_parser(&ctx);
+        token_stream_free(ctx.tokens);
+    }
+    source_close(&ctx.src);
     return r;
 }
+
+SyntaxResult syntax_parse_stream(struct TokenStream *tokens, ParserKind parser) {
+    ParseContext ctx;
+    memset(&ctx, 0, sizeof ctx);
+    ctx.lexer = LEXER_REPLAY;
+    ctx.tokens = tokens;
+    return run_parser_with(&ctx, parser);
+}
@@ -0,0 +1,532 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "token_stream.h"
+#include "lexer.h"
+#include "parser.tab.h"
+#include "ast_base.h"
+#include "intern.h"
+
+#define NO_INDEX UINT32_MAX
+
+uint64_t token_stream_hash(const char *data, size_t len) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/* =========================================================
+ * Construção (tokenização completa em memória)
+ * ========================================================= */
+
+typedef struct {
+    TokenRecord *data;
+    size_t len, cap;
+} RecordVec;
+
+static TokenRecord *record_push(RecordVec *v) {
+    if (v->len == v->cap) {
+        v->cap = v->cap ? v->cap * 2 : 1024;
+        TokenRecord *nd = (TokenRecord*)realloc(v->data, v->cap * sizeof(TokenRecord));
+        if (!nd) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+        v->data = nd;
+    }
+    TokenRecord *r = &v->data[v->len++];
+    memset(r, 0, sizeof *r);
+    return r;
+}
+
+/* Tabela de nomes do fluxo: cada nome internado recebe um índice denso */
+typedef struct {
+    const char **names;
+    size_t       count, cap;
+    uint32_t    *index;        /* intern_id -> índice em names (ou NO_INDEX) */
+    size_t       index_cap;
+} NameTable;
+
+static uint32_t names_add(NameTable *nt, const char *name) {
+    uint32_t id = intern_id(name);
+    if (id >= nt->index_cap) {
+        size_t nc = nt->index_cap ? nt->index_cap : 256;
+        while (nc <= id) nc *= 2;
+        nt->index = (uint32_t*)realloc(nt->index, nc * sizeof(uint32_t));
+        if (!nt->index) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+        for (size_t i = nt->index_cap; i < nc; i++) nt->index[i] = NO_INDEX;
+        nt->index_cap = nc;
+    }
+    if (nt->index[id] == NO_INDEX) {
+        if (nt->count == nt->cap) {
+            nt->cap = nt->cap ? nt->cap * 2 : 64;
+            nt->names = (const char**)realloc(nt->names, nt->cap * sizeof(char*));
+            if (!nt->names) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+        }
+        nt->index[id] = (uint32_t)nt->count;
+        nt->names[nt->count++] = name;
+    }
+    return nt->index[id];
+}
+
+static void push_float(double **floats, size_t *count, size_t *cap, double v) {
+    if (*count == *cap) {
+        *cap = *cap ? *cap * 2 : 64;
+        *floats = (double*)realloc(*floats, *cap * sizeof(double));
+        if (!*floats) { fprintf(stderr, "error: realloc failed\n"); exit(1); }
+    }
+    (*floats)[(*count)++] = v;
+}
+
+static TokenStream *stream_new(const SourceBuffer *src, RecordVec *recs, NameTable *nt,
+                               double *floats, size_t float_count) {
+    TokenStream *ts = (TokenStream*)xmalloc(sizeof(TokenStream));
+    memset(ts, 0, sizeof *ts);
+    ts->src_len  = src->len;
+    ts->owned_toks = recs->data;
+    ts->toks  = recs->data;
+    ts->count = recs->len;
+    ts->names = nt->names;
+    ts->name_count = nt->count;
+    ts->owned_floats = floats;
+    ts->floats = floats;
+    ts->float_count = float_count;
+
+    /* literais de string: o payload é a posição no próprio fonte */
+    ts->strings = src->data;
+    ts->strings_len = src->len;
+    free(nt->index);
+    return ts;
+}
+
+/* Tokeniza src inteiro (sem calcular o hash) */
+static TokenStream *build_range(const SourceBuffer *src, LexerKind kind) {
+    ParseContext ctx;
+    memset(&ctx, 0, sizeof ctx);
+    ctx.lexer = kind;
+    ctx.src = *src;
+    ctx.quiet = true;   /* erros léxicos são reportados na reprodução */
+    if (!lexer_open(&ctx)) return NULL;
+
+    RecordVec recs = {0};
+    NameTable nt = {0};
+    double *floats = NULL;
+    size_t float_count = 0, float_cap = 0;
+
+    YYSTYPE lval;
+    int tok;
+    while ((tok = lexer_next(&lval, &ctx)) != 0) {
+        TokenRecord *r = record_push(&recs);
+        const char *text = lexer_text(&ctx);
+        r->offset = (uint32_t)(text - src->data);
+        r->length = (uint32_t)lexer_leng(&ctx);
+        r->line   = (uint32_t)lexer_line(&ctx);
+        r->column = (uint32_t)ctx.column;
+        r->kind   = (uint16_t)tok;
+
+        switch (tok) {
+            case INT_LIT:    r->payload = (uint32_t)lval.intValue; break;
+            case BOOL_LIT:   r->payload = (uint32_t)lval.boolValue; break;
+            case STRING_LIT: r->payload = (uint32_t)(lval.slice.ptr - src->data); break;
+            case ERROR:      r->payload = (unsigned char)*text; break;
+            case IDENT:      r->payload = names_add(&nt, lval.name); break;
+            case FLOAT_LIT:
+                r->payload = (uint32_t)float_count;
+                push_float(&floats, &float_count, &float_cap, lval.floatValue);
+                break;
+            default: break;
+        }
+    }
+
+    /* registro final: posição no fim da entrada (ou o erro fatal) */
+    TokenRecord *last = record_push(&recs);
+    last->offset = (uint32_t)src->len;
+    last->line   = (uint32_t)(ctx.fatal_line ? ctx.fatal_line : lexer_line(&ctx));
+    last->column = (uint32_t)ctx.column;
+    last->kind   = ctx.fatal_line ? TOKSTREAM_FATAL : TOKSTREAM_EOF;
+
+    lexer_close(&ctx);
+    return stream_new(src, &recs, &nt, floats, float_count);
+}
+
+TokenStream *token_stream_build(const SourceBuffer *src, LexerKind kind) {
+    TokenStream *ts = build_range(src, kind);
+    if (ts) ts->src_hash = token_stream_hash(src->data, src->len);
+    return ts;
+}
+
+/* =========================================================
+ * Tokenização paralela
+ *   1) pré-varredura: acha quebras de linha fora de comentários e
+ *      strings perto de len/threads, len*2/threads, ...;
+ *   2) cada pedaço é tokenizado em uma thread (começa na coluna 1);
+ *   3) os registros são concatenados, deslocando posição, linha e os
+ *      índices de nomes/doubles de cada pedaço.
+ * ========================================================= */
+
+int token_stream_env_threads(void) {
+    const char *env = getenv("ASTEROIDS_LEX_THREADS");
+    return env ? atoi(env) : 0;
+}
+
+size_t token_stream_env_min_chunk(void) {
+    const char *env = getenv("ASTEROIDS_LEX_MIN_CHUNK");
+    long v = env ? atol(env) : 0;
+    return v > 0 ? (size_t)v : TOKSTREAM_MIN_CHUNK;
+}
+
+/* Fim do literal de string que começa em s[i] ('"'), como a regex do
+ * scanner.l; 0 se não houver literal válido (o '"' vira ERROR). */
+static size_t prescan_string(const char *s, size_t i, size_t len) {
+    for (size_t j = i + 1; j < len; j++) {
+        if (s[j] == '"') return j + 1;
+        if (s[j] == '\\') {
+            if (j + 1 >= len || s[j + 1] == '\n') return 0;
+            j++;
+        }
+    }
+    return 0;
+}
+
+static size_t count_newlines(const char *s, size_t from, size_t to) {
+    size_t n = 0;
+    for (const char *p = s + from, *e = s + to;
+         (p = (const char*)memchr(p, '\n', (size_t)(e - p))) != NULL; p++) n++;
+    return n;
+}
+
+/* Preenche cuts[0..n] (cuts[0] = 0, cuts[n] = len) e a linha inicial de
+ * cada pedaço; devolve n (1 se não houver como dividir). */
+static size_t prescan_cuts(const char *s, size_t len, size_t parts, size_t min_chunk,
+                           size_t *cuts, uint32_t *first_line) {
+    size_t n = 0, nl = 0, i = 0;
+    cuts[0] = 0;
+    first_line[0] = 1;
+
+    while (i < len && n + 1 < parts) {
+        size_t target = len / parts * (n + 1);
+        if (target < cuts[n] + min_chunk) target = cuts[n] + min_chunk;
+        if (target >= len) break;
+
+        char c = s[i];
+        if (c == '\n') {
+            nl++;
+            i++;
+            if (i >= target && len - i >= min_chunk) {
+                cuts[++n] = i;
+                first_line[n] = (uint32_t)(nl + 1);
+            }
+        } else if (c == '/' && i + 1 < len && s[i + 1] == '/') {
+            const char *q = (const char*)memchr(s + i, '\n', len - i);
+            i = q ? (size_t)(q - s) : len;
+        } else if (c == '/' && i + 1 < len && s[i + 1] == '*') {
+            size_t j = i + 2;
+            while (j + 1 < len && !(s[j] == '*' && s[j + 1] == '/')) j++;
+            j = (j + 1 < len) ? j + 2 : len;
+            nl += count_newlines(s, i, j);
+            i = j;
+        } else if (c == '"') {
+            size_t j = prescan_string(s, i, len);
+            if (j) { nl += count_newlines(s, i, j); i = j; }
+            else   i++;
+        } else {
+            i++;
+        }
+    }
+
+    cuts[++n] = len;
+    return n;
+}
+
+typedef struct {
+    SourceBuffer view;     /* pedaço do fonte */
+    char        *copy;     /* cópia com os dois '\0' (Flex) */
+    LexerKind    kind;
+    TokenStream *ts;
+} ChunkJob;
+
+static void *chunk_worker(void *arg) {
+    ChunkJob *job = (ChunkJob*)arg;
+    job->ts = build_range(&job->view, job->kind);
+    return NULL;
+}
+
+TokenStream *token_stream_build_parallel(const SourceBuffer *src, LexerKind kind,
+                                         int threads, size_t min_chunk) {
+    if (threads < 2) return token_stream_build(src, kind);
+
+    size_t parts = (size_t)threads;
+    size_t *cuts = (size_t*)xmalloc((parts + 1) * sizeof(size_t));
+    uint32_t *first_line = (uint32_t*)xmalloc((parts + 1) * sizeof(uint32_t));
+    size_t n = prescan_cuts(src->data, src->len, parts, min_chunk ? min_chunk : 1, cuts, first_line);
+
+    if (n < 2) {
+        free(cuts);
+        free(first_line);
+        return token_stream_build(src, kind);
+    }
+
+    ChunkJob *jobs = (ChunkJob*)xmalloc(n * sizeof(ChunkJob));
+    pthread_t *tids = (pthread_t*)xmalloc(n * sizeof(pthread_t));
+    for (size_t k = 0; k < n; k++) {
+        ChunkJob *job = &jobs[k];
+        size_t len = cuts[k + 1] - cuts[k];
+        memset(job, 0, sizeof *job);
+        job->kind = kind;
+        job->view.len = len;
+        if (kind == LEXER_FAST) {
+            /* o lexer escrito à mão respeita o fim do pedaço: sem cópia */
+            job->view.data = src->data + cuts[k];
+        } else {
+            /* o Flex precisa de dois '\0' logo após o fim do buffer */
+            job->copy = (char*)xmalloc(len + 2);
+            memcpy(job->copy, src->data + cuts[k], len);
+            job->copy[len] = job->copy[len + 1] = '\0';
+            job->view.data = job->copy;
+        }
+    }
+
+    /* o pedaço 0 roda nesta thread */
+    size_t started = 1;
+    for (size_t k = 1; k < n; k++, started++)
+        if (pthread_create(&tids[k], NULL, chunk_worker, &jobs[k]) != 0) break;
+    chunk_worker(&jobs[0]);
+    for (size_t k = started; k < n; k++) chunk_worker(&jobs[k]);  /* se faltou thread */
+    for (size_t k = 1; k < started; k++) pthread_join(tids[k], NULL);
+
+    /* ---------- costura ---------- */
+    RecordVec recs = {0};
+    NameTable nt = {0};
+    double *floats = NULL;
+    size_t float_count = 0, float_cap = 0;
+    bool ok = true;
+
+    for (size_t k = 0; k < n && ok; k++) {
+        const TokenStream *c = jobs[k].ts;
+        if (!c) { ok = false; break; }
+
+        uint32_t *remap = (uint32_t*)xmalloc((c->name_count ? c->name_count : 1) * sizeof(uint32_t));
+        for (size_t i = 0; i < c->name_count; i++) remap[i] = names_add(&nt, c->names[i]);
+        uint32_t float_base = (uint32_t)float_count;
+        for (size_t i = 0; i < c->float_count; i++)
+            push_float(&floats, &float_count, &float_cap, c->floats[i]);
+
+        /* o registro final de cada pedaço só vale para o último */
+        size_t count = (k + 1 < n) ? c->count - 1 : c->count;
+        for (size_t i = 0; i < count; i++) {
+            TokenRecord *r = record_push(&recs);
+            *r = c->toks[i];
+            r->offset += (uint32_t)cuts[k];
+            r->line   += first_line[k] - 1;
+            switch (r->kind) {
+                case IDENT:      r->payload = remap[r->payload]; break;
+                case FLOAT_LIT:  r->payload += float_base; break;
+                case STRING_LIT: r->payload += (uint32_t)cuts[k]; break;
+                default: break;
+            }
+        }
+        free(remap);
+    }
+
+    for (size_t k = 0; k < n; k++) {
+        token_stream_free(jobs[k].ts);
+        free(jobs[k].copy);
+    }
+    free(jobs);
+    free(tids);
+    free(cuts);
+    free(first_line);
+
+    if (!ok) {
+        free(recs.data);
+        free(nt.names);
+        free(nt.index);
+        free(floats);
+        return NULL;
+    }
+
+    TokenStream *ts = stream_new(src, &recs, &nt, floats, float_count);
+    ts->src_hash = token_stream_hash(src->data, src->len);
+    return ts;
+}
+
+/* =========================================================
+ * Gravação / leitura
+ * ========================================================= */
+
+bool token_stream_save(const TokenStream *ts, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror("Erro ao gravar tokens"); return false; }
+
+    /* Na gravação, a área de strings fica compacta: só o conteúdo dos
+     * literais, e o payload passa a ser a posição nessa área. */
+    size_t strings_bytes = 0, names_bytes = 0;
+    for (size_t i = 0; i < ts->count; i++)
+        if (ts->toks[i].kind == STRING_LIT) strings_bytes += ts->toks[i].length - 2;
+    for (size_t i = 0; i < ts->name_count; i++)
+        names_bytes += sizeof(uint32_t) + intern_len(ts->names[i]);
+
+    TokenFileHeader h;
+    memset(&h, 0, sizeof h);
+    h.magic = TOKEN_FILE_MAGIC;
+    h.version = TOKEN_FILE_VERSION;
+    h.src_len = ts->src_len;
+    h.src_hash = ts->src_hash;
+    h.token_count = (uint32_t)ts->count;
+    h.name_count = (uint32_t)ts->name_count;
+    h.names_bytes = (uint32_t)names_bytes;
+    h.strings_bytes = (uint32_t)strings_bytes;
+    h.float_count = (uint32_t)ts->float_count;
+
+    bool ok = fwrite(&h, sizeof h, 1, f) == 1;
+
+    uint32_t spos = 0;
+    for (size_t i = 0; ok && i < ts->count; i++) {
+        TokenRecord r = ts->toks[i];
+        if (r.kind == STRING_LIT) {
+            r.payload = spos;
+            spos += r.length - 2;
+        }
+        ok = fwrite(&r, sizeof r, 1, f) == 1;
+    }
+    if (ok && ts->float_count)
+        ok = fwrite(ts->floats, sizeof(double), ts->float_count, f) == ts->float_count;
+    for (size_t i = 0; ok && i < ts->name_count; i++) {
+        uint32_t n = (uint32_t)intern_len(ts->names[i]);
+        ok = fwrite(&n, sizeof n, 1, f) == 1 && fwrite(ts->names[i], 1, n, f) == n;
+    }
+    for (size_t i = 0; ok && i < ts->count; i++) {
+        const TokenRecord *r = &ts->toks[i];
+        if (r->kind != STRING_LIT) continue;
+        size_t n = r->length - 2;
+        ok = fwrite(ts->strings + r->payload, 1, n, f) == n;
+    }
+
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Erro ao gravar tokens: %s\n", path);
+    return ok;
+}
+
+TokenStream *token_stream_load(const char *path) {
+    TokenStream *ts = (TokenStream*)xmalloc(sizeof(TokenStream));
+    memset(ts, 0, sizeof *ts);
+    if (!source_open(&ts->file, path)) { free(ts); return NULL; }
+
+    const char *base = ts->file.data;
+    size_t size = ts->file.len;
+    TokenFileHeader h;
+
+    if (size < sizeof h) goto invalid;
+    memcpy(&h, base, sizeof h);
+    if (h.magic != TOKEN_FILE_MAGIC || h.version != TOKEN_FILE_VERSION) goto invalid;
+    if (h.token_count == 0) goto invalid;
+
+    size_t toks_end = sizeof h + (size_t)h.token_count * sizeof(TokenRecord);
+    size_t floats_end = toks_end + (size_t)h.float_count * sizeof(double);
+    size_t names_end = floats_end + h.names_bytes;
+    if (names_end + h.strings_bytes != size) goto invalid;
+
+    /* o cabeçalho tem 48 bytes, cada registro 24 e o mmap/malloc é
+     * alinhado: registros e doubles podem ser lidos direto do arquivo */
+    ts->toks = (const TokenRecord*)(base + sizeof h);
+    ts->count = h.token_count;
+    ts->floats = (const double*)(base + toks_end);
+    ts->float_count = h.float_count;
+    ts->src_len = h.src_len;
+    ts->src_hash = h.src_hash;
+    ts->strings = base + names_end;
+    ts->strings_len = h.strings_bytes;
+
+    uint16_t last = ts->toks[ts->count - 1].kind;
+    if (last != TOKSTREAM_EOF && last != TOKSTREAM_FATAL) goto invalid;
+
+    ts->names = (const char**)xmalloc((h.name_count ? h.name_count : 1) * sizeof(char*));
+    ts->name_count = h.name_count;
+    const char *p = base + floats_end;
+    for (uint32_t i = 0; i < h.name_count; i++) {
+        uint32_t n;
+        if ((size_t)(base + names_end - p) < sizeof n) goto invalid;
+        memcpy(&n, p, sizeof n);
+        p += sizeof n;
+        if ((size_t)(base + names_end - p) < n) goto invalid;
+        ts->names[i] = intern(p, n);
+        p += n;
+    }
+
+    for (size_t i = 0; i < ts->count; i++) {
+        const TokenRecord *r = &ts->toks[i];
+        if (r->kind == IDENT && r->payload >= ts->name_count) goto invalid;
+        if (r->kind == FLOAT_LIT && r->payload >= ts->float_count) goto invalid;
+        if (r->kind == STRING_LIT &&
+            (r->length < 2 || r->payload + (r->length - 2) > ts->strings_len)) goto invalid;
+    }
+    return ts;
+
+invalid:
+    fprintf(stderr, "Arquivo de tokens inválido: %s\n", path);
+    token_stream_free(ts);
+    return NULL;
+}
+
+bool token_stream_matches(const TokenStream *ts, const SourceBuffer *src) {
+    return ts->src_len == src->len &&
+           ts->src_hash == token_stream_hash(src->data, src->len);
+}
+
+void token_stream_free(TokenStream *ts) {
+    if (!ts) return;
+    free((void*)ts->names);
+    free(ts->owned_toks);
+    free(ts->owned_floats);
+    source_close(&ts->file);
+    free(ts);
+}
+
+/* =========================================================
+ * Reprodução: entrega os tokens gravados como se fosse o lexer
+ * ========================================================= */
+
+int token_stream_next(YYSTYPE *lval, ParseContext *ctx) {
+    const TokenStream *ts = ctx->tokens;
+    size_t pos = ctx->tok_pos;
+    const TokenRecord *r = &ts->toks[pos];
+
+    /* o último registro (EOF/FATAL) não avança: o parser pode pedir de novo */
+    ctx->tok_last = pos;
+    if (pos + 1 < ts->count) ctx->tok_pos = pos + 1;
+
+    switch (r->kind) {
+        case TOKSTREAM_EOF:
+            ctx->column = (int)r->column;
+            return 0;
+        case TOKSTREAM_FATAL:
+            ctx->column = (int)r->column;
+            lexer_unclosed_comment(ctx, (int)r->line);
+            return 0;
+        case INT_LIT:   lval->intValue = (int)r->payload; break;
+        case BOOL_LIT:  lval->boolValue = (int)r->payload; break;
+        case FLOAT_LIT: lval->floatValue = ts->floats[r->payload]; break;
+        case IDENT:     lval->name = ts->names[r->payload]; break;
+        case STRING_LIT:
+            lval->slice.ptr = ts->strings + r->payload;
+            lval->slice.len = r->length - 2;
+            break;
+        case ERROR: {
+            /* mesma mensagem e posição do lexer (coluna antes do caractere) */
+            char msg[160];
+            snprintf(msg, sizeof msg, "caractere não reconhecido '%c'", (char)r->payload);
+            ctx->column = (int)r->column - (int)r->length;
+            yyerror(ctx, msg);
+            break;
+        }
+        default: break;
+    }
+
+    ctx->column = (int)r->column;
+    return (int)r->kind;
+}
+
+const TokenRecord *token_stream_current(const ParseContext *ctx) {
+    return &ctx->tokens->toks[ctx->tok_last];
+}
@@ -0,0 +1,110 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "work_pool.h"
+#include "ast_base.h"
+
+/* Trecho de tarefas de uma thread: [lo, hi). O dono pega em lo, os
+ * ladrões tiram do fim; um mutex por trecho (sem disputa no caso comum) */
+typedef struct {
+    pthread_mutex_t lock;
+    size_t          lo, hi;
+} TaskRange;
+
+typedef struct {
+    TaskRange   *ranges;
+    size_t       count;     /* threads */
+    WorkPoolTask run;
+    WorkPoolExit worker_exit;
+    void        *ctx;
+} Pool;
+
+typedef struct {
+    Pool  *pool;
+    size_t self;
+} Worker;
+
+static bool take_own(TaskRange *r, size_t *task) {
+    pthread_mutex_lock(&r->lock);
+    bool ok = r->lo < r->hi;
+    if (ok) *task = r->lo++;
+    pthread_mutex_unlock(&r->lock);
+    return ok;
+}
+
+/* Rouba a metade final do trecho de outra thread para o próprio (que
+ * está vazio); false se nenhuma tem trabalho */
+static bool steal(Pool *p, size_t self) {
+    for (size_t k = 1; k < p->count; k++) {
+        TaskRange *victim = &p->ranges[(self + k) % p->count];
+        size_t lo = 0, hi = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->lo < victim->hi) {
+            size_t left = victim->hi - victim->lo;
+            hi = victim->hi;
+            lo = hi - (left + 1) / 2;
+            victim->hi = lo;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (lo < hi) {
+            TaskRange *own = &p->ranges[self];
+            pthread_mutex_lock(&own->lock);
+            own->lo = lo;
+            own->hi = hi;
+            pthread_mutex_unlock(&own->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = (Worker*)arg;
+    Pool *p = w->pool;
+    size_t task;
+
+    do {
+        while (take_own(&p->ranges[w->self], &task)) p->run(p->ctx, task);
+    } while (steal(p, w->self));
+
+    if (p->worker_exit) p->worker_exit(p->ctx);
+    return NULL;
+}
+
+void work_pool_run(size_t count, int threads,
+                   WorkPoolTask run, WorkPoolExit worker_exit, void *ctx) {
+    if (count == 0) return;
+    size_t n = threads > 1 ? (size_t)threads : 1;
+    if (n > count) n = count;
+
+    if (n == 1) {
+        for (size_t i = 0; i < count; i++) run(ctx, i);
+        if (worker_exit) worker_exit(ctx);
+        return;
+    }
+
+    Pool pool = { (TaskRange*)xmalloc(n * sizeof(TaskRange)), n, run, worker_exit, ctx };
+    Worker *workers = (Worker*)xmalloc(n * sizeof(Worker));
+    pthread_t *tids = (pthread_t*)xmalloc(n * sizeof(pthread_t));
+
+    for (size_t k = 0; k < n; k++) {
+        pthread_mutex_init(&pool.ranges[k].lock, NULL);
+        pool.ranges[k].lo = count / n * k + (k < count % n ? k : count % n);
+        pool.ranges[k].hi = pool.ranges[k].lo + count / n + (k < count % n ? 1 : 0);
+        workers[k] = (Worker){ &pool, k };
+    }
+
+    /* a thread 0 é esta; se faltar thread, o trecho dela é roubado */
+    size_t started = 1;
+    for (size_t k = 1; k < n; k++, started++)
+        if (pthread_create(&tids[k], NULL, worker_main, &workers[k]) != 0) break;
+    worker_main(&workers[0]);
+    for (size_t k = 1; k < started; k++) pthread_join(tids[k], NULL);
+
+    for (size_t k = 0; k < n; k++) pthread_mutex_destroy(&pool.ranges[k].lock);
+    free(pool.ranges);
+    free(workers);
+    free(tids);
+}
@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+# Fluxo de tokens (token_stream.h): `scanner --dump` seguido de
+# `parser --tokens` dá a mesma saída que o parser lendo o fonte; arquivos
+# truncados ou corrompidos são recusados (e, com o fonte, tokenizados de novo).
+set -u -o pipefail
+
+SRC="$ROOT_DIR/src"
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+status=0
+
+for f in "$ROOT_DIR"/tests/syntax/ok/ok_*.in "$ROOT_DIR"/tests/syntax/err/err_*.in \
+         "$ROOT_DIR"/tests/generation/ok/ok_*.in; do
+  name="$(basename "${f%.in}")"
+  "$SRC/scanner" --dump "$TMP/$name.tok" "$f" > /dev/null 2>&1
+  direct="$("$SRC/parser" "$f" 2>&1)"; direct_rc=$?
+  replay="$("$SRC/parser" --tokens "$TMP/$name.tok" 2>&1)"; replay_rc=$?
+  if [[ $direct_rc -ne $replay_rc || "$direct" != "$replay" ]]; then
+    echo "$name: reprodução dos tokens divergiu da análise direta"
+    diff <(printf "%s\n" "$direct") <(printf "%s\n" "$replay")
+    status=1
+  fi
+done
+
+# Um arquivo de tokens válido como base para as corrupções
+printf 'a = b + 1;\n' > "$TMP/src.in"
+"$SRC/scanner" --dump "$TMP/good.tok" "$TMP/src.in" > /dev/null 2>&1 || { echo "dump falhou"; exit 1; }
+size=$(wc -c < "$TMP/good.tok")
+
+head -c $((size - 1)) "$TMP/good.tok" > "$TMP/truncated.tok"
+head -c 10 "$TMP/good.tok" > "$TMP/header.tok"
+cp "$TMP/good.tok" "$TMP/magic.tok"
+printf 'X' | dd of="$TMP/magic.tok" bs=1 seek=0 conv=notrunc 2>/dev/null
+# payload do 1º registro (IDENT `a`): cabeçalho de 48 bytes + 20
+cp "$TMP/good.tok" "$TMP/name.tok"
+printf '\377\377\377\377' | dd of="$TMP/name.tok" bs=1 seek=68 conv=notrunc 2>/dev/null
+
+direct="$("$SRC/parser" "$TMP/src.in" 2>&1)"
+for bad in truncated header magic name; do
+  out="$("$SRC/parser" --tokens "$TMP/$bad.tok" 2>&1)"; rc=$?
+  if [[ $rc -eq 0 || $rc -ge 128 || "$out" != *"Arquivo de tokens inválido"* ]]; then
+    echo "$bad.tok: deveria ser recusado (retorno $rc)"
+    echo "$out"
+    status=1
+  fi
+
+  # com o fonte ao lado, o arquivo inválido é refeito a partir dele
+  out="$("$SRC/parser" --tokens "$TMP/$bad.tok" "$TMP/src.in" 2>/dev/null)"; rc=$?
+  if [[ $rc -ne 0 || "$out" != "$direct" ]]; then
+    echo "$bad.tok: com o fonte, deveria tokenizar de novo (retorno $rc)"
+    status=1
+  fi
+done
+
+exit $status
@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+# Reanálise incremental (incremental.h): depois de cada sequência de
+# edições, `parser --edit ...` dá a mesma AST, o mesmo resultado e a
+# mesma contagem de erros que o parser lendo o texto final do zero.
+set -u -o pipefail
+export LC_ALL=C
+
+SRC="$ROOT_DIR/src"
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+status=0
+
+# check NOME TEXTO_INICIAL EDIÇÃO... (cada edição: pos:removidos:texto)
+check() {
+  local name="$1" text="$2"; shift 2
+  printf "%s" "$text" > "$TMP/$name.in"
+
+  local final="$text" e off rest removed ins
+  local args=()
+  for e in "$@"; do
+    off="${e%%:*}"; rest="${e#*:}"
+    removed="${rest%%:*}"; ins="${rest#*:}"
+    final="${final:0:off}${ins}${final:off+removed}"
+    args+=(--edit "$e")
+  done
+  printf "%s" "$final" > "$TMP/$name.final"
+
+  local direct incr direct_rc incr_rc
+  direct="$("$SRC/parser" "$TMP/$name.final" 2>"$TMP/$name.direct.err")"; direct_rc=$?
+  incr="$("$SRC/parser" "${args[@]}" "$TMP/$name.in" 2>"$TMP/$name.incr.err")"; incr_rc=$?
+  if [[ $direct_rc -ne $incr_rc || "$direct" != "$incr" ]]; then
+    echo "$name: reanálise incremental (retorno $incr_rc) divergiu da completa (retorno $direct_rc)"
+    diff <(printf "%s\n" "$direct") <(printf "%s\n" "$incr")
+    status=1
+  fi
+
+  # a análise completa imprime um erro por linha; a incremental, só o total
+  local direct_errors incr_errors
+  direct_errors="$(grep -c '^Erro ' "$TMP/$name.direct.err")"
+  incr_errors="$(sed -n 's/^\([0-9]*\) erro(s).*/\1/p' "$TMP/$name.incr.err")"
+  if [[ "${incr_errors:-0}" -ne "$direct_errors" ]]; then
+    echo "$name: reanálise incremental contou ${incr_errors:-0} erro(s), a completa $direct_errors"
+    status=1
+  fi
+}
+
+prog=$'int a = 1;\nint f(int x) {\n  return x + a;\n}\nfloat g = 2.5;\nint b = f(3);\n'
+
+# texto vazio: nenhuma região antes da primeira edição
+check empty_insert '' '0:0:int x = 1;'
+check empty_twice '' '0:0:int x = 1;' '0:0:int y = 2;'
+check clear_all "$prog" "0:${#prog}:"
+check clear_refill "$prog" "0:${#prog}:" '0:0:bool t = true;'
+
+# edições no começo, no meio e no fim
+check insert_first "$prog" '0:0:int z = 0;'
+check insert_middle "$prog" '11:0:int m = 5;'
+check append "$prog" "${#prog}:0:int w = a;"
+check delete_first "$prog" '0:10:'
+check rename "$prog" '4:1:valor' '9:0:0'
+check body "$prog" '35:1:a * x'
+
+# a primeira reanálise para ao ressincronizar, com o scanner já adiante do
+# fim da instrução; a segunda passa por esse ponto do texto
+check resync_then_next $'int a = 1;\nint b = 2;\nint c = 3;\n' '8:1:5' '19:1:9'
+
+# erro sintático introduzido e corrigido em seguida
+check break_brace "$prog" '43:1:'
+check break_fix "$prog" '43:1:' '43:0:}'
+check open_comment "$prog" '11:0:/*'
+# a instrução cortada pelo comentário não soma um erro sintático ao fatal
+check open_comment_cut $'int a = 1;\nint b = 2;\n' '11:0:in /*'
+check open_comment_after_error $'int a = 1;\nint b = 2;\n' '0:0:int = ; in /*'
+check close_comment "$prog" '11:0:/*' '13:0:*/'
+
+exit $status
@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+# Entradas profundas: aninhamento além do limite do parser termina com
+# "memory exhausted" (nos dois parsers, como o YYMAXDEPTH do Bison), e uma
+# cadeia plana de 10^5 termos, cuja AST tem 10^5 níveis à esquerda, passa
+# pela análise, pelo IR e pelo JS com a pilha limitada a 1 MB (os percursos
+# são iterativos).
+set -u -o pipefail
+
+SRC="$ROOT_DIR/src"
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+status=0
+
+# repeat TEXTO N
+repeat() { local s; printf -v s "%*s" "$2" ""; printf "%s" "${s// /$1}"; }
+
+N=20000
+{ printf "int r = "; repeat "(" $N; printf "1"; repeat ")" $N; printf ";\n"; } > "$TMP/parens.in"
+{ printf "int r = "; repeat "- " $N; printf "1;\n"; } > "$TMP/unary.in"
+{ printf "void f() "; repeat "{" $N; repeat "}" $N; printf "\n"; } > "$TMP/blocks.in"
+{ printf "void f() { "; repeat "if (true) " $N; printf "return; }\n"; } > "$TMP/ifs.in"
+
+for name in parens unary blocks ifs; do
+  for parser in rd bison; do
+    for bin in parser analyzer irgen jsgen; do
+      out="$(ASTEROIDS_PARSER=$parser "$SRC/$bin" "$TMP/$name.in" 2>&1 >/dev/null)"; rc=$?
+      if [[ $rc -ne 1 || "$out" != *"memory exhausted"* ]]; then
+        echo "$name ($parser, $bin): esperado \"memory exhausted\" com retorno 1, veio retorno $rc"
+        printf "%s\n" "$out" | head -3
+        status=1
+      fi
+    done
+  done
+done
+
+# a + a + ... + a
+{ printf "int a = 1;\nint r = a"; repeat " + a" 99999; printf ";\n"; } > "$TMP/flat.in"
+for bin in analyzer irgen jsgen; do
+  ( ulimit -s 1024; "$SRC/$bin" "$TMP/flat.in" > "$TMP/flat.$bin" 2>&1 ); rc=$?
+  if [[ $rc -ne 0 ]]; then
+    echo "flat ($bin): retorno $rc"
+    head -3 "$TMP/flat.$bin"
+    status=1
+  fi
+done
+if ! grep -Eq "let r = (t[0-9]+ \+ a|100000);" "$TMP/flat.jsgen"; then
+  echo "flat (jsgen): última soma não encontrada"
+  tail -3 "$TMP/flat.jsgen"
+  status=1
+fi
+
+exit $status
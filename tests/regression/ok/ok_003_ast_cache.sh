@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+# Cache da AST (ast_cache.h): um cache válido é usado como está; um cache
+# corrompido (tipo, filho, nome ou lista fora do lugar) é recusado, o fonte
+# é analisado de novo com o mesmo resultado e o cache é regravado. Nenhuma
+# palavra corrompida derruba o parser.
+set -u -o pipefail
+
+SRC="$ROOT_DIR/src"
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+status=0
+
+cat > "$TMP/prog.in" <<'PROG'
+a;
+int a = 1;
+float f = 2.5;
+string s = "texto";
+int soma(int x, int y) {
+  if (x < y) { return x + y; } else { return -x; }
+}
+void laco() {
+  int i;
+  for (i = 0; i < 3; i = i + 1) { while (!false) { a = soma(i, a); } }
+}
+PROG
+CACHE="$TMP/prog.in.astc"
+
+run_cached() { ASTEROIDS_AST_CACHE=1 "$SRC/parser" "$TMP/prog.in" 2>&1; }
+u32() { od -An -tu4 -j "$2" -N4 "$1" | tr -d ' '; }
+# poke ARQUIVO POSIÇÃO VALOR: grava VALOR como uint32 little-endian
+poke() {
+  local v=$3
+  printf "$(printf '\\x%02x\\x%02x\\x%02x\\x%02x' $((v & 255)) $((v >> 8 & 255)) $((v >> 16 & 255)) $((v >> 24 & 255)))" \
+    | dd of="$1" bs=1 seek="$2" conv=notrunc 2>/dev/null
+}
+poke8() { printf "\\x$(printf '%02x' "$3")" | dd of="$1" bs=1 seek="$2" conv=notrunc 2>/dev/null; }
+
+expected="$("$SRC/parser" "$TMP/prog.in" 2>&1)" || { echo "análise sem cache falhou"; exit 1; }
+out="$(run_cached)"
+[[ -f "$CACHE" && "$out" == "$expected" ]] || { echo "cache não foi gravado"; exit 1; }
+cp "$CACHE" "$TMP/good.astc"
+
+# cache válido: mapeado, não regravado
+inode=$(stat -c %i "$CACHE")
+out="$(run_cached)"
+if [[ "$out" != "$expected" || $(stat -c %i "$CACHE") != "$inode" ]]; then
+  echo "cache válido não foi usado"
+  status=1
+fi
+
+# Layout (ast_cache.h): cabeçalho de 112 bytes, kind[] e data[] alinhados a 8
+HDR=112
+nodes=$(u32 "$TMP/good.astc" 28)
+root=$((nodes - 1))
+KIND=$HDR
+DATA=$((KIND + (nodes + 7) / 8 * 8))
+off=$((DATA + (nodes * 4 + 7) / 8 * 8))
+sizes=(4 8 8 8 12)   # lists, ints, floats, unary, binary
+for i in 0 1 2 3 4; do
+  c=$(u32 "$TMP/good.astc" $((52 + 4 * i)))
+  off=$((off + (c * ${sizes[$i]} + 7) / 8 * 8))
+done
+BLOCKS=$off
+blocks=$(u32 "$TMP/good.astc" $((52 + 4 * 5)))
+ROOT_LIST=$((BLOCKS + 8 * (blocks - 1)))   # o bloco da raiz é o último
+
+# expect_reparse NOME: prog.in.astc corrompido deve ser recusado e refeito
+expect_reparse() {
+  local out; out="$(run_cached)"; local rc=$?
+  if [[ $rc -ne 0 || "$out" != "$expected" ]]; then
+    echo "$1: cache corrompido deveria ser refeito (retorno $rc)"
+    status=1
+  elif ! cmp -s "$CACHE" "$TMP/good.astc"; then
+    echo "$1: cache corrompido não foi regravado"
+    status=1
+  fi
+}
+
+corrupt() { cp "$TMP/good.astc" "$CACHE"; }
+
+corrupt; poke8 "$CACHE" $KIND 255;                    expect_reparse "tipo inválido"
+corrupt; poke8 "$CACHE" $((KIND + root)) 0;           expect_reparse "raiz não é bloco"
+corrupt; poke "$CACHE" $((DATA + 4 * root)) 4000000;  expect_reparse "payload fora do array"
+corrupt; poke "$CACHE" $DATA 0;                       expect_reparse "filho aponta para o pai"
+corrupt; poke "$CACHE" $DATA $root;                   expect_reparse "filho é a raiz"
+corrupt; poke "$CACHE" $DATA 4294967295;              expect_reparse "filho obrigatório ausente"
+corrupt; poke "$CACHE" $((DATA + 4)) 99999;           expect_reparse "nome fora da tabela"
+corrupt; poke "$CACHE" $((ROOT_LIST + 4)) 65535;      expect_reparse "lista fora do array"
+corrupt; poke "$CACHE" $ROOT_LIST 4294967295;         expect_reparse "início de lista estourando"
+corrupt; poke "$CACHE" 32 $nodes;                     expect_reparse "raiz fora do intervalo"
+
+# qualquer palavra corrompida: o parser nunca cai nem falha
+size=$(wc -c < "$TMP/good.astc")
+for ((pos = HDR; pos + 4 <= size; pos += 4)); do
+  for v in 4294967295 1; do
+    corrupt; poke "$CACHE" $pos $v
+    run_cached > /dev/null; rc=$?
+    if [[ $rc -ne 0 ]]; then
+      echo "palavra em $pos = $v: retorno $rc"
+      status=1
+    fi
+  done
+done
+
+exit $status
@@ -1,9 +1,12 @@
 #!/usr/bin/env bash
 # Runner de testes — varre tests/*/{ok,err} e roda tudo em ordem fixa.
-# Suítes suportadas: lexer → syntax → semantic → intermediate → generation
+# Suítes suportadas: lexer → syntax → semantic → intermediate → generation → fold → effects → regression
 # Regras:
 #  - lexer: normaliza a saída do driver e compara tokens/mensagens com expected/
 #  - syntax: extrai "AST (Formatada)" e compara com .golden (se existir)
+#  - fold: IR gerado com ASTEROIDS_FOLD=1, comparado com .golden
+#  - effects: saída de `irgen --effects` (sem dobramento), comparada com .golden
+#  - regression: roda os cenários ok_*.sh (vários binários/arquivos); passa com retorno 0
 #  - semantic (e outras): valida apenas pelo exit code
 #
 # Uso:
@@ -32,6 +35,9 @@ EMOJI_SYNTAX="🧩"
 EMOJI_SEMANTIC="🧠"
 EMOJI_INTERMEDIATE="🏗️"
 EMOJI_GENERATION="⚙️"
+EMOJI_FOLD="📐"
+EMOJI_EFFECTS="💥"
+EMOJI_REGRESSION="🔁"
 EMOJI_DEFAULT="🧪"
 
 OK_EMOJI="🟢"
@@ -47,6 +53,9 @@ bin_for_suite() {
     semantic)           echo "${ROOT_DIR}/src/analyzer" ;;
     intermediate)       echo "${ROOT_DIR}/src/irgen" ;;
     generation) echo "${ROOT_DIR}/src/jsgen" ;;
+    fold)               echo "${ROOT_DIR}/src/irgen" ;;
+    effects)            echo "${ROOT_DIR}/src/irgen" ;;
+    regression)         echo "${ROOT_DIR}/src/parser" ;;
     *)                  echo "${ROOT_DIR}/src/parser" ;;
   esac
 }
@@ -68,6 +77,9 @@ suite_title() {
     semantic)           echo "${EMOJI_SEMANTIC}  ${BOLD}Semantic Analysis${RESET}" ;;
     intermediate)       echo "${EMOJI_INTERMEDIATE}  ${BOLD}Intermediate Representation${RESET}" ;;
     generation) echo "${EMOJI_GENERATION}  ${BOLD}Code Generation${RESET}" ;;
+    fold)               echo "${EMOJI_FOLD}  ${BOLD}Constant Folding (IR)${RESET}" ;;
+    effects)            echo "${EMOJI_EFFECTS}  ${BOLD}Function Effects (IR)${RESET}" ;;
+    regression)         echo "${EMOJI_REGRESSION}  ${BOLD}Regression Scenarios${RESET}" ;;
     *)                  echo "${EMOJI_DEFAULT}  ${BOLD}${raw^}${RESET}" ;;
   esac
 }
@@ -83,7 +95,7 @@ extract_pretty() {
 suite_has_files() {
   local ok_dir="$1" err_dir="$2"
   shopt -s nullglob
-  local ok_files=( "$ok_dir"/ok_*.in )
+  local ok_files=( "$ok_dir"/ok_*.in "$ok_dir"/ok_*.sh )
   local err_files=( "$err_dir"/err_*.in )
   [[ ${#ok_files[@]} -gt 0 || ${#err_files[@]} -gt 0 ]]
 }
@@ -282,6 +294,63 @@ run_err_case_generation() {
   fi
 }
 
+# ------------------------------------------------------------------------------
+# Casos de IR comparados com .golden (fold: sempre com o dobramento ligado;
+# effects: o resumo de efeitos, sempre sem dobramento)
+# ------------------------------------------------------------------------------
+run_ir_bin() {
+  case "$CURRENT_SUITE" in
+    fold)    ASTEROIDS_FOLD=1 "$BIN" "$1" ;;
+    effects) env -u ASTEROIDS_FOLD "$BIN" --effects "$1" ;;
+    *)       "$BIN" "$1" ;;
+  esac
+}
+
+run_ok_case_ir() {
+  local file="$1"                        # tests/{fold,effects}/ok/ok_*.in
+  local base; base="$(basename "$file")" # ok_*.in
+  local golden="${file%.in}.golden"
+
+  local out; out="$(run_ir_bin "$file" 2>&1)"
+  local status=$?
+
+  if [[ $status -ne 0 ]]; then
+    printf "%b %s%s%s (esperado sucesso) → retorno %d\n" "$ERR_EMOJI" "$RED" "$base" "$RESET" "$status"
+    echo "$out"
+    ((fail++)); return
+  fi
+
+  if diff -u --strip-trailing-cr <(sed -e '$a\' "$golden") <(printf "%s\n" "$out") > /tmp/diff.$$ 2>&1; then
+    printf "%b %s%s%s (IR bateu com .golden)\n" "$OK_EMOJI" "$GREEN" "$base" "$RESET"
+    ((pass++))
+  else
+    printf "%b %s%s%s (IR divergente do .golden)\n" "$ERR_EMOJI" "$RED" "$base" "$RESET"
+    cat /tmp/diff.$$
+    ((fail++))
+  fi
+  rm -f /tmp/diff.$$ || true
+}
+
+# ------------------------------------------------------------------------------
+# Cenários de regressão — cada ok_*.sh usa os binários em $ROOT_DIR/src
+# ------------------------------------------------------------------------------
+run_ok_case_script() {
+  local file="$1"                        # tests/regression/ok/ok_*.sh
+  local base; base="$(basename "$file")" # ok_*.sh
+
+  local out; out="$(ROOT_DIR="$ROOT_DIR" bash "$file" 2>&1)"
+  local status=$?
+
+  if [[ $status -eq 0 ]]; then
+    printf "%b %s%s%s (Passou como esperado)\n" "$OK_EMOJI" "$GREEN" "$base" "$RESET"
+    ((pass++))
+  else
+    printf "%b %s%s%s (cenário falhou) → retorno %d\n" "$ERR_EMOJI" "$RED" "$base" "$RESET" "$status"
+    echo "$out"
+    ((fail++))
+  fi
+}
+
 # ------------------------------------------------------------------------------
 # Execução de uma suíte
 # ------------------------------------------------------------------------------
@@ -326,6 +395,24 @@ run_suite() {
     return
   fi
 
+  # IR com .golden, sem casos ERR
+  if [[ "$CURRENT_SUITE" == "fold" || "$CURRENT_SUITE" == "effects" ]]; then
+    for f in "$ok_dir"/ok_*.in; do
+      [[ -e "$f" ]] || break
+      run_ok_case_ir "$f"
+    done
+    return
+  fi
+
+  # Cenários: scripts, sem casos ERR
+  if [[ "$CURRENT_SUITE" == "regression" ]]; then
+    for f in "$ok_dir"/ok_*.sh; do
+      [[ -e "$f" ]] || break
+      run_ok_case_script "$f"
+    done
+    return
+  fi
+
   # Geração (JS): usa .golden
   if [[ "$CURRENT_SUITE" == "generation" ]]; then
     for f in "$ok_dir"/ok_*.in; do
@@ -364,7 +451,7 @@ echo "${BOLD}Executando testes…${RESET}"
 if [[ $# -gt 0 ]]; then
   ordered_suites=("$@")
 else
-  ordered_suites=(lexer syntax semantic intermediate generation)
+  ordered_suites=(lexer syntax semantic intermediate generation fold effects regression)
 fi
 
 for suite_name in "${ordered_suites[@]}"; do